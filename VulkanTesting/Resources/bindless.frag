@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 1, binding = 0) uniform texture2D bindlessTextures[];
+layout(set = 1, binding = 2) uniform sampler bindlessSamplers[];
+
+// After the DrawData of instanced.vert
+layout(push_constant) uniform BindlessIndices {
+    layout(offset = 16) uint textureIndex;
+    uint samplerIndex;
+    uint bufferIndex;
+} indices;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec4 albedo = texture(sampler2D(bindlessTextures[indices.textureIndex], bindlessSamplers[indices.samplerIndex]), fragTexCoord);
+    outColor = vec4(fragColor, 1.0) * albedo;
+}
\ No newline at end of file
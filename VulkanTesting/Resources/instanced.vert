@@ -0,0 +1,32 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 2) in mat4 inTransform;
+layout(location = 6) in vec3 inInstanceColor;
+
+layout(set = 0, binding = 0) uniform FrameData {
+    mat4 viewProjection;
+} frame;
+
+layout(push_constant) uniform DrawData {
+    vec4 tint;
+} draw;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+// The depth pre-pass and the scene pass test with equal, both must get bit identical depth
+invariant gl_Position;
+
+void main() {
+    gl_Position = frame.viewProjection * inTransform * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor * inInstanceColor * draw.tint.rgb;
+    fragTexCoord = inPosition + 0.5;
+}
\ No newline at end of file
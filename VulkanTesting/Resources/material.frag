@@ -0,0 +1,38 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#ifdef FEATURE_TEXTURED
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 1, binding = 0) uniform texture2D bindlessTextures[];
+layout(set = 1, binding = 2) uniform sampler bindlessSamplers[];
+
+// See bindless.frag
+layout(push_constant) uniform BindlessIndices {
+    layout(offset = 16) uint textureIndex;
+    uint samplerIndex;
+    uint bufferIndex;
+} indices;
+
+layout(location = 1) in vec2 fragTexCoord;
+#endif
+
+layout(constant_id = 0) const float BRIGHTNESS = 1.0;
+
+layout(location = 0) in vec3 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec3 color = fragColor;
+
+#ifdef FEATURE_TEXTURED
+    color *= texture(sampler2D(bindlessTextures[indices.textureIndex], bindlessSamplers[indices.samplerIndex]), fragTexCoord).rgb;
+#endif
+
+#ifdef FEATURE_GRAYSCALE
+    color = vec3(dot(color, vec3(0.299, 0.587, 0.114)));
+#endif
+
+    outColor = vec4(color * BRIGHTNESS, 1.0);
+}
\ No newline at end of file
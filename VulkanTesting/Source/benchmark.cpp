@@ -0,0 +1,506 @@
+#include "benchmark.h"
+
+#include "renderer.h"
+#include "instancing.h"
+#include "culling.h"
+#include "mathlib.h"
+#include "rendergraph.h"
+#include "shader.h"
+#include "bufferallocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdlib.h>
+
+const uint32 BENCHMARK_OBJECT_COUNT = 100000;
+
+struct Timer
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	double GetMilliseconds() const
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		return elapsed.count();
+	}
+};
+
+static double SubmitAndWait(Renderer* renderer, vk::CommandBuffer commandBuffer, vk::Fence fence)
+{
+	vk::Device device = renderer->GetDevice();
+
+	vk::SubmitInfo submitInfo = {};
+	submitInfo.setCommandBufferCount(1);
+	submitInfo.setPCommandBuffers(&commandBuffer);
+
+	Timer timer;
+	renderer->GetGraphicsQueue().submit({ submitInfo }, fence);
+	device.waitForFences({ fence }, true, UINT64_MAX);
+	double result = timer.GetMilliseconds();
+
+	device.resetFences({ fence });
+	return result;
+}
+
+void RunInstancingBenchmark(Renderer* renderer, vk::RenderPass renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent, const Pipeline& pipeline, const Mesh& mesh)
+{
+	vk::Device device = renderer->GetDevice();
+
+	QueueFamilyIndicies queueIndicies = renderer->GetQueueFamilyIndicies();
+	vk::CommandPool commandPool = device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueIndicies.graphicsIndex), GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+	vk::CommandBuffer commandBuffer = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(commandPool, vk::CommandBufferLevel::ePrimary, 1))[0];
+	vk::Fence fence = device.createFence(vk::FenceCreateInfo(), GetAllocationCallbacks(vk::ObjectType::eFence));
+
+	std::vector<InstanceData> instances(BENCHMARK_OBJECT_COUNT);
+
+	uint32 gridSize = (uint32)ceil(sqrt((double)BENCHMARK_OBJECT_COUNT));
+	float cellSize = 2.0f / gridSize;
+	for (uint32 index = 0; index < BENCHMARK_OBJECT_COUNT; index++)
+	{
+		float x = -1.0f + cellSize * (index % gridSize + 0.5f);
+		float y = -1.0f + cellSize * (index / gridSize + 0.5f);
+
+		instances[index].transform = Matrix4f::Translation({ x, y, 0.0f }) * Matrix4f::Scale({ cellSize, cellSize, 1.0f });
+		instances[index].color = { 1.0f, 1.0f, 1.0f };
+	}
+
+	UniformAllocator* uniformAllocator = renderer->GetUniformAllocator();
+
+	FrameUniforms frameUniforms = {};
+	frameUniforms.viewProjection = Matrix4f::Identity();
+	UniformAllocation frameAllocation = uniformAllocator->Push(frameUniforms);
+
+	DrawPushConstants drawConstants = {};
+	drawConstants.tint = Vector4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+	vk::ClearValue clearColor(vk::ClearColorValue(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 1.0f }));
+	vk::RenderPassBeginInfo renderPassInfo(renderPass, framebuffer, vk::Rect2D(vk::Offset2D(), extent), 1, &clearColor);
+
+	// Individual draws, one draw call per object reading its instance data through firstInstance
+	Buffer instanceBuffer = CreateBuffer(renderer, sizeof(InstanceData) * BENCHMARK_OBJECT_COUNT, 
+										 vk::BufferUsageFlagBits::eVertexBuffer, 
+										 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	memcpy(instanceBuffer.mapped, instances.data(), instanceBuffer.size);
+
+	Timer individualTimer;
+	commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr));
+	commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	SetViewport(commandBuffer, extent);
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline);
+	commandBuffer.bindVertexBuffers(0, { mesh.vertexBuffer.buffer, instanceBuffer.buffer }, { 0, 0 });
+
+	uniformAllocator->Bind(commandBuffer, vk::PipelineBindPoint::eGraphics, pipeline.layout, 0, frameAllocation);
+	PushConstants(commandBuffer, pipeline, vk::ShaderStageFlagBits::eVertex, drawConstants);
+
+	for (uint32 index = 0; index < BENCHMARK_OBJECT_COUNT; index++)
+		commandBuffer.draw(mesh.vertexCount, 1, 0, index);
+
+	commandBuffer.endRenderPass();
+	commandBuffer.end();
+	double individualRecordTime = individualTimer.GetMilliseconds();
+	double individualSubmitTime = SubmitAndWait(renderer, commandBuffer, fence);
+
+	DestroyBuffer(renderer, instanceBuffer);
+
+	// Instanced, the batcher merges every submit into one draw call
+	DrawBatcher batcher(renderer, BENCHMARK_OBJECT_COUNT, 1);
+
+	commandBuffer.reset(vk::CommandBufferResetFlags());
+
+	Timer instancedTimer;
+	commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr));
+	commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	SetViewport(commandBuffer, extent);
+
+	uniformAllocator->Bind(commandBuffer, vk::PipelineBindPoint::eGraphics, pipeline.layout, 0, frameAllocation);
+	PushConstants(commandBuffer, pipeline, vk::ShaderStageFlagBits::eVertex, drawConstants);
+
+	batcher.Begin(0);
+	for (uint32 index = 0; index < BENCHMARK_OBJECT_COUNT; index++)
+		batcher.Submit(pipeline, mesh, instances[index]);
+	batcher.Flush(commandBuffer);
+
+	commandBuffer.endRenderPass();
+	commandBuffer.end();
+	double instancedRecordTime = instancedTimer.GetMilliseconds();
+	double instancedSubmitTime = SubmitAndWait(renderer, commandBuffer, fence);
+
+	printf("Instancing benchmark (%u objects)\n", BENCHMARK_OBJECT_COUNT);
+	printf("  Individual: %u draw calls, record %.3f ms, submit + wait %.3f ms\n", BENCHMARK_OBJECT_COUNT, individualRecordTime, individualSubmitTime);
+	printf("  Instanced:  %u draw calls, record %.3f ms, submit + wait %.3f ms\n", batcher.GetDrawCallCount(), instancedRecordTime, instancedSubmitTime);
+
+	device.destroyFence(fence, GetAllocationCallbacks(vk::ObjectType::eFence));
+	device.destroyCommandPool(commandPool, GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+}
+
+void RunMathBenchmark()
+{
+	const uint32 pointCount = 1 << 20;
+	const uint32 iterations = 32;
+
+	std::vector<float> inX(pointCount), inY(pointCount), inZ(pointCount), radius(pointCount);
+	std::vector<float> outX(pointCount), outY(pointCount), outZ(pointCount);
+	std::vector<uint8> visible(pointCount);
+
+	for (uint32 index = 0; index < pointCount; index++)
+	{
+		inX[index] = (float)rand() / RAND_MAX * 200.0f - 100.0f;
+		inY[index] = (float)rand() / RAND_MAX * 200.0f - 100.0f;
+		inZ[index] = (float)rand() / RAND_MAX * 200.0f - 100.0f;
+		radius[index] = 1.0f;
+	}
+
+	Matrix4f view = Matrix4f::LookAt({ 0.0f, 0.0f, 50.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+	Matrix4f projection = Matrix4f::Perspective(ToRadians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+	Matrix4f model = Matrix4f::Rotation(Quaternion::FromAxisAngle({ 0.0f, 1.0f, 0.0f }, 0.5f));
+
+	Frustum frustum = ExtractFrustum(projection * view);
+	const Vector4f* planes = frustum.planes;
+
+	Timer scalarTransformTimer;
+	for (uint32 iteration = 0; iteration < iterations; iteration++)
+		TransformPointsSoAScalar(model, inX.data(), inY.data(), inZ.data(), outX.data(), outY.data(), outZ.data(), pointCount);
+	double scalarTransformTime = scalarTransformTimer.GetMilliseconds() / iterations;
+
+	Timer simdTransformTimer;
+	for (uint32 iteration = 0; iteration < iterations; iteration++)
+		TransformPointsSoA(model, inX.data(), inY.data(), inZ.data(), outX.data(), outY.data(), outZ.data(), pointCount);
+	double simdTransformTime = simdTransformTimer.GetMilliseconds() / iterations;
+
+	uint32 scalarVisible = 0;
+	Timer scalarCullTimer;
+	for (uint32 iteration = 0; iteration < iterations; iteration++)
+		scalarVisible = CullSpheresSoAScalar(planes, inX.data(), inY.data(), inZ.data(), radius.data(), visible.data(), pointCount);
+	double scalarCullTime = scalarCullTimer.GetMilliseconds() / iterations;
+
+	uint32 simdVisible = 0;
+	Timer simdCullTimer;
+	for (uint32 iteration = 0; iteration < iterations; iteration++)
+		simdVisible = CullSpheresSoA(planes, inX.data(), inY.data(), inZ.data(), radius.data(), visible.data(), pointCount);
+	double simdCullTime = simdCullTimer.GetMilliseconds() / iterations;
+
+	// Matrix products are chained so the compiler can't drop any of them
+	Matrix4f scalarProduct = Matrix4f::Identity();
+	Timer scalarMatrixTimer;
+	for (uint32 iteration = 0; iteration < pointCount; iteration++)
+	{
+		Matrix4f result;
+		const float* a = scalarProduct.Data();
+		const float* b = model.Data();
+		for (uint32 column = 0; column < 4; column++)
+		{
+			float* out = &result.columns[column].x;
+			for (uint32 row = 0; row < 4; row++)
+				out[row] = a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] + a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+		}
+		scalarProduct = result;
+	}
+	double scalarMatrixTime = scalarMatrixTimer.GetMilliseconds();
+
+	Matrix4f simdProduct = Matrix4f::Identity();
+	Timer simdMatrixTimer;
+	for (uint32 iteration = 0; iteration < pointCount; iteration++)
+		simdProduct = simdProduct * model;
+	double simdMatrixTime = simdMatrixTimer.GetMilliseconds();
+
+	printf("Math benchmark (%u elements)\n", pointCount);
+	printf("  Transform points: scalar %.3f ms, simd %.3f ms (%.2fx)\n", scalarTransformTime, simdTransformTime, scalarTransformTime / simdTransformTime);
+	printf("  Cull spheres:     scalar %.3f ms, simd %.3f ms (%.2fx), %u / %u visible\n", scalarCullTime, simdCullTime, scalarCullTime / simdCullTime, scalarVisible, simdVisible);
+	printf("  Matrix multiply:  scalar %.3f ms, simd %.3f ms (%.2fx), checksum %f / %f\n", scalarMatrixTime, simdMatrixTime, scalarMatrixTime / simdMatrixTime, 
+		   scalarProduct.columns[0].x, simdProduct.columns[0].x);
+}
+
+static TransientMemoryStats BuildAliasingTestGraph(Renderer* renderer, vk::Extent2D extent, bool aliasing)
+{
+	typedef vk::ImageUsageFlagBits Usage;
+
+	uint32 graphicsIndex = renderer->GetQueueFamilyIndicies().graphicsIndex;
+	vk::Extent2D halfExtent(extent.width / 2, extent.height / 2);
+
+	RenderGraph graph(renderer);
+	graph.SetAliasingEnabled(aliasing);
+
+	RenderGraphResource depth = graph.CreateImage("Depth", { vk::Format::eD32Sfloat, extent, Usage::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth });
+	RenderGraphResource albedo = graph.CreateImage("Albedo", { vk::Format::eR8G8B8A8Unorm, extent, Usage::eColorAttachment | Usage::eSampled, vk::ImageAspectFlagBits::eColor });
+	RenderGraphResource normals = graph.CreateImage("Normals", { vk::Format::eR16G16B16A16Sfloat, extent, Usage::eColorAttachment | Usage::eSampled, vk::ImageAspectFlagBits::eColor });
+	RenderGraphResource hdr = graph.CreateImage("HDR", { vk::Format::eR16G16B16A16Sfloat, extent, Usage::eColorAttachment | Usage::eSampled, vk::ImageAspectFlagBits::eColor });
+	RenderGraphResource bloom = graph.CreateImage("Bloom", { vk::Format::eR16G16B16A16Sfloat, halfExtent, Usage::eColorAttachment | Usage::eSampled, vk::ImageAspectFlagBits::eColor });
+	RenderGraphResource bloomBlur = graph.CreateImage("BloomBlur", { vk::Format::eR16G16B16A16Sfloat, halfExtent, Usage::eColorAttachment | Usage::eSampled, vk::ImageAspectFlagBits::eColor });
+	RenderGraphResource ldr = graph.CreateImage("LDR", { vk::Format::eR8G8B8A8Unorm, extent, Usage::eColorAttachment | Usage::eTransferSrc, vk::ImageAspectFlagBits::eColor });
+	graph.MarkOutput(ldr, ResourceUsage::TransferRead);
+
+	auto noop = [](vk::CommandBuffer) {};
+
+	graph.AddPass("DepthPrepass", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Write(depth, ResourceUsage::DepthAttachment); }, noop);
+	graph.AddPass("GBuffer", graphicsIndex, [&](RenderPassBuilder& builder)
+	{
+		builder.Read(depth, ResourceUsage::DepthAttachmentRead);
+		builder.Write(albedo, ResourceUsage::ColorAttachment).Write(normals, ResourceUsage::ColorAttachment);
+	}, noop);
+	graph.AddPass("Lighting", graphicsIndex, [&](RenderPassBuilder& builder)
+	{
+		builder.Read(albedo, ResourceUsage::FragmentShaderRead).Read(normals, ResourceUsage::FragmentShaderRead);
+		builder.Write(hdr, ResourceUsage::ColorAttachment);
+	}, noop);
+	graph.AddPass("BloomDownsample", graphicsIndex, [&](RenderPassBuilder& builder)
+	{
+		builder.Read(hdr, ResourceUsage::FragmentShaderRead).Write(bloom, ResourceUsage::ColorAttachment);
+	}, noop);
+	graph.AddPass("BloomBlur", graphicsIndex, [&](RenderPassBuilder& builder)
+	{
+		builder.Read(bloom, ResourceUsage::FragmentShaderRead).Write(bloomBlur, ResourceUsage::ColorAttachment);
+	}, noop);
+	graph.AddPass("Tonemap", graphicsIndex, [&](RenderPassBuilder& builder)
+	{
+		builder.Read(hdr, ResourceUsage::FragmentShaderRead).Read(bloomBlur, ResourceUsage::FragmentShaderRead);
+		builder.Write(ldr, ResourceUsage::ColorAttachment);
+	}, noop);
+
+	graph.Compile();
+	return graph.GetTransientMemoryStats();
+}
+
+void RunAliasingReport(Renderer* renderer, vk::Extent2D extent)
+{
+	TransientMemoryStats unaliased = BuildAliasingTestGraph(renderer, extent, false);
+	TransientMemoryStats aliased = BuildAliasingTestGraph(renderer, extent, true);
+
+	const double megabyte = 1024.0 * 1024.0;
+
+	printf("Transient attachment memory (%ux%u, %u images, %u lazily allocated)\n", extent.width, extent.height, aliased.imageCount, aliased.lazilyAllocatedCount);
+	printf("  Aliasing off: %.2f MB in %u allocations\n", unaliased.aliasedBytes / megabyte, unaliased.allocationCount);
+	printf("  Aliasing on:  %.2f MB in %u allocations\n", aliased.aliasedBytes / megabyte, aliased.allocationCount);
+}
+
+static bool CheckGraph(const char* name, bool passed)
+{
+	printf("  %-40s %s\n", name, passed ? "passed" : "FAILED");
+	return passed;
+}
+
+bool RunRenderGraphTests(Renderer* renderer)
+{
+	typedef vk::PipelineStageFlagBits Stage;
+	typedef vk::AccessFlagBits Access;
+
+	uint32 graphicsIndex = renderer->GetQueueFamilyIndicies().graphicsIndex;
+	auto noop = [](vk::CommandBuffer) {};
+
+	ResourceState srcState;
+	ResourceState dstState;
+	bool passed = true;
+
+	printf("Render graph tests\n");
+
+	// A pass writing a buffer and reading it back leaves it written, the next reader has to wait
+	{
+		RenderGraph graph(renderer);
+		RenderGraphResource buffer = graph.ImportBuffer("Buffer", vk::Buffer(), ResourceState());
+
+		graph.AddPass("WriteRead", graphicsIndex, [&](RenderPassBuilder& builder)
+		{
+			builder.Write(buffer, ResourceUsage::ComputeBufferWrite).Read(buffer, ResourceUsage::ComputeBufferRead).SetSideEffects();
+		}, noop);
+		graph.AddPass("Read", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Read(buffer, ResourceUsage::IndirectRead).SetSideEffects(); }, noop);
+		graph.Compile();
+
+		bool waits = graph.GetPassBarrier(1, buffer, srcState, dstState);
+		passed &= CheckGraph("Read after write then read", waits && (srcState.access & Access::eShaderWrite) && 
+							 (dstState.stages & Stage::eDrawIndirect));
+	}
+
+	// Readers merge without barriers between them, the writer after them waits for every one
+	{
+		RenderGraph graph(renderer);
+		RenderGraphResource buffer = graph.ImportBuffer("Buffer", vk::Buffer(), ResourceState());
+
+		graph.AddPass("Write", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Write(buffer, ResourceUsage::TransferWrite).SetSideEffects(); }, noop);
+		graph.AddPass("IndirectRead", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Read(buffer, ResourceUsage::IndirectRead).SetSideEffects(); }, noop);
+		graph.AddPass("ComputeRead", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Read(buffer, ResourceUsage::ComputeBufferRead).SetSideEffects(); }, noop);
+		graph.AddPass("VertexRead", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Read(buffer, ResourceUsage::VertexRead).SetSideEffects(); }, noop);
+		graph.AddPass("Overwrite", graphicsIndex, [&](RenderPassBuilder& builder) { builder.Write(buffer, ResourceUsage::TransferWrite).SetSideEffects(); }, noop);
+		graph.Compile();
+
+		bool firstReaderWaits = graph.GetPassBarrier(1, buffer, srcState, dstState);
+		bool laterReadersWait = graph.GetPassBarrier(2, buffer, srcState, dstState) || graph.GetPassBarrier(3, buffer, srcState, dstState);
+		passed &= CheckGraph("Readers merge", firstReaderWaits && !laterReadersWait);
+
+		const vk::PipelineStageFlags readers = Stage::eDrawIndirect | Stage::eComputeShader | Stage::eVertexInput;
+		bool writerWaits = graph.GetPassBarrier(4, buffer, srcState, dstState);
+		passed &= CheckGraph("Write after several reads", writerWaits && (srcState.stages & readers) == readers);
+	}
+
+	return passed;
+}
+
+void RunShaderReport(Renderer* renderer, const GraphicsPipelineDesc& baseDesc, const String& vertexFile, const String& fragmentFile)
+{
+	const uint32 PIPELINE_REPEATS = 10;
+
+	vk::Device device = renderer->GetDevice();
+	vk::PipelineLayout layout = renderer->GetPipelineStateCache()->GetPipelineLayout(baseDesc.setLayouts, baseDesc.pushConstantRanges);
+
+	const char* names[] = { "debug", "release" };
+	ShaderCompileOptions options[] = { ShaderCompileOptions::Debug(), ShaderCompileOptions::Release() };
+
+	printf("Shader report (%s, %s)\n", vertexFile.c_str(), fragmentFile.c_str());
+	for (uint32 index = 0; index < 2; index++)
+	{
+		std::vector<uint32> vertexCode = CompileShaderToSpirv(vertexFile, shaderc_shader_kind::shaderc_vertex_shader, options[index]);
+		std::vector<uint32> fragmentCode = CompileShaderToSpirv(fragmentFile, shaderc_shader_kind::shaderc_fragment_shader, options[index]);
+
+		GraphicsPipelineDesc desc = baseDesc;
+		desc.vertexShader = CreateShader(device, vertexCode);
+		desc.fragmentShader = CreateShader(device, fragmentCode);
+
+		// No pipeline cache, every repeat pays the full driver compile
+		Timer timer;
+		for (uint32 repeat = 0; repeat < PIPELINE_REPEATS; repeat++)
+		{
+			vk::Pipeline pipeline = CreateGraphicsPipeline(device, desc, layout);
+			device.destroyPipeline(pipeline, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+		}
+		double pipelineTime = timer.GetMilliseconds() / PIPELINE_REPEATS;
+
+		size_t size = (vertexCode.size() + fragmentCode.size()) * sizeof(uint32);
+		printf("  %-7s %6zu bytes of SPIR-V, pipeline creation %.3f ms\n", names[index], size, pipelineTime);
+
+		device.destroyShaderModule(desc.vertexShader, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+		device.destroyShaderModule(desc.fragmentShader, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+	}
+}
+
+// Dynamic state only, valid outside of a render pass and without a pipeline, so nothing but the
+// call itself is measured
+template<typename Dispatch>
+static double RecordDispatchTestCommands(vk::CommandBuffer commandBuffer, uint32 iterations, const Dispatch& dispatch)
+{
+	vk::Viewport viewport(0.0f, 0.0f, 64.0f, 64.0f, 0.0f, 1.0f);
+	vk::Rect2D scissor(vk::Offset2D(), vk::Extent2D(64, 64));
+	float blendConstants[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	commandBuffer.reset(vk::CommandBufferResetFlags(), dispatch);
+
+	Timer timer;
+	commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr), dispatch);
+	for (uint32 iteration = 0; iteration < iterations; iteration++)
+	{
+		commandBuffer.setViewport(0, 1, &viewport, dispatch);
+		commandBuffer.setScissor(0, 1, &scissor, dispatch);
+		commandBuffer.setBlendConstants(blendConstants, dispatch);
+		commandBuffer.setStencilReference(vk::StencilFaceFlagBits::eFront, iteration & 0xff, dispatch);
+	}
+	commandBuffer.end(dispatch);
+
+	return timer.GetMilliseconds();
+}
+
+void RunDispatchBenchmark(Renderer* renderer)
+{
+	const uint32 ITERATIONS = 250000;
+	const uint32 COMMANDS_PER_ITERATION = 4;
+	const uint32 REPEATS = 5;
+
+	vk::Device device = renderer->GetDevice();
+
+	QueueFamilyIndicies queueIndicies = renderer->GetQueueFamilyIndicies();
+	vk::CommandPool commandPool = device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueIndicies.graphicsIndex), GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+	vk::CommandBuffer commandBuffer = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(commandPool, vk::CommandBufferLevel::ePrimary, 1))[0];
+
+	// Best of several runs, the first one also pays for the command pool growing
+	double loaderTime = 1e30;
+	double directTime = 1e30;
+	for (uint32 repeat = 0; repeat < REPEATS; repeat++)
+	{
+		loaderTime = std::min(loaderTime, RecordDispatchTestCommands(commandBuffer, ITERATIONS, vk::DispatchLoaderStatic()));
+		directTime = std::min(directTime, RecordDispatchTestCommands(commandBuffer, ITERATIONS, GetDirectDispatch()));
+	}
+
+	double callCount = (double)ITERATIONS * COMMANDS_PER_ITERATION;
+
+	printf("Dispatch benchmark (%.0f commands recorded)\n", callCount);
+	if (renderer->IsValidationEnabled())
+		printf("  Validation is enabled and intercepts every call, run with --no-validation for real numbers\n");
+	printf("  Loader trampolines: %.3f ms, %.2f ns per command\n", loaderTime, loaderTime * 1000000.0 / callCount);
+	printf("  Direct dispatch:    %.3f ms, %.2f ns per command\n", directTime, directTime * 1000000.0 / callCount);
+
+	device.destroyCommandPool(commandPool, GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+}
+
+static void PrintBufferAllocatorStats(const char* label, const BufferAllocatorStats& stats)
+{
+	const double megabyte = 1024.0 * 1024.0;
+
+	printf("  %-8s %u blocks, %.2f MB in blocks, %u allocations, %.2f MB allocated, %.0f%% of free space fragmented\n", label, 
+		   stats.blockCount, stats.blockBytes / megabyte, stats.allocationCount, stats.allocatedBytes / megabyte, stats.fragmentation * 100.0f);
+}
+
+void RunDefragmentReport(Renderer* renderer)
+{
+	const uint32 ALLOCATION_COUNT = 2000;
+	const uint32 MAX_FRAMES = 1000;
+
+	vk::Device device = renderer->GetDevice();
+
+	QueueFamilyIndicies queueIndicies = renderer->GetQueueFamilyIndicies();
+	vk::CommandPool commandPool = device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueIndicies.graphicsIndex), GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+	vk::CommandBuffer commandBuffer = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(commandPool, vk::CommandBufferLevel::ePrimary, 1))[0];
+	vk::Fence fence = device.createFence(vk::FenceCreateInfo(), GetAllocationCallbacks(vk::ObjectType::eFence));
+
+	BufferAllocator allocator(renderer, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer, 
+							  vk::MemoryPropertyFlagBits::eDeviceLocal, NUM_FRAMES);
+
+	// Like a long streaming session, lots of differently sized buffers of which most went away again
+	std::vector<BufferHandle> handles(ALLOCATION_COUNT);
+	for (BufferHandle& handle : handles)
+		handle = allocator.Allocate((rand() % 64 + 1) * 4096);
+
+	for (BufferHandle& handle : handles)
+	{
+		if (rand() % 10 < 7)
+			allocator.Free(handle);
+	}
+
+	// Frees only land once their frame comes around again
+	for (uint32 frame = 0; frame < NUM_FRAMES; frame++)
+		allocator.BeginFrame(frame);
+
+	printf("Buffer defragmentation (%u allocations, 70%% freed)\n", ALLOCATION_COUNT);
+	PrintBufferAllocatorStats("Before:", allocator.GetStats());
+
+	// The same steps the frame loop takes, a few MB of copies per frame
+	uint32 frameCount = 0;
+	uint32 idleFrames = 0;
+	double gpuTime = 0.0;
+	for (; frameCount < MAX_FRAMES; frameCount++)
+	{
+		allocator.BeginFrame(frameCount % NUM_FRAMES);
+
+		commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr));
+		vk::DeviceSize moved = allocator.Defragment(commandBuffer);
+		commandBuffer.end();
+
+		gpuTime += SubmitAndWait(renderer, commandBuffer, fence);
+
+		// A block can be picked while its last allocations are still waiting on their frame
+		idleFrames = moved > 0 ? 0 : idleFrames + 1;
+		if (idleFrames > NUM_FRAMES)
+			break;
+	}
+
+	// Let the last moves retire so their source blocks are given back
+	for (uint32 frame = 0; frame < NUM_FRAMES; frame++)
+		allocator.BeginFrame((frameCount + 1 + frame) % NUM_FRAMES);
+
+	const BufferAllocatorStats& stats = allocator.GetStats();
+	PrintBufferAllocatorStats("After:", stats);
+	printf("  Moved %u allocations (%.2f MB) over %u frames, %.3f ms of GPU copies, %u blocks freed\n", 
+		   stats.movedAllocations, stats.movedBytes / (1024.0 * 1024.0), frameCount, gpuTime, stats.freedBlocks);
+
+	for (BufferHandle& handle : handles)
+		allocator.Free(handle);
+
+	device.destroyFence(fence, GetAllocationCallbacks(vk::ObjectType::eFence));
+	device.destroyCommandPool(commandPool, GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "mesh.h"
+#include "pipeline.h"
+
+class Renderer;
+
+// Records 100k triangles as individual draw calls and again through the DrawBatcher,
+// prints the CPU recording time and the submit to fence time for both
+void RunInstancingBenchmark(Renderer* renderer, vk::RenderPass renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent, const Pipeline& pipeline, const Mesh& mesh);
+
+// Times the SIMD math batch functions against their scalar reference versions
+void RunMathBenchmark();
+
+// Builds a deferred style frame (depth prepass, G-buffer, lighting, bloom, tonemap) out of transient
+// render graph targets and prints the attachment memory it needs with and without aliasing
+void RunAliasingReport(Renderer* renderer, vk::Extent2D extent);
+
+// Builds small graphs with imported buffers and checks the barriers the graph puts between their
+// passes, prints each case and returns false when any of them fails
+bool RunRenderGraphTests(Renderer* renderer);
+
+// Builds the pipeline from debug and from release SPIR-V of the same shaders and prints module
+// sizes and how long the driver takes to create the pipeline from each
+void RunShaderReport(Renderer* renderer, const GraphicsPipelineDesc& baseDesc, const String& vertexFile, const String& fragmentFile);
+
+// Records the same dynamic state commands through the loader's trampolines and through entry points
+// from vkGetDeviceProcAddr, prints the per command cost of both
+void RunDispatchBenchmark(Renderer* renderer);
+
+// Fragments a buffer allocator the way a long streaming session would, then runs the incremental
+// defragmenter frame by frame and prints block counts and fragmentation before and after
+void RunDefragmentReport(Renderer* renderer);
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "bindless.h"
+
+#include "renderer.h"
+
+#include <algorithm>
+
+const uint32 MAX_BINDLESS_TEXTURES = 16384;
+const uint32 MAX_BINDLESS_BUFFERS = 16384;
+const uint32 MAX_BINDLESS_SAMPLERS = 64;
+
+uint32 BindlessHeap::SlotList::Allocate()
+{
+	if (!freeSlots.empty())
+	{
+		uint32 index = freeSlots.back();
+		freeSlots.pop_back();
+		return index;
+	}
+
+	assert(next < capacity);
+	return next++;
+}
+
+BindlessHeap::BindlessHeap(Renderer* renderer)
+	: m_Renderer(renderer), m_FrameIndex(0)
+{
+	vk::Device device = renderer->GetDevice();
+
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+	VkPhysicalDeviceProperties2 properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexingProperties;
+
+	vkGetPhysicalDeviceProperties2(renderer->GetGPUDevice(), &properties);
+
+	SlotList* lists[] = { &m_Textures, &m_Buffers, &m_Samplers };
+	uint32 capacities[] = {
+		std::min(MAX_BINDLESS_TEXTURES, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages),
+		std::min(MAX_BINDLESS_BUFFERS, indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers),
+		std::min(MAX_BINDLESS_SAMPLERS, indexingProperties.maxDescriptorSetUpdateAfterBindSamplers),
+	};
+
+	for (uint32 index = 0; index < 3; index++)
+	{
+		lists[index]->capacity = capacities[index];
+		lists[index]->next = 0;
+		lists[index]->pendingSlots.resize(NUM_FRAMES);
+	}
+
+	vk::ShaderStageFlags stages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+	vk::DescriptorSetLayoutBinding bindings[] = {
+		vk::DescriptorSetLayoutBinding(BINDLESS_TEXTURE_BINDING, vk::DescriptorType::eSampledImage, m_Textures.capacity, stages, nullptr),
+		vk::DescriptorSetLayoutBinding(BINDLESS_BUFFER_BINDING, vk::DescriptorType::eStorageBuffer, m_Buffers.capacity, stages, nullptr),
+		vk::DescriptorSetLayoutBinding(BINDLESS_SAMPLER_BINDING, vk::DescriptorType::eSampler, m_Samplers.capacity, stages, nullptr),
+	};
+
+	// Partially bound lets unused slots stay empty, update after bind lets new resources be
+	// registered while command buffers using the set are still pending
+	vk::DescriptorBindingFlagsEXT bindingFlag = vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind | vk::DescriptorBindingFlagBitsEXT::ePartiallyBound;
+	vk::DescriptorBindingFlagsEXT bindingFlags[] = { bindingFlag, bindingFlag, bindingFlag };
+
+	vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCreateInfo(3, bindingFlags);
+
+	vk::DescriptorSetLayoutCreateInfo layoutCreateInfo(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT, 3, bindings);
+	layoutCreateInfo.setPNext(&bindingFlagsCreateInfo);
+
+	m_Layout = device.createDescriptorSetLayout(layoutCreateInfo, GetAllocationCallbacks(vk::ObjectType::eDescriptorSetLayout));
+
+	vk::DescriptorPoolSize poolSizes[] = {
+		vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, m_Textures.capacity),
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, m_Buffers.capacity),
+		vk::DescriptorPoolSize(vk::DescriptorType::eSampler, m_Samplers.capacity),
+	};
+
+	m_Pool = device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT, 1, 3, poolSizes), GetAllocationCallbacks(vk::ObjectType::eDescriptorPool));
+	m_Set = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_Pool, 1, &m_Layout))[0];
+}
+
+BindlessHeap::~BindlessHeap()
+{
+	vk::Device device = m_Renderer->GetDevice();
+
+	device.destroyDescriptorPool(m_Pool, GetAllocationCallbacks(vk::ObjectType::eDescriptorPool));
+	device.destroyDescriptorSetLayout(m_Layout, GetAllocationCallbacks(vk::ObjectType::eDescriptorSetLayout));
+}
+
+void BindlessHeap::BeginFrame(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+
+	SlotList* lists[] = { &m_Textures, &m_Buffers, &m_Samplers };
+	for (SlotList* list : lists)
+	{
+		std::vector<uint32>& pending = list->pendingSlots[frameIndex];
+		list->freeSlots.insert(list->freeSlots.end(), pending.begin(), pending.end());
+		pending.clear();
+	}
+}
+
+void BindlessHeap::Release(SlotList& list, uint32 index)
+{
+	assert(index < list.next);
+	list.pendingSlots[m_FrameIndex].push_back(index);
+}
+
+uint32 BindlessHeap::RegisterTexture(vk::ImageView imageView, vk::ImageLayout layout)
+{
+	uint32 index = m_Textures.Allocate();
+	UpdateTexture(index, imageView, layout);
+
+	return index;
+}
+
+void BindlessHeap::UpdateTexture(uint32 index, vk::ImageView imageView, vk::ImageLayout layout)
+{
+	vk::DescriptorImageInfo imageInfo(nullptr, imageView, layout);
+	vk::WriteDescriptorSet write(m_Set, BINDLESS_TEXTURE_BINDING, index, 1, vk::DescriptorType::eSampledImage, &imageInfo, nullptr, nullptr);
+
+	m_Renderer->GetDevice().updateDescriptorSets({ write }, nullptr);
+}
+
+uint32 BindlessHeap::RegisterBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range)
+{
+	uint32 index = m_Buffers.Allocate();
+
+	vk::DescriptorBufferInfo bufferInfo(buffer, offset, range);
+	vk::WriteDescriptorSet write(m_Set, BINDLESS_BUFFER_BINDING, index, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo, nullptr);
+
+	m_Renderer->GetDevice().updateDescriptorSets({ write }, nullptr);
+	return index;
+}
+
+uint32 BindlessHeap::RegisterSampler(vk::Sampler sampler)
+{
+	uint32 index = m_Samplers.Allocate();
+
+	vk::DescriptorImageInfo imageInfo(sampler, nullptr, vk::ImageLayout::eUndefined);
+	vk::WriteDescriptorSet write(m_Set, BINDLESS_SAMPLER_BINDING, index, 1, vk::DescriptorType::eSampler, &imageInfo, nullptr, nullptr);
+
+	m_Renderer->GetDevice().updateDescriptorSets({ write }, nullptr);
+	return index;
+}
+
+void BindlessHeap::Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout)
+{
+	commandBuffer.bindDescriptorSets(bindPoint, layout, BINDLESS_SET_INDEX, { m_Set }, nullptr, GetDispatch());
+}
+
+vk::PushConstantRange BindlessHeap::GetPushConstantRange(uint32 offset) const
+{
+	return vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute, 
+								 offset, sizeof(BindlessPushConstants));
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+
+class Renderer;
+
+const uint32 BINDLESS_TEXTURE_BINDING = 0;
+const uint32 BINDLESS_BUFFER_BINDING = 1;
+const uint32 BINDLESS_SAMPLER_BINDING = 2;
+
+const uint32 BINDLESS_INVALID_INDEX = 0xFFFFFFFF;
+
+// Set 0 stays the per frame uniforms, bindless pipeline layouts put the heap right after them
+const uint32 BINDLESS_SET_INDEX = 1;
+
+// Push constants of every bindless draw, matches BindlessIndices in bindless.frag
+struct BindlessPushConstants
+{
+	uint32 textureIndex;
+	uint32 samplerIndex;
+	uint32 bufferIndex;
+	uint32 padding;
+};
+
+// One large update-after-bind descriptor set holding every sampled image, storage buffer and sampler.
+// It is bound once per command buffer and draws pick their resources through push constant indices,
+// so switching materials never touches descriptor sets
+class BindlessHeap
+{
+private:
+	struct SlotList
+	{
+		uint32 capacity;
+		uint32 next;
+		std::vector<uint32> freeSlots;
+
+		// Slots released in a frame can only be reused once that frame is no longer in flight
+		std::vector<std::vector<uint32>> pendingSlots;
+
+		uint32 Allocate();
+	};
+
+	Renderer* m_Renderer;
+
+	vk::DescriptorSetLayout m_Layout;
+	vk::DescriptorPool m_Pool;
+	vk::DescriptorSet m_Set;
+
+	SlotList m_Textures;
+	SlotList m_Buffers;
+	SlotList m_Samplers;
+
+	uint32 m_FrameIndex;
+private:
+	void Release(SlotList& list, uint32 index);
+public:
+	BindlessHeap(Renderer* renderer);
+	~BindlessHeap();
+
+	void BeginFrame(uint32 frameIndex);
+
+	uint32 RegisterTexture(vk::ImageView imageView, vk::ImageLayout layout);
+	uint32 RegisterBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range);
+	uint32 RegisterSampler(vk::Sampler sampler);
+
+	// Rewrites an existing slot in place, used when the resource behind an index changes
+	void UpdateTexture(uint32 index, vk::ImageView imageView, vk::ImageLayout layout);
+
+	void ReleaseTexture(uint32 index) { Release(m_Textures, index); }
+	void ReleaseBuffer(uint32 index) { Release(m_Buffers, index); }
+	void ReleaseSampler(uint32 index) { Release(m_Samplers, index); }
+
+	// Binds the heap as BINDLESS_SET_INDEX, it stays bound across pipelines with compatible layouts
+	void Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout);
+
+	vk::DescriptorSetLayout GetLayout() const { return m_Layout; }
+
+	// The indices go after whatever push constants the shaders have of their own
+	vk::PushConstantRange GetPushConstantRange(uint32 offset) const;
+};
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "buffer.h"
+
+#include "renderer.h"
+
+Buffer CreateBuffer(Renderer* renderer, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, MemoryCategory category)
+{
+	vk::Device device = renderer->GetDevice();
+
+	vk::BufferCreateInfo bufferCreateInfo = {};
+	bufferCreateInfo.setSize(size);
+	bufferCreateInfo.setUsage(usage);
+	bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+
+	Buffer result = {};
+	result.buffer = device.createBuffer(bufferCreateInfo, GetAllocationCallbacks(vk::ObjectType::eBuffer));
+	result.size = size;
+
+	vk::MemoryRequirements memRequirements = device.getBufferMemoryRequirements(result.buffer);
+
+	vk::MemoryAllocateInfo allocInfo = {};
+	allocInfo.setAllocationSize(memRequirements.size);
+	allocInfo.setMemoryTypeIndex(renderer->FindMemoryType(memRequirements.memoryTypeBits, properties));
+
+	result.memory = renderer->GetMemoryBudget()->Allocate(allocInfo, category);
+	device.bindBufferMemory(result.buffer, result.memory, 0);
+
+	if (properties & vk::MemoryPropertyFlagBits::eHostVisible)
+		result.mapped = device.mapMemory(result.memory, 0, size);
+
+	return result;
+}
+
+void DestroyBuffer(Renderer* renderer, Buffer& buffer)
+{
+	vk::Device device = renderer->GetDevice();
+
+	if (buffer.mapped)
+		device.unmapMemory(buffer.memory);
+
+	device.destroyBuffer(buffer.buffer, GetAllocationCallbacks(vk::ObjectType::eBuffer));
+	renderer->GetMemoryBudget()->Free(buffer.memory);
+
+	buffer = {};
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "memorybudget.h"
+
+class Renderer;
+
+struct Buffer
+{
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	vk::DeviceSize size = 0;
+
+	// Only set for host visible buffers, they stay mapped for their whole lifetime
+	void* mapped = nullptr;
+};
+
+Buffer CreateBuffer(Renderer* renderer, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, 
+					MemoryCategory category = MemoryCategory::Buffer);
+void DestroyBuffer(Renderer* renderer, Buffer& buffer);
\ No newline at end of file
@@ -0,0 +1,403 @@
+#include "bufferallocator.h"
+
+#include "renderer.h"
+
+#include <algorithm>
+#include <assert.h>
+
+// Only worth the copies when the emptiest block is at most this full
+const float DEFRAGMENT_MAX_BLOCK_USAGE = 0.5f;
+
+static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+BufferAllocator::BufferAllocator(Renderer* renderer, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, uint32 framesInFlight)
+	: m_Renderer(renderer), m_Usage(usage), m_Properties(properties), m_FrameIndex(0), m_DefragmentBlock(UINT32_MAX), m_Stats()
+{
+	// Sub-allocations get bound as any kind of buffer at their offset
+	const vk::PhysicalDeviceLimits& limits = renderer->GetCapabilities().properties.limits;
+	m_Alignment = std::max({ (vk::DeviceSize)16, limits.minStorageBufferOffsetAlignment, 
+							 limits.minUniformBufferOffsetAlignment, limits.minTexelBufferOffsetAlignment });
+
+	m_PendingFrees.resize(framesInFlight);
+}
+
+BufferAllocator::~BufferAllocator()
+{
+	for (uint32 index = 0; index < m_Blocks.size(); index++)
+	{
+		if (m_Blocks[index].buffer)
+			DestroyBlock(index);
+	}
+}
+
+uint32 BufferAllocator::CreateBlock(vk::DeviceSize size)
+{
+	vk::Device device = m_Renderer->GetDevice();
+
+	Block block = {};
+	block.size = AlignUp(size, m_Alignment);
+
+	// Transfer both ways for the defragmenter's copies
+	vk::BufferCreateInfo bufferCreateInfo = {};
+	bufferCreateInfo.setSize(block.size);
+	bufferCreateInfo.setUsage(m_Usage | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst);
+	bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+
+	block.buffer = device.createBuffer(bufferCreateInfo, GetAllocationCallbacks(vk::ObjectType::eBuffer));
+	SetObjectName(device, block.buffer, "Buffer block");
+
+	vk::MemoryRequirements requirements = device.getBufferMemoryRequirements(block.buffer);
+
+	vk::MemoryAllocateInfo allocInfo(requirements.size, m_Renderer->FindMemoryType(requirements.memoryTypeBits, m_Properties));
+	block.memory = m_Renderer->GetMemoryBudget()->Allocate(allocInfo, MemoryCategory::Buffer);
+	device.bindBufferMemory(block.buffer, block.memory, 0);
+
+	if (m_Properties & vk::MemoryPropertyFlagBits::eHostVisible)
+		block.mapped = device.mapMemory(block.memory, 0, block.size);
+
+	block.freeRanges.push_back({ 0, block.size });
+
+	for (uint32 index = 0; index < m_Blocks.size(); index++)
+	{
+		if (!m_Blocks[index].buffer)
+		{
+			m_Blocks[index] = block;
+			return index;
+		}
+	}
+
+	m_Blocks.push_back(block);
+	return (uint32)m_Blocks.size() - 1;
+}
+
+void BufferAllocator::DestroyBlock(uint32 blockIndex)
+{
+	vk::Device device = m_Renderer->GetDevice();
+	Block& block = m_Blocks[blockIndex];
+
+	if (block.mapped)
+		device.unmapMemory(block.memory);
+
+	device.destroyBuffer(block.buffer, GetAllocationCallbacks(vk::ObjectType::eBuffer));
+	m_Renderer->GetMemoryBudget()->Free(block.memory);
+
+	block = {};
+}
+
+bool BufferAllocator::AllocateFromBlock(uint32 blockIndex, vk::DeviceSize size, vk::DeviceSize& outOffset)
+{
+	// Sizes and offsets are all multiples of the alignment, so first fit needs no padding
+	Block& block = m_Blocks[blockIndex];
+	for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); it++)
+	{
+		if (it->size < size)
+			continue;
+
+		outOffset = it->offset;
+		it->offset += size;
+		it->size -= size;
+		if (it->size == 0)
+			block.freeRanges.erase(it);
+
+		block.allocatedBytes += size;
+		block.allocationCount++;
+		return true;
+	}
+
+	return false;
+}
+
+void BufferAllocator::FreeToBlock(uint32 blockIndex, const FreeRange& range)
+{
+	Block& block = m_Blocks[blockIndex];
+	block.allocatedBytes -= range.size;
+	block.allocationCount--;
+
+	std::vector<FreeRange>& ranges = block.freeRanges;
+	auto it = std::lower_bound(ranges.begin(), ranges.end(), range, [](const FreeRange& a, const FreeRange& b)
+	{
+		return a.offset < b.offset;
+	});
+
+	it = ranges.insert(it, range);
+
+	// Merge with the next range, then with the previous one
+	auto next = it + 1;
+	if (next != ranges.end() && it->offset + it->size == next->offset)
+	{
+		it->size += next->size;
+		it = ranges.erase(next) - 1;
+	}
+
+	if (it != ranges.begin())
+	{
+		auto previous = it - 1;
+		if (previous->offset + previous->size == it->offset)
+		{
+			previous->size += it->size;
+			ranges.erase(it);
+		}
+	}
+}
+
+bool BufferAllocator::AllocateRange(vk::DeviceSize size, bool allowNewBlock, uint32& outBlock, vk::DeviceSize& outOffset)
+{
+	for (uint32 index = 0; index < m_Blocks.size(); index++)
+	{
+		if (!m_Blocks[index].buffer || m_Blocks[index].retiring)
+			continue;
+
+		if (AllocateFromBlock(index, size, outOffset))
+		{
+			outBlock = index;
+			return true;
+		}
+	}
+
+	if (!allowNewBlock)
+		return false;
+
+	// Bigger than a block gets a block of its own
+	outBlock = CreateBlock(std::max(size, BUFFER_BLOCK_SIZE));
+
+	bool allocated = AllocateFromBlock(outBlock, size, outOffset);
+	assert(allocated);
+
+	return true;
+}
+
+void BufferAllocator::BeginFrame(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+
+	std::vector<PendingFree>& pending = m_PendingFrees[frameIndex];
+	for (const PendingFree& free : pending)
+		FreeToBlock(free.block, free.range);
+	pending.clear();
+
+	// Keep a single empty block around so allocating and freeing one buffer doesn't churn blocks,
+	// unless it was emptied on purpose
+	uint32 liveBlocks = 0;
+	for (const Block& block : m_Blocks)
+	{
+		if (block.buffer)
+			liveBlocks++;
+	}
+
+	for (uint32 index = 0; index < m_Blocks.size(); index++)
+	{
+		const Block& block = m_Blocks[index];
+		if (!block.buffer || block.allocationCount > 0)
+			continue;
+
+		if (liveBlocks > 1 || block.retiring)
+		{
+			DestroyBlock(index);
+			liveBlocks--;
+			m_Stats.freedBlocks++;
+		}
+	}
+}
+
+BufferHandle BufferAllocator::Allocate(vk::DeviceSize size)
+{
+	uint32 slotIndex;
+	if (!m_FreeSlots.empty())
+	{
+		slotIndex = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	else
+	{
+		slotIndex = (uint32)m_Slots.size();
+		m_Slots.push_back(Slot());
+		m_Slots.back().generation = 0;
+	}
+
+	Slot& slot = m_Slots[slotIndex];
+	slot.live = true;
+	slot.size = AlignUp(size, m_Alignment);
+	AllocateRange(slot.size, true, slot.block, slot.offset);
+
+	BufferHandle handle;
+	handle.index = slotIndex;
+	handle.generation = slot.generation;
+	return handle;
+}
+
+void BufferAllocator::Free(BufferHandle& handle)
+{
+	if (!handle.IsValid())
+		return;
+
+	Slot& slot = m_Slots[handle.index];
+	assert(slot.live && slot.generation == handle.generation);
+
+	// The frames in flight may still read it
+	m_PendingFrees[m_FrameIndex].push_back({ slot.block, { slot.offset, slot.size } });
+
+	slot.live = false;
+	slot.generation++;
+	m_FreeSlots.push_back(handle.index);
+
+	handle = BufferHandle();
+}
+
+BufferRange BufferAllocator::Resolve(BufferHandle handle) const
+{
+	const Slot& slot = m_Slots[handle.index];
+	assert(slot.live && slot.generation == handle.generation);
+
+	const Block& block = m_Blocks[slot.block];
+
+	BufferRange result;
+	result.buffer = block.buffer;
+	result.offset = slot.offset;
+	result.size = slot.size;
+	result.mapped = block.mapped ? (byte*)block.mapped + slot.offset : nullptr;
+	return result;
+}
+
+uint32 BufferAllocator::PickDefragmentBlock() const
+{
+	// The emptiest block, as long as the others have room for everything in it
+	uint32 result = UINT32_MAX;
+	vk::DeviceSize totalFree = 0;
+
+	for (uint32 index = 0; index < m_Blocks.size(); index++)
+	{
+		const Block& block = m_Blocks[index];
+		if (!block.buffer || block.retiring)
+			continue;
+
+		totalFree += block.size - block.allocatedBytes;
+
+		if (block.allocationCount > 0 && block.allocatedBytes <= block.size * DEFRAGMENT_MAX_BLOCK_USAGE &&
+			(result == UINT32_MAX || block.allocatedBytes < m_Blocks[result].allocatedBytes))
+			result = index;
+	}
+
+	if (result == UINT32_MAX)
+		return UINT32_MAX;
+
+	const Block& candidate = m_Blocks[result];
+	if (totalFree - (candidate.size - candidate.allocatedBytes) < candidate.allocatedBytes)
+		return UINT32_MAX;
+
+	return result;
+}
+
+vk::DeviceSize BufferAllocator::Defragment(vk::CommandBuffer commandBuffer, vk::DeviceSize maxBytes)
+{
+	if (m_DefragmentBlock == UINT32_MAX)
+	{
+		m_DefragmentBlock = PickDefragmentBlock();
+		if (m_DefragmentBlock == UINT32_MAX)
+			return 0;
+
+		m_Blocks[m_DefragmentBlock].retiring = true;
+	}
+
+	vk::DeviceSize movedBytes = 0;
+	bool recorded = false;
+	bool drained = true;
+
+	for (uint32 slotIndex = 0; slotIndex < m_Slots.size(); slotIndex++)
+	{
+		Slot& slot = m_Slots[slotIndex];
+		if (!slot.live || slot.block != m_DefragmentBlock)
+			continue;
+
+		if (movedBytes >= maxBytes)
+		{
+			drained = false;
+			break;
+		}
+
+		uint32 dstBlock;
+		vk::DeviceSize dstOffset;
+		if (!AllocateRange(slot.size, false, dstBlock, dstOffset))
+		{
+			// The other blocks filled up in the meantime, the block goes back to normal use
+			m_Blocks[m_DefragmentBlock].retiring = false;
+			break;
+		}
+
+		if (!recorded)
+		{
+			// Writes from earlier in the queue have to land before they are copied away
+			vk::MemoryBarrier barrier(vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, 
+										  vk::DependencyFlags(), barrier, nullptr, nullptr, GetDispatch());
+			recorded = true;
+		}
+
+		commandBuffer.copyBuffer(m_Blocks[slot.block].buffer, m_Blocks[dstBlock].buffer, 
+								 vk::BufferCopy(slot.offset, dstOffset, slot.size), GetDispatch());
+
+		// The old copy stays readable for the frames in flight and this frame's copy
+		m_PendingFrees[m_FrameIndex].push_back({ slot.block, { slot.offset, slot.size } });
+
+		slot.block = dstBlock;
+		slot.offset = dstOffset;
+
+		movedBytes += slot.size;
+		m_Stats.movedBytes += slot.size;
+		m_Stats.movedAllocations++;
+	}
+
+	// Either way the next call picks a new block. A drained one stays retired until the frames
+	// using its old contents are done, then BeginFrame gives it back
+	if (drained || !m_Blocks[m_DefragmentBlock].retiring)
+		m_DefragmentBlock = UINT32_MAX;
+
+	if (recorded)
+	{
+		vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, 
+									  vk::DependencyFlags(), barrier, nullptr, nullptr, GetDispatch());
+	}
+
+	return movedBytes;
+}
+
+const BufferAllocatorStats& BufferAllocator::GetStats()
+{
+	m_Stats.blockCount = 0;
+	m_Stats.allocationCount = 0;
+	m_Stats.blockBytes = 0;
+	m_Stats.allocatedBytes = 0;
+
+	vk::DeviceSize freeBytes = 0;
+	vk::DeviceSize largestFree = 0;
+
+	for (const Block& block : m_Blocks)
+	{
+		if (!block.buffer)
+			continue;
+
+		m_Stats.blockCount++;
+		m_Stats.blockBytes += block.size;
+
+		for (const FreeRange& range : block.freeRanges)
+		{
+			freeBytes += range.size;
+			largestFree = std::max(largestFree, range.size);
+		}
+	}
+
+	for (const Slot& slot : m_Slots)
+	{
+		if (!slot.live)
+			continue;
+
+		m_Stats.allocationCount++;
+		m_Stats.allocatedBytes += slot.size;
+	}
+
+	m_Stats.fragmentation = freeBytes > 0 ? 1.0f - (float)largestFree / freeBytes : 0.0f;
+	return m_Stats;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+
+class Renderer;
+
+const vk::DeviceSize BUFFER_BLOCK_SIZE = 16 * 1024 * 1024;
+
+// How much the defragmenter copies per frame at most
+const vk::DeviceSize DEFRAGMENT_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
+// Refers to a sub-allocation through the allocator's slot table, so the allocation can move
+// without its owner noticing. A freed handle's slot gets a new generation, stale handles assert
+struct BufferHandle
+{
+	uint32 index = UINT32_MAX;
+	uint32 generation = 0;
+
+	bool IsValid() const { return index != UINT32_MAX; }
+};
+
+// Where a handle lives right now. Only valid for the frame it was resolved in, the defragmenter
+// may move it at the start of the next one
+struct BufferRange
+{
+	vk::Buffer buffer;
+	vk::DeviceSize offset;
+	vk::DeviceSize size;
+
+	// Only for host visible allocators
+	void* mapped;
+};
+
+struct BufferAllocatorStats
+{
+	uint32 blockCount;
+	uint32 allocationCount;
+
+	vk::DeviceSize blockBytes;
+	vk::DeviceSize allocatedBytes;
+
+	// Free space outside of the largest free range, relative to all free space
+	float fragmentation;
+
+	uint64 movedBytes;
+	uint32 movedAllocations;
+	uint32 freedBlocks;
+};
+
+// Sub-allocates buffers with the same usage and memory properties out of large blocks, each block
+// is one vk::Buffer over one allocation. Frees are deferred until the frame that made them is no
+// longer in flight, blocks that end up empty are given back then.
+//
+// After hours of streaming the blocks are full of holes, Defragment picks the emptiest block and
+// moves its allocations into the others with GPU copies, a few MB per frame so the frame loop never
+// waits on it. Owners keep their handles and resolve them again every frame. Render thread only
+class BufferAllocator
+{
+private:
+	struct FreeRange
+	{
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+	};
+
+	struct Block
+	{
+		vk::Buffer buffer;
+		vk::DeviceMemory memory;
+		vk::DeviceSize size;
+		void* mapped;
+
+		// Sorted by offset, neighbours are merged
+		std::vector<FreeRange> freeRanges;
+		vk::DeviceSize allocatedBytes;
+		uint32 allocationCount;
+
+		// Being emptied by the defragmenter, nothing new goes in and it's given back once empty
+		bool retiring;
+	};
+
+	struct Slot
+	{
+		uint32 generation;
+		bool live;
+
+		uint32 block;
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+	};
+
+	struct PendingFree
+	{
+		uint32 block;
+		FreeRange range;
+	};
+
+	Renderer* m_Renderer;
+
+	vk::BufferUsageFlags m_Usage;
+	vk::MemoryPropertyFlags m_Properties;
+	vk::DeviceSize m_Alignment;
+
+	// Destroyed blocks leave a null buffer behind so block indices stay stable
+	std::vector<Block> m_Blocks;
+
+	std::vector<Slot> m_Slots;
+	std::vector<uint32> m_FreeSlots;
+
+	std::vector<std::vector<PendingFree>> m_PendingFrees;
+	uint32 m_FrameIndex;
+
+	// The block whose allocations are being moved out
+	uint32 m_DefragmentBlock;
+
+	BufferAllocatorStats m_Stats;
+private:
+	uint32 CreateBlock(vk::DeviceSize size);
+	void DestroyBlock(uint32 blockIndex);
+
+	bool AllocateFromBlock(uint32 blockIndex, vk::DeviceSize size, vk::DeviceSize& outOffset);
+	void FreeToBlock(uint32 blockIndex, const FreeRange& range);
+	bool AllocateRange(vk::DeviceSize size, bool allowNewBlock, uint32& outBlock, vk::DeviceSize& outOffset);
+
+	uint32 PickDefragmentBlock() const;
+public:
+	BufferAllocator(Renderer* renderer, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, uint32 framesInFlight);
+	~BufferAllocator();
+
+	// Releases the frees made the last time this frame index was used and gives back empty blocks
+	void BeginFrame(uint32 frameIndex);
+
+	BufferHandle Allocate(vk::DeviceSize size);
+	void Free(BufferHandle& handle);
+
+	BufferRange Resolve(BufferHandle handle) const;
+
+	// Records the copies for one step of defragmentation, call at the start of the frame's command
+	// buffer before anything resolves handles. Returns the bytes moved
+	vk::DeviceSize Defragment(vk::CommandBuffer commandBuffer, vk::DeviceSize maxBytes = DEFRAGMENT_BYTES_PER_FRAME);
+
+	const BufferAllocatorStats& GetStats();
+};
\ No newline at end of file
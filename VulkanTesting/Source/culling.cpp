@@ -0,0 +1,147 @@
+#include "culling.h"
+
+#include "renderer.h"
+#include "shader.h"
+
+const uint32 CULL_GROUP_SIZE = 64;
+
+struct CullPushConstants
+{
+	Vector4f planes[6];
+	uint32 objectCount;
+};
+
+Frustum ExtractFrustum(const Matrix4f& viewProjection)
+{
+	// The columns of the transposed matrix are the rows of the original
+	Matrix4f rows = viewProjection.Transposed();
+
+	Frustum result = {};
+	result.planes[0] = rows.columns[3] + rows.columns[0]; // Left
+	result.planes[1] = rows.columns[3] - rows.columns[0]; // Right
+	result.planes[2] = rows.columns[3] + rows.columns[1]; // Top
+	result.planes[3] = rows.columns[3] - rows.columns[1]; // Bottom
+	result.planes[4] = rows.columns[2];                   // Near
+	result.planes[5] = rows.columns[3] - rows.columns[2]; // Far
+
+	for (Vector4f& plane : result.planes)
+		plane = plane * (1.0f / plane.XYZ().Length());
+
+	return result;
+}
+
+GpuCuller::GpuCuller(Renderer* renderer, uint32 maxObjects)
+	: m_Renderer(renderer), m_MaxObjects(maxObjects), m_ObjectCount(0)
+{
+	vk::Device device = renderer->GetDevice();
+
+	// Every surviving object is drawn with firstInstance set to its index, which is the only link between
+	// a compacted draw and its instance data. Without the feature it has to be 0 in every command
+	if (!renderer->GetEnabledFeatures().drawIndirectFirstInstance)
+		throw std::runtime_error("GPU culling needs the drawIndirectFirstInstance feature!");
+
+	m_ObjectBuffer = CreateBuffer(renderer, sizeof(CullObject) * maxObjects, 
+								  vk::BufferUsageFlagBits::eStorageBuffer, 
+								  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	m_DrawCommandBuffer = CreateBuffer(renderer, sizeof(VkDrawIndexedIndirectCommand) * maxObjects, 
+									   vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst, 
+									   vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+	m_DrawCountBuffer = CreateBuffer(renderer, sizeof(uint32), 
+									 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst, 
+									 vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+	SetObjectName(device, m_ObjectBuffer.buffer, "Cull objects");
+	SetObjectName(device, m_DrawCommandBuffer.buffer, "Cull draw commands");
+	SetObjectName(device, m_DrawCountBuffer.buffer, "Cull draw count");
+
+	m_ShaderModule = CompileShader(device, "Resources/cull.comp", shaderc_shader_kind::shaderc_compute_shader);
+	m_Pipeline = CreateComputePipeline(device, m_ShaderModule, 
+									   { GetDescriptorBuilder().BuildLayout() }, 
+									   { vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullPushConstants)) });
+
+	SetObjectName(device, m_Pipeline.pipeline, "Cull");
+
+	m_DrawIndexedIndirectCount = nullptr;
+	if (renderer->IsDeviceExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+		m_DrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)device.getProcAddr("vkCmdDrawIndexedIndirectCountKHR");
+}
+
+GpuCuller::~GpuCuller()
+{
+	vk::Device device = m_Renderer->GetDevice();
+
+	device.destroyPipeline(m_Pipeline.pipeline, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+	device.destroyPipelineLayout(m_Pipeline.layout, GetAllocationCallbacks(vk::ObjectType::ePipelineLayout));
+	device.destroyShaderModule(m_ShaderModule, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+
+	DestroyBuffer(m_Renderer, m_ObjectBuffer);
+	DestroyBuffer(m_Renderer, m_DrawCommandBuffer);
+	DestroyBuffer(m_Renderer, m_DrawCountBuffer);
+}
+
+DescriptorBuilder GpuCuller::GetDescriptorBuilder()
+{
+	DescriptorBuilder builder(m_Renderer->GetDescriptorLayoutCache(), m_Renderer->GetDescriptorAllocator());
+	builder.BindBuffer(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBufferInfo(m_ObjectBuffer.buffer, 0, VK_WHOLE_SIZE));
+	builder.BindBuffer(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBufferInfo(m_DrawCommandBuffer.buffer, 0, VK_WHOLE_SIZE));
+	builder.BindBuffer(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBufferInfo(m_DrawCountBuffer.buffer, 0, VK_WHOLE_SIZE));
+
+	return builder;
+}
+
+void GpuCuller::SetObjects(const CullObject* objects, uint32 count)
+{
+	assert(count <= m_MaxObjects);
+
+	memcpy(m_ObjectBuffer.mapped, objects, sizeof(CullObject) * count);
+	m_ObjectCount = count;
+}
+
+void GpuCuller::Cull(vk::CommandBuffer commandBuffer, const Frustum& frustum)
+{
+	if (m_ObjectCount == 0)
+		return;
+
+	commandBuffer.fillBuffer(m_DrawCountBuffer.buffer, 0, sizeof(uint32), 0, GetDispatch());
+
+	// Without a GPU side count every slot is drawn, culled slots have to be zero instance draws
+	if (!m_DrawIndexedIndirectCount)
+		commandBuffer.fillBuffer(m_DrawCommandBuffer.buffer, 0, sizeof(VkDrawIndexedIndirectCommand) * m_ObjectCount, 0, GetDispatch());
+
+	vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, 
+								  vk::DependencyFlags(), { clearBarrier }, nullptr, nullptr, GetDispatch());
+
+	CullPushConstants pushConstants = {};
+	memcpy(pushConstants.planes, frustum.planes, sizeof(pushConstants.planes));
+	pushConstants.objectCount = m_ObjectCount;
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipeline.pipeline, GetDispatch());
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_Pipeline.layout, 0, { GetDescriptorBuilder().Build() }, nullptr, GetDispatch());
+	commandBuffer.pushConstants(m_Pipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullPushConstants), &pushConstants, GetDispatch());
+	commandBuffer.dispatch((m_ObjectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1, GetDispatch());
+}
+
+void GpuCuller::Draw(vk::CommandBuffer commandBuffer)
+{
+	if (m_ObjectCount == 0)
+		return;
+
+	uint32 stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (m_DrawIndexedIndirectCount)
+	{
+		m_DrawIndexedIndirectCount((VkCommandBuffer)commandBuffer, (VkBuffer)m_DrawCommandBuffer.buffer, 0, (VkBuffer)m_DrawCountBuffer.buffer, 0, m_ObjectCount, stride);
+	}
+	else if (m_Renderer->GetEnabledFeatures().multiDrawIndirect)
+	{
+		commandBuffer.drawIndexedIndirect(m_DrawCommandBuffer.buffer, 0, m_ObjectCount, stride, GetDispatch());
+	}
+	else
+	{
+		for (uint32 index = 0; index < m_ObjectCount; index++)
+			commandBuffer.drawIndexedIndirect(m_DrawCommandBuffer.buffer, index * stride, 1, stride, GetDispatch());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "buffer.h"
+#include "mesh.h"
+#include "pipeline.h"
+#include "descriptor.h"
+
+// Matches the CullObject struct in cull.comp (std430)
+struct CullObject
+{
+	Vector3f center;
+	float radius;
+
+	uint32 indexCount;
+	uint32 firstIndex;
+	int32 vertexOffset;
+	uint32 padding;
+};
+
+// Plane equations are stored as normal in xyz and distance in w, normals point into the frustum
+struct Frustum
+{
+	Vector4f planes[6];
+};
+
+// Extracts the planes from a view projection matrix with a 0 to 1 depth range
+Frustum ExtractFrustum(const Matrix4f& viewProjection);
+
+// Culls bounding spheres against the frustum in a compute shader and compacts the survivors
+// into a VkDrawIndexedIndirectCommand buffer. Object N is drawn with firstInstance N so the
+// per-instance vertex buffer lines up with the object list, which needs drawIndirectFirstInstance
+class GpuCuller
+{
+private:
+	Renderer* m_Renderer;
+
+	uint32 m_MaxObjects;
+	uint32 m_ObjectCount;
+
+	Buffer m_ObjectBuffer;
+	Buffer m_DrawCommandBuffer;
+	Buffer m_DrawCountBuffer;
+
+	vk::ShaderModule m_ShaderModule;
+	Pipeline m_Pipeline;
+
+	PFN_vkCmdDrawIndexedIndirectCountKHR m_DrawIndexedIndirectCount;
+private:
+	DescriptorBuilder GetDescriptorBuilder();
+public:
+	GpuCuller(Renderer* renderer, uint32 maxObjects);
+	~GpuCuller();
+
+	// Objects live in a host visible buffer, only update them when no frame using them is in flight
+	void SetObjects(const CullObject* objects, uint32 count);
+
+	// Records the culling dispatch, must be called outside of a render pass. The draw buffers are
+	// cleared with a transfer and then written by the compute shader, synchronizing them against the
+	// draws of the previous and this frame is up to the caller (see the render graph in main)
+	void Cull(vk::CommandBuffer commandBuffer, const Frustum& frustum);
+
+	// Records the indirect draws, the caller binds pipeline, vertex and index buffers
+	void Draw(vk::CommandBuffer commandBuffer);
+
+	vk::Buffer GetDrawCommandBuffer() const { return m_DrawCommandBuffer.buffer; }
+	vk::Buffer GetDrawCountBuffer() const { return m_DrawCountBuffer.buffer; }
+};
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "debuglog.h"
+
+#include "hash.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+DebugMessageRing::DebugMessageRing()
+	: m_WriteIndex(0), m_ReadIndex(0)
+{
+	for (uint32 index = 0; index < DEBUG_RING_CAPACITY; index++)
+		m_Cells[index].sequence.store(index, std::memory_order_relaxed);
+}
+
+bool DebugMessageRing::Push(DebugSeverity severity, int32 messageCode, const char* text)
+{
+	uint32 writeIndex = m_WriteIndex.load(std::memory_order_relaxed);
+
+	Cell* cell;
+	while (true)
+	{
+		cell = &m_Cells[writeIndex % DEBUG_RING_CAPACITY];
+		uint32 sequence = cell->sequence.load(std::memory_order_acquire);
+		int32 difference = (int32)(sequence - writeIndex);
+
+		if (difference == 0)
+		{
+			// The cell is free for this lap, claim it by moving the write index past it
+			if (m_WriteIndex.compare_exchange_weak(writeIndex, writeIndex + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// The consumer hasn't freed the cell from the previous lap yet
+			return false;
+		}
+		else
+		{
+			writeIndex = m_WriteIndex.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->message.severity = severity;
+	cell->message.messageCode = messageCode;
+	strncpy(cell->message.text, text, DEBUG_MESSAGE_MAX_LENGTH - 1);
+	cell->message.text[DEBUG_MESSAGE_MAX_LENGTH - 1] = 0;
+
+	cell->sequence.store(writeIndex + 1, std::memory_order_release);
+	return true;
+}
+
+bool DebugMessageRing::Pop(DebugMessage& message)
+{
+	Cell* cell = &m_Cells[m_ReadIndex % DEBUG_RING_CAPACITY];
+	uint32 sequence = cell->sequence.load(std::memory_order_acquire);
+
+	if (sequence != m_ReadIndex + 1)
+		return false;
+
+	message = cell->message;
+
+	// Free again for the producer one lap ahead
+	cell->sequence.store(m_ReadIndex + DEBUG_RING_CAPACITY, std::memory_order_release);
+	m_ReadIndex++;
+
+	return true;
+}
+
+DebugLogger::DebugLogger()
+	: m_Quit(false), m_DroppedCount(0), m_ErrorCount(0), m_Tokens(DEBUG_MESSAGES_PER_SECOND), m_RateLimitedCount(0)
+{
+	m_Thread = std::thread(&DebugLogger::ThreadLoop, this);
+}
+
+DebugLogger::~DebugLogger()
+{
+	m_Quit = true;
+	m_Thread.join();
+
+	PrintSummary();
+}
+
+void DebugLogger::Post(DebugSeverity severity, int32 messageCode, const char* text)
+{
+	if (severity == DebugSeverity::Error)
+		m_ErrorCount++;
+
+	if (!m_Ring.Push(severity, messageCode, text))
+		m_DroppedCount++;
+}
+
+void DebugLogger::ThreadLoop()
+{
+	auto last = std::chrono::steady_clock::now();
+
+	while (true)
+	{
+		// Read before draining so nothing posted ahead of the quit is left behind
+		bool quit = m_Quit.load();
+
+		auto now = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed = now - last;
+		last = now;
+
+		Refill(elapsed.count());
+
+		DebugMessage message;
+		while (m_Ring.Pop(message))
+			Process(message);
+
+		if (quit)
+			break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+void DebugLogger::Refill(double elapsedSeconds)
+{
+	m_Tokens += elapsedSeconds * DEBUG_MESSAGES_PER_SECOND;
+	if (m_Tokens < DEBUG_MESSAGES_PER_SECOND)
+		return;
+
+	m_Tokens = DEBUG_MESSAGES_PER_SECOND;
+
+	if (m_RateLimitedCount > 0)
+	{
+		fprintf(stderr, "[validation] %u messages suppressed by rate limit\n", m_RateLimitedCount);
+		m_RateLimitedCount = 0;
+	}
+}
+
+void DebugLogger::Process(const DebugMessage& message)
+{
+	// Layers don't give every message a code, those are told apart by their text
+	uint64 key = message.messageCode != 0 ? HashValue(message.messageCode) : HashBytes(message.text, strlen(message.text));
+	SeenMessage& seen = m_SeenMessages[key];
+	seen.messageCode = message.messageCode;
+	if (seen.count++ > 0)
+		return;
+
+	if (m_Tokens < 1.0)
+	{
+		m_RateLimitedCount++;
+		return;
+	}
+
+	m_Tokens -= 1.0;
+
+	const char* prefix = "";
+	switch (message.severity)
+	{
+	case DebugSeverity::Info: prefix = "Info"; break;
+	case DebugSeverity::Warning: prefix = "Warning"; break;
+	case DebugSeverity::Performance: prefix = "Performance"; break;
+	case DebugSeverity::Error: prefix = "Error"; break;
+	}
+
+	FILE* output = message.severity == DebugSeverity::Error ? stderr : stdout;
+	fprintf(output, "[validation] %s (%d): %s\n", prefix, message.messageCode, message.text);
+}
+
+void DebugLogger::PrintSummary()
+{
+	for (auto& entry : m_SeenMessages)
+	{
+		if (entry.second.count > 1)
+			fprintf(stdout, "[validation] message %d repeated %u times\n", entry.second.messageCode, entry.second.count);
+	}
+
+	uint32 dropped = m_DroppedCount.load();
+	if (dropped > 0)
+		fprintf(stderr, "[validation] %u messages dropped, the ring was full\n", dropped);
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+#include "types.h"
+
+const uint32 DEBUG_MESSAGE_MAX_LENGTH = 1024;
+const uint32 DEBUG_RING_CAPACITY = 256;
+const uint32 DEBUG_MESSAGES_PER_SECOND = 20;
+
+enum class DebugSeverity
+{
+	Info,
+	Warning,
+	Performance,
+	Error,
+};
+
+struct DebugMessage
+{
+	DebugSeverity severity;
+	int32 messageCode;
+	char text[DEBUG_MESSAGE_MAX_LENGTH];
+};
+
+// Bounded multi producer, single consumer queue. Every cell carries a sequence number that says
+// whether it is free for the producer of that lap or full for the consumer, so pushing is one
+// compare exchange on the write index and never blocks. A full ring drops the message
+class DebugMessageRing
+{
+private:
+	struct Cell
+	{
+		std::atomic<uint32> sequence;
+		DebugMessage message;
+	};
+
+	Cell m_Cells[DEBUG_RING_CAPACITY];
+
+	std::atomic<uint32> m_WriteIndex;
+	uint32 m_ReadIndex;
+public:
+	DebugMessageRing();
+
+	bool Push(DebugSeverity severity, int32 messageCode, const char* text);
+
+	// Consumer thread only
+	bool Pop(DebugMessage& message);
+};
+
+// Takes validation messages from whatever thread the layers call back on and prints them from its
+// own thread. Repeats of a message code are only counted, and printing is rate limited so a flood of
+// messages can't drown the log. Nothing on the calling thread waits on output
+class DebugLogger
+{
+private:
+	DebugMessageRing m_Ring;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_Quit;
+
+	std::atomic<uint32> m_DroppedCount;
+	std::atomic<uint32> m_ErrorCount;
+
+	struct SeenMessage
+	{
+		int32 messageCode;
+		uint32 count;
+	};
+
+	// Logger thread only
+	std::unordered_map<uint64, SeenMessage> m_SeenMessages;
+	double m_Tokens;
+	uint32 m_RateLimitedCount;
+private:
+	void ThreadLoop();
+	void Refill(double elapsedSeconds);
+	void Process(const DebugMessage& message);
+	void PrintSummary();
+public:
+	DebugLogger();
+
+	// Drains what is left before returning
+	~DebugLogger();
+
+	void Post(DebugSeverity severity, int32 messageCode, const char* text);
+
+	uint32 GetDroppedCount() const { return m_DroppedCount.load(); }
+	uint32 GetErrorCount() const { return m_ErrorCount.load(); }
+};
\ No newline at end of file
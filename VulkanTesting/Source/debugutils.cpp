@@ -0,0 +1,73 @@
+#include "debugutils.h"
+
+#ifdef DEBUG_UTILS_ENABLED
+
+PFN_vkSetDebugUtilsObjectNameEXT SetDebugUtilsObjectName;
+PFN_vkCmdBeginDebugUtilsLabelEXT CmdBeginDebugUtilsLabel;
+PFN_vkCmdEndDebugUtilsLabelEXT CmdEndDebugUtilsLabel;
+PFN_vkCmdInsertDebugUtilsLabelEXT CmdInsertDebugUtilsLabel;
+
+static void FillLabel(VkDebugUtilsLabelEXT& label, const char* name, const float* color)
+{
+	label = {};
+	label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+	label.pLabelName = name;
+
+	for (uint32 index = 0; index < 4; index++)
+		label.color[index] = color ? color[index] : 0.0f;
+}
+
+void LoadDebugUtils(vk::Instance instance)
+{
+	// Null when VK_EXT_debug_utils isn't enabled on the instance
+	SetDebugUtilsObjectName = (PFN_vkSetDebugUtilsObjectNameEXT)instance.getProcAddr("vkSetDebugUtilsObjectNameEXT");
+	CmdBeginDebugUtilsLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)instance.getProcAddr("vkCmdBeginDebugUtilsLabelEXT");
+	CmdEndDebugUtilsLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)instance.getProcAddr("vkCmdEndDebugUtilsLabelEXT");
+	CmdInsertDebugUtilsLabel = (PFN_vkCmdInsertDebugUtilsLabelEXT)instance.getProcAddr("vkCmdInsertDebugUtilsLabelEXT");
+}
+
+void SetObjectName(vk::Device device, vk::ObjectType type, uint64 handle, const char* name)
+{
+	if (!SetDebugUtilsObjectName)
+		return;
+
+	VkDebugUtilsObjectNameInfoEXT nameInfo = {};
+	nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+	nameInfo.objectType = (VkObjectType)type;
+	nameInfo.objectHandle = handle;
+	nameInfo.pObjectName = name;
+
+	SetDebugUtilsObjectName((VkDevice)device, &nameInfo);
+}
+
+void BeginLabel(vk::CommandBuffer commandBuffer, const char* name, const float* color)
+{
+	if (!CmdBeginDebugUtilsLabel)
+		return;
+
+	VkDebugUtilsLabelEXT label;
+	FillLabel(label, name, color);
+
+	CmdBeginDebugUtilsLabel((VkCommandBuffer)commandBuffer, &label);
+}
+
+void EndLabel(vk::CommandBuffer commandBuffer)
+{
+	if (!CmdEndDebugUtilsLabel)
+		return;
+
+	CmdEndDebugUtilsLabel((VkCommandBuffer)commandBuffer);
+}
+
+void InsertLabel(vk::CommandBuffer commandBuffer, const char* name, const float* color)
+{
+	if (!CmdInsertDebugUtilsLabel)
+		return;
+
+	VkDebugUtilsLabelEXT label;
+	FillLabel(label, name, color);
+
+	CmdInsertDebugUtilsLabel((VkCommandBuffer)commandBuffer, &label);
+}
+
+#endif
\ No newline at end of file
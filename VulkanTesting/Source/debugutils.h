@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+
+// Object names and command buffer labels from VK_EXT_debug_utils, they show up in validation
+// messages and in captures. Everything here compiles to nothing in release builds unless
+// DEBUG_UTILS_ENABLED is defined by hand
+
+#if !defined(NDEBUG) && !defined(DEBUG_UTILS_ENABLED)
+#define DEBUG_UTILS_ENABLED
+#endif
+
+#ifdef DEBUG_UTILS_ENABLED
+
+// Calls are ignored until the entry points are loaded, and when the extension isn't enabled
+void LoadDebugUtils(vk::Instance instance);
+
+void SetObjectName(vk::Device device, vk::ObjectType type, uint64 handle, const char* name);
+
+void BeginLabel(vk::CommandBuffer commandBuffer, const char* name, const float* color = nullptr);
+void EndLabel(vk::CommandBuffer commandBuffer);
+void InsertLabel(vk::CommandBuffer commandBuffer, const char* name, const float* color = nullptr);
+
+#else
+
+inline void LoadDebugUtils(vk::Instance instance) {}
+
+inline void SetObjectName(vk::Device device, vk::ObjectType type, uint64 handle, const char* name) {}
+
+inline void BeginLabel(vk::CommandBuffer commandBuffer, const char* name, const float* color = nullptr) {}
+inline void EndLabel(vk::CommandBuffer commandBuffer) {}
+inline void InsertLabel(vk::CommandBuffer commandBuffer, const char* name, const float* color = nullptr) {}
+
+#endif
+
+#define DEBUG_UTILS_OBJECT_NAME(HandleType) \
+	inline void SetObjectName(vk::Device device, vk::HandleType object, const char* name) \
+	{ \
+		SetObjectName(device, vk::ObjectType::e##HandleType, (uint64)(Vk##HandleType)object, name); \
+	}
+
+DEBUG_UTILS_OBJECT_NAME(Buffer)
+DEBUG_UTILS_OBJECT_NAME(Image)
+DEBUG_UTILS_OBJECT_NAME(ImageView)
+DEBUG_UTILS_OBJECT_NAME(Sampler)
+DEBUG_UTILS_OBJECT_NAME(DeviceMemory)
+DEBUG_UTILS_OBJECT_NAME(ShaderModule)
+DEBUG_UTILS_OBJECT_NAME(Pipeline)
+DEBUG_UTILS_OBJECT_NAME(PipelineLayout)
+DEBUG_UTILS_OBJECT_NAME(RenderPass)
+DEBUG_UTILS_OBJECT_NAME(Framebuffer)
+DEBUG_UTILS_OBJECT_NAME(DescriptorSet)
+DEBUG_UTILS_OBJECT_NAME(CommandBuffer)
+DEBUG_UTILS_OBJECT_NAME(QueryPool)
+DEBUG_UTILS_OBJECT_NAME(Semaphore)
+DEBUG_UTILS_OBJECT_NAME(Fence)
+
+#undef DEBUG_UTILS_OBJECT_NAME
+
+// Labels everything recorded while it is alive
+class DebugLabelScope
+{
+private:
+	vk::CommandBuffer m_CommandBuffer;
+public:
+	DebugLabelScope(vk::CommandBuffer commandBuffer, const char* name, const float* color = nullptr)
+		: m_CommandBuffer(commandBuffer)
+	{
+		BeginLabel(commandBuffer, name, color);
+	}
+
+	~DebugLabelScope()
+	{
+		EndLabel(m_CommandBuffer);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "descriptor.h"
+
+#include "hash.h"
+#include "hostallocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <assert.h>
+
+const uint32 SETS_PER_POOL = 256;
+
+// Initial slots in the per-frame set cache, doubled whenever it gets half full
+const uint32 DESCRIPTOR_SET_CACHE_SIZE = 256;
+
+// Descriptors per set for each type, scaled by SETS_PER_POOL when a pool is created
+const std::pair<vk::DescriptorType, float> POOL_SIZE_RATIOS[] = {
+	{ vk::DescriptorType::eSampler, 0.5f },
+	{ vk::DescriptorType::eCombinedImageSampler, 4.0f },
+	{ vk::DescriptorType::eSampledImage, 4.0f },
+	{ vk::DescriptorType::eStorageImage, 1.0f },
+	{ vk::DescriptorType::eUniformBuffer, 2.0f },
+	{ vk::DescriptorType::eUniformBufferDynamic, 1.0f },
+	{ vk::DescriptorType::eStorageBuffer, 3.0f },
+	{ vk::DescriptorType::eStorageBufferDynamic, 1.0f },
+};
+
+bool DescriptorLayoutKey::operator==(const DescriptorLayoutKey& other) const
+{
+	if (bindingCount != other.bindingCount)
+		return false;
+
+	for (uint32 index = 0; index < bindingCount; index++)
+	{
+		const vk::DescriptorSetLayoutBinding& a = bindings[index];
+		const vk::DescriptorSetLayoutBinding& b = other.bindings[index];
+
+		if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+			a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+			return false;
+	}
+
+	return true;
+}
+
+uint64 DescriptorLayoutKey::Hash() const
+{
+	uint64 hash = HASH_SEED;
+	for (uint32 index = 0; index < bindingCount; index++)
+	{
+		const vk::DescriptorSetLayoutBinding& binding = bindings[index];
+		hash = HashValue(binding.binding, hash);
+		hash = HashValue((uint32)binding.descriptorType, hash);
+		hash = HashValue(binding.descriptorCount, hash);
+		hash = HashValue((uint32)binding.stageFlags, hash);
+	}
+
+	return hash;
+}
+
+bool DescriptorSetKey::operator==(const DescriptorSetKey& other) const
+{
+	if (layout != other.layout || writeCount != other.writeCount)
+		return false;
+
+	for (uint32 index = 0; index < writeCount; index++)
+	{
+		const DescriptorWrite& a = writes[index];
+		const DescriptorWrite& b = other.writes[index];
+
+		if (a.binding != b.binding || a.type != b.type || a.bufferInfo != b.bufferInfo || a.imageInfo != b.imageInfo)
+			return false;
+	}
+
+	return true;
+}
+
+uint64 DescriptorSetKey::Hash() const
+{
+	uint64 hash = HashValue(layout);
+	for (uint32 index = 0; index < writeCount; index++)
+	{
+		const DescriptorWrite& write = writes[index];
+		hash = HashValue(write.binding, hash);
+		hash = HashValue(write.bufferInfo.buffer, hash);
+		hash = HashValue(write.bufferInfo.offset, hash);
+		hash = HashValue(write.bufferInfo.range, hash);
+		hash = HashValue(write.imageInfo.sampler, hash);
+		hash = HashValue(write.imageInfo.imageView, hash);
+		hash = HashValue((uint32)write.imageInfo.imageLayout, hash);
+	}
+
+	return hash;
+}
+
+DescriptorLayoutCache::DescriptorLayoutCache(vk::Device device)
+	: m_Device(device)
+{
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache()
+{
+	for (auto& entry : m_Layouts)
+		m_Device.destroyDescriptorSetLayout(entry.second, GetAllocationCallbacks(vk::ObjectType::eDescriptorSetLayout));
+}
+
+vk::DescriptorSetLayout DescriptorLayoutCache::GetLayout(vk::ArrayProxy<const vk::DescriptorSetLayoutBinding> bindings)
+{
+	assert(bindings.size() <= MAX_DESCRIPTOR_BINDINGS);
+
+	DescriptorLayoutKey key;
+	key.bindingCount = bindings.size();
+	std::copy(bindings.begin(), bindings.end(), key.bindings);
+
+	std::sort(key.bindings, key.bindings + key.bindingCount, [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b)
+	{
+		return a.binding < b.binding;
+	});
+
+	auto it = m_Layouts.find(key);
+	if (it != m_Layouts.end())
+		return it->second;
+
+	vk::DescriptorSetLayoutCreateInfo layoutCreateInfo(vk::DescriptorSetLayoutCreateFlags(), key.bindingCount, key.bindings);
+	vk::DescriptorSetLayout layout = m_Device.createDescriptorSetLayout(layoutCreateInfo, GetAllocationCallbacks(vk::ObjectType::eDescriptorSetLayout));
+
+	m_Layouts[key] = layout;
+	return layout;
+}
+
+DescriptorAllocator::DescriptorAllocator(vk::Device device, uint32 framesInFlight)
+	: m_Device(device), m_FrameIndex(0), m_PoolCount(0)
+{
+	m_Frames.resize(framesInFlight);
+	for (FrameData& frame : m_Frames)
+	{
+		frame.sets.resize(DESCRIPTOR_SET_CACHE_SIZE);
+		frame.setCount = 0;
+	}
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	for (FrameData& frame : m_Frames)
+	{
+		for (vk::DescriptorPool pool : frame.usedPools)
+			m_Device.destroyDescriptorPool(pool, GetAllocationCallbacks(vk::ObjectType::eDescriptorPool));
+	}
+
+	for (vk::DescriptorPool pool : m_FreePools)
+		m_Device.destroyDescriptorPool(pool, GetAllocationCallbacks(vk::ObjectType::eDescriptorPool));
+}
+
+vk::DescriptorPool DescriptorAllocator::GrabPool()
+{
+	if (!m_FreePools.empty())
+	{
+		vk::DescriptorPool pool = m_FreePools.back();
+		m_FreePools.pop_back();
+		return pool;
+	}
+
+	std::vector<vk::DescriptorPoolSize> poolSizes;
+	for (const auto& ratio : POOL_SIZE_RATIOS)
+		poolSizes.push_back(vk::DescriptorPoolSize(ratio.first, (uint32)(ratio.second * SETS_PER_POOL)));
+
+	vk::DescriptorPoolCreateInfo poolCreateInfo(vk::DescriptorPoolCreateFlags(), SETS_PER_POOL, (uint32)poolSizes.size(), poolSizes.data());
+
+	m_PoolCount++;
+	return m_Device.createDescriptorPool(poolCreateInfo, GetAllocationCallbacks(vk::ObjectType::eDescriptorPool));
+}
+
+void DescriptorAllocator::BeginFrame(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	FrameData& frame = m_Frames[frameIndex];
+
+	for (vk::DescriptorPool pool : frame.usedPools)
+	{
+		m_Device.resetDescriptorPool(pool);
+		m_FreePools.push_back(pool);
+	}
+
+	frame.usedPools.clear();
+	frame.currentPool = nullptr;
+
+	std::fill(frame.sets.begin(), frame.sets.end(), CachedSet());
+	frame.setCount = 0;
+}
+
+vk::DescriptorSet DescriptorAllocator::Allocate(vk::DescriptorSetLayout layout)
+{
+	FrameData& frame = m_Frames[m_FrameIndex];
+
+	if (!frame.currentPool)
+	{
+		frame.currentPool = GrabPool();
+		frame.usedPools.push_back(frame.currentPool);
+	}
+
+	vk::DescriptorSetAllocateInfo allocInfo(frame.currentPool, 1, &layout);
+
+	// Straight into a handle rather than the vector the enhanced overload returns
+	vk::DescriptorSet set;
+	vk::Result result = m_Device.allocateDescriptorSets(&allocInfo, &set);
+	if (result == vk::Result::eSuccess)
+		return set;
+
+	if (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool)
+		throw std::runtime_error("Failed to allocate descriptor set");
+
+	// The current pool is full, move on to the next one
+	frame.currentPool = GrabPool();
+	frame.usedPools.push_back(frame.currentPool);
+
+	allocInfo.setDescriptorPool(frame.currentPool);
+	if (m_Device.allocateDescriptorSets(&allocInfo, &set) != vk::Result::eSuccess)
+		throw std::runtime_error("Failed to allocate descriptor set");
+
+	return set;
+}
+
+vk::DescriptorSet DescriptorAllocator::FindCachedSet(const DescriptorSetKey& key, uint64 hash) const
+{
+	const FrameData& frame = m_Frames[m_FrameIndex];
+
+	// Empty slots have no set, a hash of 0 is as good as any other
+	uint32 mask = (uint32)frame.sets.size() - 1;
+	for (uint32 slot = (uint32)hash & mask; frame.sets[slot].set; slot = (slot + 1) & mask)
+	{
+		if (frame.sets[slot].hash == hash && frame.sets[slot].key == key)
+			return frame.sets[slot].set;
+	}
+
+	return nullptr;
+}
+
+void DescriptorAllocator::AddCachedSet(const DescriptorSetKey& key, uint64 hash, vk::DescriptorSet set)
+{
+	FrameData& frame = m_Frames[m_FrameIndex];
+
+	if ((frame.setCount + 1) * 2 > frame.sets.size())
+	{
+		std::vector<CachedSet> old(frame.sets.size() * 2);
+		old.swap(frame.sets);
+
+		frame.setCount = 0;
+		for (const CachedSet& entry : old)
+		{
+			if (entry.set)
+				AddCachedSet(entry.key, entry.hash, entry.set);
+		}
+	}
+
+	uint32 mask = (uint32)frame.sets.size() - 1;
+	uint32 slot = (uint32)hash & mask;
+	while (frame.sets[slot].set && !(frame.sets[slot].hash == hash && frame.sets[slot].key == key))
+		slot = (slot + 1) & mask;
+
+	if (!frame.sets[slot].set)
+		frame.setCount++;
+
+	frame.sets[slot].hash = hash;
+	frame.sets[slot].key = key;
+	frame.sets[slot].set = set;
+}
+
+DescriptorBuilder::DescriptorBuilder(DescriptorLayoutCache* layoutCache, DescriptorAllocator* allocator)
+	: m_LayoutCache(layoutCache), m_Allocator(allocator), m_BindingCount(0)
+{
+}
+
+DescriptorBuilder& DescriptorBuilder::BindBuffer(uint32 binding, vk::DescriptorType type, vk::ShaderStageFlags stages, const vk::DescriptorBufferInfo& bufferInfo)
+{
+	assert(m_BindingCount < MAX_DESCRIPTOR_BINDINGS);
+	m_Bindings[m_BindingCount] = vk::DescriptorSetLayoutBinding(binding, type, 1, stages, nullptr);
+
+	DescriptorWrite& write = m_Key.writes[m_BindingCount++];
+	write = {};
+	write.binding = binding;
+	write.type = type;
+	write.bufferInfo = bufferInfo;
+
+	return *this;
+}
+
+DescriptorBuilder& DescriptorBuilder::BindImage(uint32 binding, vk::DescriptorType type, vk::ShaderStageFlags stages, const vk::DescriptorImageInfo& imageInfo)
+{
+	assert(m_BindingCount < MAX_DESCRIPTOR_BINDINGS);
+	m_Bindings[m_BindingCount] = vk::DescriptorSetLayoutBinding(binding, type, 1, stages, nullptr);
+
+	DescriptorWrite& write = m_Key.writes[m_BindingCount++];
+	write = {};
+	write.binding = binding;
+	write.type = type;
+	write.imageInfo = imageInfo;
+
+	return *this;
+}
+
+vk::DescriptorSetLayout DescriptorBuilder::BuildLayout()
+{
+	return m_LayoutCache->GetLayout(vk::ArrayProxy<const vk::DescriptorSetLayoutBinding>(m_BindingCount, m_Bindings));
+}
+
+vk::DescriptorSet DescriptorBuilder::Build()
+{
+	vk::DescriptorSetLayout layout;
+	return Build(layout);
+}
+
+vk::DescriptorSet DescriptorBuilder::Build(vk::DescriptorSetLayout& outLayout)
+{
+	outLayout = BuildLayout();
+
+	m_Key.layout = outLayout;
+	m_Key.writeCount = m_BindingCount;
+	uint64 hash = m_Key.Hash();
+
+	vk::DescriptorSet set = m_Allocator->FindCachedSet(m_Key, hash);
+	if (set)
+		return set;
+
+	set = m_Allocator->Allocate(outLayout);
+
+	vk::WriteDescriptorSet writes[MAX_DESCRIPTOR_BINDINGS];
+	for (uint32 index = 0; index < m_BindingCount; index++)
+	{
+		const DescriptorWrite& write = m_Key.writes[index];
+		bool isImage = write.type == vk::DescriptorType::eSampler || write.type == vk::DescriptorType::eCombinedImageSampler ||
+					   write.type == vk::DescriptorType::eSampledImage || write.type == vk::DescriptorType::eStorageImage;
+
+		writes[index] = vk::WriteDescriptorSet(set, write.binding, 0, 1, write.type, 
+											   isImage ? &write.imageInfo : nullptr, 
+											   isImage ? nullptr : &write.bufferInfo, 
+											   nullptr);
+	}
+
+	m_Allocator->GetDevice().updateDescriptorSets(vk::ArrayProxy<const vk::WriteDescriptorSet>(m_BindingCount, writes), nullptr);
+	m_Allocator->AddCachedSet(m_Key, hash, set);
+
+	return set;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <unordered_map>
+
+#include "types.h"
+
+const uint32 MAX_DESCRIPTOR_BINDINGS = 16;
+
+struct DescriptorLayoutKey
+{
+	// Sorted by binding index, immutable samplers are not supported
+	vk::DescriptorSetLayoutBinding bindings[MAX_DESCRIPTOR_BINDINGS];
+	uint32 bindingCount;
+
+	bool operator==(const DescriptorLayoutKey& other) const;
+	uint64 Hash() const;
+};
+
+struct DescriptorLayoutKeyHasher
+{
+	size_t operator()(const DescriptorLayoutKey& key) const { return (size_t)key.Hash(); }
+};
+
+struct DescriptorWrite
+{
+	uint32 binding;
+	vk::DescriptorType type;
+	vk::DescriptorBufferInfo bufferInfo;
+	vk::DescriptorImageInfo imageInfo;
+};
+
+// Everything a built set is made of, two sets with equal keys can share one allocation
+struct DescriptorSetKey
+{
+	vk::DescriptorSetLayout layout;
+	DescriptorWrite writes[MAX_DESCRIPTOR_BINDINGS];
+	uint32 writeCount;
+
+	bool operator==(const DescriptorSetKey& other) const;
+	uint64 Hash() const;
+};
+
+// Owns every descriptor set layout, identical binding lists return the same layout
+class DescriptorLayoutCache
+{
+private:
+	vk::Device m_Device;
+	std::unordered_map<DescriptorLayoutKey, vk::DescriptorSetLayout, DescriptorLayoutKeyHasher> m_Layouts;
+public:
+	DescriptorLayoutCache(vk::Device device);
+	~DescriptorLayoutCache();
+
+	vk::DescriptorSetLayout GetLayout(vk::ArrayProxy<const vk::DescriptorSetLayoutBinding> bindings);
+};
+
+// Hands out descriptor sets that live for one frame. Every frame in flight has its own list of
+// pools, they are reset as a whole when the frame comes around again instead of freeing sets,
+// and new pools are only created when all the recycled ones are full
+class DescriptorAllocator
+{
+private:
+	struct CachedSet
+	{
+		uint64 hash;
+		DescriptorSetKey key;
+		vk::DescriptorSet set;
+	};
+
+	struct FrameData
+	{
+		std::vector<vk::DescriptorPool> usedPools;
+		vk::DescriptorPool currentPool;
+
+		// Set key to set, lets identical sets in the same frame share one allocation. Open
+		// addressing with a power of two size, so clearing it every frame keeps the memory.
+		// The hash only picks the slot and skips most compares, hits are checked on the full key
+		std::vector<CachedSet> sets;
+		uint32 setCount;
+	};
+
+	vk::Device m_Device;
+
+	std::vector<FrameData> m_Frames;
+	uint32 m_FrameIndex;
+
+	std::vector<vk::DescriptorPool> m_FreePools;
+	uint32 m_PoolCount;
+private:
+	vk::DescriptorPool GrabPool();
+public:
+	DescriptorAllocator(vk::Device device, uint32 framesInFlight);
+	~DescriptorAllocator();
+
+	// Resets the pools of the frame, must only be called after the frame's fence has been waited on
+	void BeginFrame(uint32 frameIndex);
+
+	vk::DescriptorSet Allocate(vk::DescriptorSetLayout layout);
+
+	vk::DescriptorSet FindCachedSet(const DescriptorSetKey& key, uint64 hash) const;
+	void AddCachedSet(const DescriptorSetKey& key, uint64 hash, vk::DescriptorSet set);
+
+	vk::Device GetDevice() const { return m_Device; }
+	uint32 GetPoolCount() const { return m_PoolCount; }
+};
+
+// Builds a set from buffer and image bindings. The layout comes from the layout cache and the
+// set from the allocator, unless a set with the same layout and resources was already built this frame
+class DescriptorBuilder
+{
+private:
+	DescriptorLayoutCache* m_LayoutCache;
+	DescriptorAllocator* m_Allocator;
+
+	// Builders live on the stack for a single set, so they don't touch the heap
+	vk::DescriptorSetLayoutBinding m_Bindings[MAX_DESCRIPTOR_BINDINGS];
+	DescriptorSetKey m_Key;
+	uint32 m_BindingCount;
+public:
+	DescriptorBuilder(DescriptorLayoutCache* layoutCache, DescriptorAllocator* allocator);
+
+	DescriptorBuilder& BindBuffer(uint32 binding, vk::DescriptorType type, vk::ShaderStageFlags stages, const vk::DescriptorBufferInfo& bufferInfo);
+	DescriptorBuilder& BindImage(uint32 binding, vk::DescriptorType type, vk::ShaderStageFlags stages, const vk::DescriptorImageInfo& imageInfo);
+
+	vk::DescriptorSetLayout BuildLayout();
+	vk::DescriptorSet Build();
+	vk::DescriptorSet Build(vk::DescriptorSetLayout& outLayout);
+};
\ No newline at end of file
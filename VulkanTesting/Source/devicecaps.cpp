@@ -0,0 +1,110 @@
+#include "devicecaps.h"
+
+#include <string.h>
+
+bool HasStencilComponent(vk::Format format)
+{
+	switch (format)
+	{
+	case vk::Format::eS8Uint:
+	case vk::Format::eD16UnormS8Uint:
+	case vk::Format::eD24UnormS8Uint:
+	case vk::Format::eD32SfloatS8Uint:
+		return true;
+	default:
+		return false;
+	}
+}
+
+vk::ImageAspectFlags GetDepthAspect(vk::Format format)
+{
+	if (HasStencilComponent(format))
+		return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+
+	return vk::ImageAspectFlagBits::eDepth;
+}
+
+void DeviceCapabilities::Query(vk::PhysicalDevice gpuDevice, vk::SurfaceKHR surfaceHandle)
+{
+	properties = gpuDevice.getProperties();
+	memoryProperties = gpuDevice.getMemoryProperties();
+	features = gpuDevice.getFeatures();
+
+	queueFamilies = gpuDevice.getQueueFamilyProperties();
+	extensions = gpuDevice.enumerateDeviceExtensionProperties();
+
+	presentSupport.resize(queueFamilies.size());
+	for (uint32 index = 0; index < queueFamilies.size(); index++)
+		presentSupport[index] = gpuDevice.getSurfaceSupportKHR(index, surfaceHandle) == VK_TRUE;
+
+	queueFamilyIndicies = QueueFamilyIndicies();
+	for (int32 index = 0; index < queueFamilies.size(); index++)
+	{
+		if (queueFamilies[index].queueCount > 0 && queueFamilies[index].queueFlags & vk::QueueFlagBits::eGraphics)
+		{
+			queueFamilyIndicies.graphicsIndex = index;
+		}
+
+		if (queueFamilies[index].queueCount > 0 && presentSupport[index])
+		{
+			queueFamilyIndicies.presentIndex = index;
+		}
+
+		if (queueFamilyIndicies.IsComplete())
+			break;
+	}
+
+	formatProperties.resize(VK_FORMAT_ASTC_12x12_SRGB_BLOCK + 1);
+	for (uint32 index = 0; index < formatProperties.size(); index++)
+		formatProperties[index] = gpuDevice.getFormatProperties((vk::Format)index);
+
+	RefreshSurface(gpuDevice, surfaceHandle);
+}
+
+void DeviceCapabilities::RefreshSurface(vk::PhysicalDevice gpuDevice, vk::SurfaceKHR surfaceHandle)
+{
+	surface = SwapchainSupportInfo::GetSwapchainSupportInfo(surfaceHandle, gpuDevice);
+}
+
+bool DeviceCapabilities::IsExtensionSupported(const char* name) const
+{
+	for (const vk::ExtensionProperties& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+const vk::FormatProperties& DeviceCapabilities::GetFormatProperties(vk::Format format) const
+{
+	static const vk::FormatProperties unsupported;
+
+	if ((uint32)format >= formatProperties.size())
+		return unsupported;
+
+	return formatProperties[(uint32)format];
+}
+
+vk::Format DeviceCapabilities::FindSupportedFormat(vk::ArrayProxy<const vk::Format> candidates, vk::FormatFeatureFlags features) const
+{
+	for (vk::Format format : candidates)
+	{
+		if ((GetFormatProperties(format).optimalTilingFeatures & features) == features)
+			return format;
+	}
+
+	return vk::Format::eUndefined;
+}
+
+uint32 DeviceCapabilities::FindMemoryType(uint32 typeFilter, vk::MemoryPropertyFlags flags) const
+{
+	for (uint32 index = 0; index < memoryProperties.memoryTypeCount; index++)
+	{
+		if ((typeFilter & (1 << index)) && (memoryProperties.memoryTypes[index].propertyFlags & flags) == flags)
+			return index;
+	}
+
+	return UINT32_MAX;
+}
\ No newline at end of file
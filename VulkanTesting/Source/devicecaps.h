@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "swapchain.h"
+
+struct QueueFamilyIndicies
+{
+	int32 graphicsIndex = -1;
+	int32 presentIndex = -1;
+
+	bool IsComplete() const
+	{
+		return graphicsIndex >= 0 && presentIndex >= 0;
+	}
+};
+
+bool HasStencilComponent(vk::Format format);
+
+// Depth and stencil aspect for combined formats, views used as attachments need both
+vk::ImageAspectFlags GetDepthAspect(vk::Format format);
+
+// What the physical device can do, queried once when the device is picked instead of asking the
+// driver again every time. Only the surface part changes over the lifetime of the device
+struct DeviceCapabilities
+{
+	vk::PhysicalDeviceProperties properties;
+	vk::PhysicalDeviceMemoryProperties memoryProperties;
+	vk::PhysicalDeviceFeatures features;
+
+	std::vector<vk::QueueFamilyProperties> queueFamilies;
+	std::vector<vk::ExtensionProperties> extensions;
+
+	// Per queue family, whether it can present to the renderer's surface
+	std::vector<bool> presentSupport;
+	QueueFamilyIndicies queueFamilyIndicies;
+
+	// Capabilities, formats and present modes of the surface, the current extent changes with the window
+	SwapchainSupportInfo surface;
+
+	// Indexed by format, covers every core format up to the ASTC ones
+	std::vector<vk::FormatProperties> formatProperties;
+
+	void Query(vk::PhysicalDevice gpuDevice, vk::SurfaceKHR surfaceHandle);
+
+	// Call before recreating the swapchain
+	void RefreshSurface(vk::PhysicalDevice gpuDevice, vk::SurfaceKHR surfaceHandle);
+
+	bool IsExtensionSupported(const char* name) const;
+
+	// Formats outside of the core range report no features
+	const vk::FormatProperties& GetFormatProperties(vk::Format format) const;
+
+	// First of the candidates that has all of the features with optimal tiling, eUndefined if there is none
+	vk::Format FindSupportedFormat(vk::ArrayProxy<const vk::Format> candidates, vk::FormatFeatureFlags features) const;
+
+	// Index of the first memory type in typeFilter that has all of the property flags, UINT32_MAX if there is none
+	uint32 FindMemoryType(uint32 typeFilter, vk::MemoryPropertyFlags flags) const;
+};
\ No newline at end of file
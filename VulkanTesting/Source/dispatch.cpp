@@ -0,0 +1,19 @@
+#include "dispatch.h"
+
+#include <assert.h>
+
+static vk::DispatchLoaderDynamic DirectDispatch;
+static bool DirectDispatchLoaded = false;
+
+void LoadDeviceDispatch(vk::Instance instance, vk::Device device)
+{
+	// Device level functions come from vkGetDeviceProcAddr, the rest from the instance
+	DirectDispatch.init(instance, device);
+	DirectDispatchLoaded = true;
+}
+
+const vk::DispatchLoaderDynamic& GetDirectDispatch()
+{
+	assert(DirectDispatchLoaded);
+	return DirectDispatch;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+// Which table the vulkan.hpp calls on the hot paths dispatch through, pass GetDispatch() as their
+// last argument. By default that is the static loader, whose exports are trampolines that look up
+// the device's real entry point on every call. Defining VULKAN_DIRECT_DISPATCH switches to
+// function pointers fetched with vkGetDeviceProcAddr, which call into the driver directly
+
+// Loads the direct table, call once the device exists. The table is loaded in both modes so the
+// two can be compared at runtime
+void LoadDeviceDispatch(vk::Instance instance, vk::Device device);
+
+const vk::DispatchLoaderDynamic& GetDirectDispatch();
+
+#ifdef VULKAN_DIRECT_DISPATCH
+
+typedef vk::DispatchLoaderDynamic DeviceDispatch;
+
+inline const DeviceDispatch& GetDispatch()
+{
+	return GetDirectDispatch();
+}
+
+#else
+
+typedef vk::DispatchLoaderStatic DeviceDispatch;
+
+inline DeviceDispatch GetDispatch()
+{
+	return DeviceDispatch();
+}
+
+#endif
\ No newline at end of file
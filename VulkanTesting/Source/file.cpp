@@ -0,0 +1,53 @@
+#include "file.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+BufferInfo ReadFileToBuffer(const String& filename)
+{
+	FILE* file = NULL;
+	fopen_s(&file, filename.c_str(), "rb");
+	assert(file != NULL);
+
+	fseek(file, 0, SEEK_END);
+	uint32 length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	byte* buffer = new byte[length];
+	fread(buffer, 1, length, file);
+
+	BufferInfo result;
+	result.buffer = buffer;
+	result.size = length;
+
+	fclose(file);
+	return result;
+}
+
+String ReadFileToString(const String& filename)
+{
+	FILE* file = NULL;
+	fopen_s(&file, filename.c_str(), "rt");
+	assert(file != NULL);
+
+	fseek(file, 0, SEEK_END);
+	uint32 length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	String result(length, 0);
+	fread(&result[0], 1, length, file);
+
+	fclose(file);
+	return result;
+}
+
+void WriteBufferToFile(const String& filename, const void* data, size_t size)
+{
+	FILE* file = NULL;
+	fopen_s(&file, filename.c_str(), "wb");
+	assert(file != NULL);
+
+	fwrite(data, 1, size, file);
+
+	fclose(file);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "types.h"
+
+struct BufferInfo
+{
+	byte* buffer;
+	size_t size;
+};
+
+BufferInfo ReadFileToBuffer(const String& filename);
+String ReadFileToString(const String& filename);
+
+void WriteBufferToFile(const String& filename, const void* data, size_t size);
\ No newline at end of file
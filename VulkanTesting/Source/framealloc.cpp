@@ -0,0 +1,96 @@
+#include "framealloc.h"
+
+#include <assert.h>
+#include <cstddef>
+#include <stdlib.h>
+
+FrameAllocator* FrameAllocator::s_Current = nullptr;
+
+static thread_local uint64 ThreadHeapAllocations = 0;
+
+void* operator new(size_t size)
+{
+	ThreadHeapAllocations++;
+
+	void* memory = malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+uint64 GetThreadHeapAllocationCount()
+{
+	return ThreadHeapAllocations;
+}
+
+FrameAllocator::FrameAllocator(size_t capacity)
+	: m_Capacity(capacity), m_Offset(0), m_OverflowBytes(0)
+{
+	m_Memory = (byte*)malloc(capacity);
+	assert(m_Memory);
+}
+
+FrameAllocator::~FrameAllocator()
+{
+	if (s_Current == this)
+		s_Current = nullptr;
+
+	for (byte* block : m_Overflow)
+		free(block);
+
+	free(m_Memory);
+}
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+	size_t offset = (m_Offset + alignment - 1) & ~(alignment - 1);
+	if (offset + size <= m_Capacity)
+	{
+		m_Offset = offset + size;
+		return m_Memory + offset;
+	}
+
+	// Frame memory is never freed one by one, the overflow is only a stopgap until the next Reset.
+	// malloc is aligned enough for anything the containers ask for
+	assert(alignment <= alignof(std::max_align_t));
+
+	byte* block = (byte*)malloc(size);
+	assert(block);
+
+	m_Overflow.push_back(block);
+	m_OverflowBytes += size;
+	return block;
+}
+
+void FrameAllocator::Reset()
+{
+	if (!m_Overflow.empty())
+	{
+		// Big enough for everything the last frame needed plus some headroom
+		size_t capacity = (m_Offset + m_OverflowBytes) * 3 / 2;
+
+		for (byte* block : m_Overflow)
+			free(block);
+		m_Overflow.clear();
+
+		free(m_Memory);
+		m_Memory = (byte*)malloc(capacity);
+		assert(m_Memory);
+
+		m_Capacity = capacity;
+		m_OverflowBytes = 0;
+	}
+
+	m_Offset = 0;
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+#include "types.h"
+
+const size_t FRAME_ALLOCATOR_SIZE = 256 * 1024;
+
+// Bump allocator for CPU side data that only lives while a frame is built and recorded. The
+// Renderer keeps one per frame in flight and resets it in BeginFrame, so memory handed out stays
+// valid until the same frame slot comes around again. Render thread only
+class FrameAllocator
+{
+private:
+	byte* m_Memory;
+	size_t m_Capacity;
+	size_t m_Offset;
+
+	// Allocations that didn't fit, the block grows to cover them on the next Reset
+	std::vector<byte*> m_Overflow;
+	size_t m_OverflowBytes;
+
+	static FrameAllocator* s_Current;
+public:
+	FrameAllocator(size_t capacity = FRAME_ALLOCATOR_SIZE);
+	~FrameAllocator();
+
+	void* Allocate(size_t size, size_t alignment);
+	void Reset();
+
+	size_t GetUsedBytes() const { return m_Offset + m_OverflowBytes; }
+	size_t GetCapacity() const { return m_Capacity; }
+
+	// What FrameStlAllocator and FrameVector use when constructed without an allocator
+	static FrameAllocator* GetCurrent() { return s_Current; }
+	static void SetCurrent(FrameAllocator* allocator) { s_Current = allocator; }
+};
+
+// STL allocator on top of a FrameAllocator, deallocate does nothing. Default constructed it uses
+// the current frame's allocator
+template<typename T>
+class FrameStlAllocator
+{
+public:
+	typedef T value_type;
+
+	// A container assigned a fresh one takes its allocator along instead of reusing old frame memory
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef FrameStlAllocator<U> other;
+	};
+
+	FrameAllocator* allocator;
+
+	FrameStlAllocator()
+		: allocator(FrameAllocator::GetCurrent())
+	{
+	}
+
+	FrameStlAllocator(FrameAllocator* frameAllocator)
+		: allocator(frameAllocator)
+	{
+	}
+
+	template<typename U>
+	FrameStlAllocator(const FrameStlAllocator<U>& other)
+		: allocator(other.allocator)
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		return (T*)allocator->Allocate(count * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T*, size_t)
+	{
+	}
+
+	template<typename U>
+	bool operator==(const FrameStlAllocator<U>& other) const { return allocator == other.allocator; }
+
+	template<typename U>
+	bool operator!=(const FrameStlAllocator<U>& other) const { return allocator != other.allocator; }
+};
+
+// Must not outlive the frame after the one it was created in
+template<typename T>
+using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+
+// A callable copied into frame memory, for callbacks that are recorded in the frame they were made
+// in. Its destructor never runs, so it may only capture trivially destructible things
+template<typename Signature>
+class FrameFunction;
+
+template<typename Result, typename... Args>
+class FrameFunction<Result(Args...)>
+{
+private:
+	void* m_Callable;
+	Result (*m_Invoke)(void*, Args...);
+public:
+	FrameFunction()
+		: m_Callable(nullptr), m_Invoke(nullptr)
+	{
+	}
+
+	template<typename Function, typename = typename std::enable_if<!std::is_same<typename std::decay<Function>::type, FrameFunction>::value>::type>
+	FrameFunction(Function&& function, FrameAllocator* allocator = FrameAllocator::GetCurrent())
+	{
+		typedef typename std::decay<Function>::type Callable;
+		static_assert(std::is_trivially_destructible<Callable>::value, "FrameFunction callables are never destroyed");
+
+		m_Callable = new (allocator->Allocate(sizeof(Callable), alignof(Callable))) Callable(std::forward<Function>(function));
+		m_Invoke = [](void* callable, Args... args) -> Result
+		{
+			return (*(Callable*)callable)(std::forward<Args>(args)...);
+		};
+	}
+
+	Result operator()(Args... args) const
+	{
+		return m_Invoke(m_Callable, std::forward<Args>(args)...);
+	}
+
+	explicit operator bool() const { return m_Invoke != nullptr; }
+};
+
+// Calls to the global operator new made by the calling thread, compare before and after a stretch
+// of code to see whether it touched the heap
+uint64 GetThreadHeapAllocationCount();
\ No newline at end of file
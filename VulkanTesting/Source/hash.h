@@ -0,0 +1,26 @@
+#pragma once
+
+#include "types.h"
+
+// FNV-1a, stable across runs so hashes can be used as cache keys. Hash fields one by one
+// rather than whole structs, padding bytes are not guaranteed to be zeroed
+
+const uint64 HASH_SEED = 14695981039346656037ull;
+
+inline uint64 HashBytes(const void* data, size_t size, uint64 hash = HASH_SEED)
+{
+	const byte* bytes = (const byte*)data;
+	for (size_t index = 0; index < size; index++)
+	{
+		hash ^= bytes[index];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+template<typename T>
+inline uint64 HashValue(const T& value, uint64 hash = HASH_SEED)
+{
+	return HashBytes(&value, sizeof(T), hash);
+}
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "hostallocator.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static HostAllocator* InstalledAllocator = nullptr;
+
+// Sits right in front of every allocation, the free callback doesn't get a size or scope
+struct AllocationHeader
+{
+	void* base;
+	uint32 size;
+	uint8 scope;
+	uint8 typeIndex;
+	uint8 sizeClass;
+	uint8 padding;
+};
+
+const uint32 HEADER_SIZE = 16;
+const uint8 LARGE_ALLOCATION = 0xff;
+
+static_assert(sizeof(AllocationHeader) <= HEADER_SIZE, "Allocation header doesn't fit its slot");
+
+static const char* ScopeNames[HOST_ALLOCATOR_SCOPE_COUNT] = { "Command", "Object", "Cache", "Device", "Instance" };
+
+static void AddPeak(std::atomic<uint64>& peak, uint64 value)
+{
+	uint64 current = peak.load(std::memory_order_relaxed);
+	while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void InstallHostAllocator(HostAllocator* allocator)
+{
+	InstalledAllocator = allocator;
+}
+
+HostAllocator* GetHostAllocator()
+{
+	return InstalledAllocator;
+}
+
+HostAllocator::HostAllocator()
+{
+	for (uint32 typeIndex = 0; typeIndex < HOST_ALLOCATOR_TYPE_COUNT; typeIndex++)
+	{
+		m_Contexts[typeIndex].allocator = this;
+		m_Contexts[typeIndex].typeIndex = typeIndex;
+
+		m_Callbacks[typeIndex] = vk::AllocationCallbacks(&m_Contexts[typeIndex], 
+														 AllocationCallback, ReallocationCallback, FreeCallback, 
+														 InternalAllocationCallback, InternalFreeCallback);
+	}
+
+	for (uint32 scope = 0; scope < HOST_ALLOCATOR_SCOPE_COUNT; scope++)
+	{
+		for (uint32 typeIndex = 0; typeIndex < HOST_ALLOCATOR_TYPE_COUNT; typeIndex++)
+		{
+			Counters& counters = m_Counters[scope][typeIndex];
+			counters.allocations = 0;
+			counters.reallocations = 0;
+			counters.frees = 0;
+			counters.totalBytes = 0;
+			counters.currentBytes = 0;
+			counters.peakBytes = 0;
+		}
+
+		Pool& pool = m_Pools[scope];
+		pool.chunkCursor = nullptr;
+		pool.chunkEnd = nullptr;
+		for (uint32 sizeClass = 0; sizeClass < HOST_ALLOCATOR_CLASS_COUNT; sizeClass++)
+			pool.freeLists[sizeClass] = nullptr;
+
+		m_InternalAllocations[scope] = 0;
+		m_InternalBytes[scope] = 0;
+	}
+}
+
+HostAllocator::~HostAllocator()
+{
+	for (Pool& pool : m_Pools)
+	{
+		for (byte* chunk : pool.chunks)
+			free(chunk);
+	}
+}
+
+uint32 HostAllocator::GetTypeIndex(vk::ObjectType type)
+{
+	uint32 value = (uint32)type;
+	return value <= VK_OBJECT_TYPE_COMMAND_POOL ? value : HOST_ALLOCATOR_TYPE_COUNT - 1;
+}
+
+void* HostAllocator::PoolAllocate(Pool& pool, uint32 sizeClass)
+{
+	std::lock_guard<std::mutex> lock(pool.mutex);
+
+	if (pool.freeLists[sizeClass])
+	{
+		void* block = pool.freeLists[sizeClass];
+		pool.freeLists[sizeClass] = *(void**)block;
+		return block;
+	}
+
+	size_t blockSize = (size_t)1 << (sizeClass + HOST_ALLOCATOR_MIN_CLASS_SHIFT);
+	if (pool.chunkCursor + blockSize > pool.chunkEnd)
+	{
+		// The tail of the old chunk is given up, it is smaller than the block anyway
+		byte* chunk = (byte*)malloc(HOST_ALLOCATOR_CHUNK_SIZE);
+		if (!chunk)
+			return nullptr;
+
+		pool.chunks.push_back(chunk);
+		pool.chunkCursor = chunk;
+		pool.chunkEnd = chunk + HOST_ALLOCATOR_CHUNK_SIZE;
+	}
+
+	void* block = pool.chunkCursor;
+	pool.chunkCursor += blockSize;
+	return block;
+}
+
+void HostAllocator::PoolFree(Pool& pool, uint32 sizeClass, void* block)
+{
+	std::lock_guard<std::mutex> lock(pool.mutex);
+
+	*(void**)block = pool.freeLists[sizeClass];
+	pool.freeLists[sizeClass] = block;
+}
+
+void* HostAllocator::Allocate(uint32 typeIndex, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (size == 0)
+		return nullptr;
+
+	// Blocks are carved from malloc'd chunks at power of two sizes, so their payload is 16 byte aligned
+	uint8 sizeClass = LARGE_ALLOCATION;
+	if (alignment <= HEADER_SIZE)
+	{
+		for (uint32 index = 0; index < HOST_ALLOCATOR_CLASS_COUNT; index++)
+		{
+			if (size + HEADER_SIZE <= ((size_t)1 << (index + HOST_ALLOCATOR_MIN_CLASS_SHIFT)))
+			{
+				sizeClass = (uint8)index;
+				break;
+			}
+		}
+	}
+
+	byte* base;
+	byte* memory;
+	if (sizeClass != LARGE_ALLOCATION)
+	{
+		base = (byte*)PoolAllocate(m_Pools[scope], sizeClass);
+		if (!base)
+			return nullptr;
+
+		memory = base + HEADER_SIZE;
+	}
+	else
+	{
+		base = (byte*)malloc(size + alignment + HEADER_SIZE);
+		if (!base)
+			return nullptr;
+
+		uintptr_t address = (uintptr_t)(base + HEADER_SIZE);
+		memory = (byte*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	AllocationHeader* header = (AllocationHeader*)(memory - HEADER_SIZE);
+	header->base = base;
+	header->size = (uint32)size;
+	header->scope = (uint8)scope;
+	header->typeIndex = (uint8)typeIndex;
+	header->sizeClass = sizeClass;
+
+	Counters& counters = m_Counters[scope][typeIndex];
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.totalBytes.fetch_add(size, std::memory_order_relaxed);
+	AddPeak(counters.peakBytes, counters.currentBytes.fetch_add(size, std::memory_order_relaxed) + size);
+
+	return memory;
+}
+
+void* HostAllocator::Reallocate(uint32 typeIndex, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (!original)
+		return Allocate(typeIndex, size, alignment, scope);
+
+	if (size == 0)
+	{
+		Free(original);
+		return nullptr;
+	}
+
+	AllocationHeader* header = (AllocationHeader*)((byte*)original - HEADER_SIZE);
+
+	void* memory = Allocate(typeIndex, size, alignment, scope);
+	if (!memory)
+		return nullptr;
+
+	memcpy(memory, original, size < header->size ? size : header->size);
+	Free(original);
+
+	m_Counters[scope][typeIndex].reallocations.fetch_add(1, std::memory_order_relaxed);
+	return memory;
+}
+
+void HostAllocator::Free(void* memory)
+{
+	if (!memory)
+		return;
+
+	AllocationHeader* header = (AllocationHeader*)((byte*)memory - HEADER_SIZE);
+
+	Counters& counters = m_Counters[header->scope][header->typeIndex];
+	counters.frees.fetch_add(1, std::memory_order_relaxed);
+	counters.currentBytes.fetch_sub(header->size, std::memory_order_relaxed);
+
+	if (header->sizeClass != LARGE_ALLOCATION)
+		PoolFree(m_Pools[header->scope], header->sizeClass, header->base);
+	else
+		free(header->base);
+}
+
+void* VKAPI_PTR HostAllocator::AllocationCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	TypeContext* context = (TypeContext*)userData;
+	return context->allocator->Allocate(context->typeIndex, size, alignment, scope);
+}
+
+void* VKAPI_PTR HostAllocator::ReallocationCallback(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	TypeContext* context = (TypeContext*)userData;
+	return context->allocator->Reallocate(context->typeIndex, original, size, alignment, scope);
+}
+
+void VKAPI_PTR HostAllocator::FreeCallback(void* userData, void* memory)
+{
+	TypeContext* context = (TypeContext*)userData;
+	context->allocator->Free(memory);
+}
+
+void VKAPI_PTR HostAllocator::InternalAllocationCallback(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+	// Executable memory the driver allocated itself, only reported
+	TypeContext* context = (TypeContext*)userData;
+	context->allocator->m_InternalAllocations[scope].fetch_add(1, std::memory_order_relaxed);
+	context->allocator->m_InternalBytes[scope].fetch_add(size, std::memory_order_relaxed);
+}
+
+void VKAPI_PTR HostAllocator::InternalFreeCallback(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+	TypeContext* context = (TypeContext*)userData;
+	context->allocator->m_InternalBytes[scope].fetch_sub(size, std::memory_order_relaxed);
+}
+
+HostAllocationStats HostAllocator::GetStats(VkSystemAllocationScope scope, vk::ObjectType type) const
+{
+	const Counters& counters = m_Counters[scope][GetTypeIndex(type)];
+
+	HostAllocationStats result;
+	result.allocations = counters.allocations.load();
+	result.reallocations = counters.reallocations.load();
+	result.frees = counters.frees.load();
+	result.totalBytes = counters.totalBytes.load();
+	result.currentBytes = counters.currentBytes.load();
+	result.peakBytes = counters.peakBytes.load();
+	return result;
+}
+
+void HostAllocator::ResetCounters()
+{
+	for (uint32 scope = 0; scope < HOST_ALLOCATOR_SCOPE_COUNT; scope++)
+	{
+		for (uint32 typeIndex = 0; typeIndex < HOST_ALLOCATOR_TYPE_COUNT; typeIndex++)
+		{
+			Counters& counters = m_Counters[scope][typeIndex];
+			counters.allocations = 0;
+			counters.reallocations = 0;
+			counters.frees = 0;
+			counters.totalBytes = 0;
+		}
+
+		m_InternalAllocations[scope] = 0;
+	}
+}
+
+void HostAllocator::PrintReport() const
+{
+	printf("Host allocations by scope and object type\n");
+	printf("  %-8s %-20s %10s %10s %10s %12s %12s %12s\n", "Scope", "Object", "Allocs", "Reallocs", "Frees", "Total KB", "Live KB", "Peak KB");
+
+	for (uint32 scope = 0; scope < HOST_ALLOCATOR_SCOPE_COUNT; scope++)
+	{
+		for (uint32 typeIndex = 0; typeIndex < HOST_ALLOCATOR_TYPE_COUNT; typeIndex++)
+		{
+			const Counters& counters = m_Counters[scope][typeIndex];
+			if (counters.allocations == 0 && counters.frees == 0 && counters.currentBytes == 0)
+				continue;
+
+			String typeName = typeIndex == HOST_ALLOCATOR_TYPE_COUNT - 1 ? String("Extension") : vk::to_string((vk::ObjectType)typeIndex);
+
+			printf("  %-8s %-20s %10llu %10llu %10llu %12.1f %12.1f %12.1f\n", ScopeNames[scope], typeName.c_str(), 
+				   (unsigned long long)counters.allocations.load(), (unsigned long long)counters.reallocations.load(), 
+				   (unsigned long long)counters.frees.load(), counters.totalBytes / 1024.0, 
+				   counters.currentBytes / 1024.0, counters.peakBytes / 1024.0);
+		}
+
+		if (m_InternalAllocations[scope] > 0)
+		{
+			printf("  %-8s %-20s %10llu %10s %10s %12s %12.1f\n", ScopeNames[scope], "Internal", 
+				   (unsigned long long)m_InternalAllocations[scope].load(), "", "", "", m_InternalBytes[scope] / 1024.0);
+		}
+	}
+
+	size_t pooledBytes = 0;
+	for (const Pool& pool : m_Pools)
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pooledBytes += pool.chunks.size() * HOST_ALLOCATOR_CHUNK_SIZE;
+	}
+
+	printf("  Pooled chunks: %.1f KB\n", pooledBytes / 1024.0);
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+#include <mutex>
+
+#include "types.h"
+
+// Core object types are counted one by one, everything from extensions (swapchains, surfaces,
+// messengers) shares the last slot
+const uint32 HOST_ALLOCATOR_TYPE_COUNT = VK_OBJECT_TYPE_COMMAND_POOL + 2;
+const uint32 HOST_ALLOCATOR_SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+// Allocations up to the largest class come out of the scope's pool, bigger or over aligned ones
+// go straight to malloc
+const uint32 HOST_ALLOCATOR_MIN_CLASS_SHIFT = 5;
+const uint32 HOST_ALLOCATOR_CLASS_COUNT = 8;
+const uint32 HOST_ALLOCATOR_CHUNK_SIZE = 64 * 1024;
+
+// A reallocation is also counted as one allocation and one free
+struct HostAllocationStats
+{
+	uint64 allocations = 0;
+	uint64 reallocations = 0;
+	uint64 frees = 0;
+
+	// Everything handed out, and what is live right now
+	uint64 totalBytes = 0;
+	uint64 currentBytes = 0;
+	uint64 peakBytes = 0;
+};
+
+// Host memory for the driver and layers, handed in through vk::AllocationCallbacks. Every object
+// type gets its own callbacks so the counters know what an allocation was made for, the memory
+// itself comes from size class free lists kept per allocation scope. Command scope allocations
+// come and go while recording, with the pools they stop hitting the system heap after warm up
+class HostAllocator
+{
+private:
+	struct TypeContext
+	{
+		HostAllocator* allocator;
+		uint32 typeIndex;
+	};
+
+	struct Counters
+	{
+		std::atomic<uint64> allocations;
+		std::atomic<uint64> reallocations;
+		std::atomic<uint64> frees;
+		std::atomic<uint64> totalBytes;
+		std::atomic<uint64> currentBytes;
+		std::atomic<uint64> peakBytes;
+	};
+
+	struct Pool
+	{
+		mutable std::mutex mutex;
+		std::vector<byte*> chunks;
+		byte* chunkCursor;
+		byte* chunkEnd;
+		void* freeLists[HOST_ALLOCATOR_CLASS_COUNT];
+	};
+
+	TypeContext m_Contexts[HOST_ALLOCATOR_TYPE_COUNT];
+	vk::AllocationCallbacks m_Callbacks[HOST_ALLOCATOR_TYPE_COUNT];
+
+	Counters m_Counters[HOST_ALLOCATOR_SCOPE_COUNT][HOST_ALLOCATOR_TYPE_COUNT];
+	Pool m_Pools[HOST_ALLOCATOR_SCOPE_COUNT];
+
+	std::atomic<uint64> m_InternalAllocations[HOST_ALLOCATOR_SCOPE_COUNT];
+	std::atomic<uint64> m_InternalBytes[HOST_ALLOCATOR_SCOPE_COUNT];
+private:
+	void* Allocate(uint32 typeIndex, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void* Reallocate(uint32 typeIndex, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void Free(void* memory);
+
+	void* PoolAllocate(Pool& pool, uint32 sizeClass);
+	void PoolFree(Pool& pool, uint32 sizeClass, void* block);
+
+	static void* VKAPI_PTR AllocationCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static void* VKAPI_PTR ReallocationCallback(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static void VKAPI_PTR FreeCallback(void* userData, void* memory);
+	static void VKAPI_PTR InternalAllocationCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+	static void VKAPI_PTR InternalFreeCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+	static uint32 GetTypeIndex(vk::ObjectType type);
+public:
+	HostAllocator();
+
+	// Every object made with these callbacks has to be destroyed first
+	~HostAllocator();
+
+	const vk::AllocationCallbacks* GetCallbacks(vk::ObjectType type) const { return &m_Callbacks[GetTypeIndex(type)]; }
+
+	HostAllocationStats GetStats(VkSystemAllocationScope scope, vk::ObjectType type) const;
+
+	// Clears the call and byte totals, live and peak bytes are kept. Use it to measure a stretch of frames
+	void ResetCounters();
+	void PrintReport() const;
+};
+
+// The Renderer installs its allocator before it creates the instance, create and destroy calls
+// pass GetAllocationCallbacks for their object type. Null, so the driver's own allocator, when
+// nothing is installed
+void InstallHostAllocator(HostAllocator* allocator);
+HostAllocator* GetHostAllocator();
+
+inline const vk::AllocationCallbacks* GetAllocationCallbacks(vk::ObjectType type)
+{
+	HostAllocator* allocator = GetHostAllocator();
+	return allocator ? allocator->GetCallbacks(type) : nullptr;
+}
\ No newline at end of file
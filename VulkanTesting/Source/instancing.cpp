@@ -0,0 +1,108 @@
+#include "instancing.h"
+
+#include "renderer.h"
+
+#include <algorithm>
+
+DrawBatcher::DrawBatcher(Renderer* renderer, uint32 maxInstances, uint32 framesInFlight)
+	: m_Renderer(renderer), m_MaxInstances(maxInstances), m_FrameIndex(0), m_InstanceOffset(0), m_DrawCallCount(0)
+{
+	m_InstanceBuffers.resize(framesInFlight);
+
+	for (Buffer& buffer : m_InstanceBuffers)
+	{
+		buffer = CreateBuffer(renderer, sizeof(InstanceData) * maxInstances, 
+							  vk::BufferUsageFlagBits::eVertexBuffer, 
+							  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	}
+
+	m_Items.reserve(maxInstances);
+	m_Instances.reserve(maxInstances);
+}
+
+DrawBatcher::~DrawBatcher()
+{
+	for (Buffer& buffer : m_InstanceBuffers)
+		DestroyBuffer(m_Renderer, buffer);
+}
+
+void DrawBatcher::Begin(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	m_InstanceOffset = 0;
+	m_DrawCallCount = 0;
+
+	m_Items.clear();
+	m_Instances.clear();
+}
+
+void DrawBatcher::Submit(const Pipeline& pipeline, const Mesh& mesh, const InstanceData& instance)
+{
+	DrawItem item = {};
+	item.pipeline = (VkPipeline)pipeline.pipeline;
+	item.mesh = &mesh;
+	item.instanceIndex = (uint32)m_Instances.size();
+
+	m_Items.push_back(item);
+	m_Instances.push_back(instance);
+}
+
+void DrawBatcher::Flush(vk::CommandBuffer commandBuffer)
+{
+	if (m_Items.empty())
+		return;
+
+	assert(m_InstanceOffset + m_Items.size() <= m_MaxInstances);
+
+	// Sorting on the submit index as well keeps the draw order stable inside a batch
+	std::sort(m_Items.begin(), m_Items.end(), [](const DrawItem& a, const DrawItem& b)
+	{
+		if (a.pipeline != b.pipeline)
+			return a.pipeline < b.pipeline;
+		if (a.mesh != b.mesh)
+			return a.mesh < b.mesh;
+		return a.instanceIndex < b.instanceIndex;
+	});
+
+	Buffer& instanceBuffer = m_InstanceBuffers[m_FrameIndex];
+	InstanceData* instances = (InstanceData*)instanceBuffer.mapped + m_InstanceOffset;
+
+	for (uint32 index = 0; index < m_Items.size(); index++)
+		instances[index] = m_Instances[m_Items[index].instanceIndex];
+
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	const Mesh* boundMesh = nullptr;
+
+	uint32 first = 0;
+	while (first < m_Items.size())
+	{
+		const DrawItem& item = m_Items[first];
+
+		uint32 last = first + 1;
+		while (last < m_Items.size() && m_Items[last].pipeline == item.pipeline && m_Items[last].mesh == item.mesh)
+			last++;
+
+		if (item.pipeline != boundPipeline)
+		{
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, vk::Pipeline(item.pipeline), GetDispatch());
+			boundPipeline = item.pipeline;
+		}
+
+		if (item.mesh != boundMesh)
+		{
+			commandBuffer.bindVertexBuffers(0, { item.mesh->vertexBuffer.buffer, instanceBuffer.buffer }, { 0, 0 }, GetDispatch());
+			boundMesh = item.mesh;
+		}
+
+		// The instance binding is never rebound, firstInstance selects the batch inside the buffer
+		commandBuffer.draw(item.mesh->vertexCount, last - first, 0, m_InstanceOffset + first, GetDispatch());
+		m_DrawCallCount++;
+
+		first = last;
+	}
+
+	m_InstanceOffset += (uint32)m_Items.size();
+
+	m_Items.clear();
+	m_Instances.clear();
+}
\ No newline at end of file
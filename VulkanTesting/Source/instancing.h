@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "buffer.h"
+#include "mesh.h"
+#include "pipeline.h"
+
+// Set 0 of instanced.vert, allocated from the UniformAllocator every frame
+struct FrameUniforms
+{
+	Matrix4f viewProjection;
+};
+
+// Push constants of instanced.vert
+struct DrawPushConstants
+{
+	Vector4f tint;
+};
+
+// Collects draws during a frame and merges the ones that share pipeline and
+// mesh into a single instanced draw call when flushed
+class DrawBatcher
+{
+private:
+	struct DrawItem
+	{
+		VkPipeline pipeline;
+		const Mesh* mesh;
+		uint32 instanceIndex;
+	};
+
+	Renderer* m_Renderer;
+
+	uint32 m_MaxInstances;
+	std::vector<Buffer> m_InstanceBuffers;
+
+	uint32 m_FrameIndex;
+	uint32 m_InstanceOffset;
+
+	std::vector<DrawItem> m_Items;
+	std::vector<InstanceData> m_Instances;
+
+	uint32 m_DrawCallCount;
+public:
+	DrawBatcher(Renderer* renderer, uint32 maxInstances, uint32 framesInFlight);
+	~DrawBatcher();
+
+	// Selects the instance buffer for the frame, must only be called after the frame's fence has been waited on
+	void Begin(uint32 frameIndex);
+
+	void Submit(const Pipeline& pipeline, const Mesh& mesh, const InstanceData& instance);
+	void Flush(vk::CommandBuffer commandBuffer);
+
+	uint32 GetDrawCallCount() const { return m_DrawCallCount; }
+};
\ No newline at end of file
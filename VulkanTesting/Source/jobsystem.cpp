@@ -0,0 +1,94 @@
+#include "jobsystem.h"
+
+JobSystem::JobSystem(uint32 threadCount)
+	: m_Quit(false)
+{
+	if (threadCount == 0)
+	{
+		uint32 hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (uint32 index = 0; index < threadCount; index++)
+		m_Threads.push_back(std::thread(&JobSystem::WorkerLoop, this));
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		m_Quit = true;
+	}
+
+	m_QueueCondition.notify_all();
+
+	for (std::thread& thread : m_Threads)
+		thread.join();
+}
+
+void JobSystem::Submit(const std::function<void()>& job, JobCounter* counter)
+{
+	if (counter)
+		counter->pending++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		m_Queue.push_back({ job, counter });
+	}
+
+	m_QueueCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	while (!counter->IsDone())
+	{
+		// Help out instead of blocking, the job we wait on may still be queued
+		if (!RunOne())
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::RunOne()
+{
+	QueuedJob queued;
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		if (m_Queue.empty())
+			return false;
+
+		queued = m_Queue.front();
+		m_Queue.pop_front();
+	}
+
+	queued.job();
+
+	if (queued.counter)
+		queued.counter->pending--;
+
+	return true;
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		QueuedJob queued;
+		{
+			std::unique_lock<std::mutex> lock(m_QueueMutex);
+			m_QueueCondition.wait(lock, [this]() { return m_Quit || !m_Queue.empty(); });
+
+			// Drain the queue before quitting so nobody waits on a job that never runs
+			if (m_Queue.empty())
+				return;
+
+			queued = m_Queue.front();
+			m_Queue.pop_front();
+		}
+
+		queued.job();
+
+		if (queued.counter)
+			queued.counter->pending--;
+	}
+}
\ No newline at end of file
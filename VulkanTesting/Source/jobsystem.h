@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+
+// Counts the jobs submitted with it that haven't finished yet
+struct JobCounter
+{
+	std::atomic<uint32> pending;
+
+	JobCounter() : pending(0) {}
+
+	bool IsDone() const { return pending.load() == 0; }
+};
+
+// A fixed pool of worker threads pulling jobs off one shared queue. Jobs must not touch Vulkan
+// objects that need external synchronization unless they own them
+class JobSystem
+{
+private:
+	struct QueuedJob
+	{
+		std::function<void()> job;
+		JobCounter* counter;
+	};
+
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_QueueMutex;
+	std::condition_variable m_QueueCondition;
+	std::deque<QueuedJob> m_Queue;
+
+	bool m_Quit;
+private:
+	void WorkerLoop();
+	bool RunOne();
+public:
+	// Zero threads uses one per hardware thread, minus the one the renderer runs on
+	JobSystem(uint32 threadCount = 0);
+
+	// Runs whatever is still queued before joining the workers
+	~JobSystem();
+
+	void Submit(const std::function<void()>& job, JobCounter* counter = nullptr);
+
+	// Runs queued jobs on the calling thread until the counter reaches zero
+	void Wait(JobCounter* counter);
+
+	uint32 GetThreadCount() const { return (uint32)m_Threads.size(); }
+};
\ No newline at end of file
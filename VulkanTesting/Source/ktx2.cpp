@@ -0,0 +1,269 @@
+#include "ktx2.h"
+
+#include "renderer.h"
+#include "file.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef KTX_BASIS_TRANSCODER
+#include <basisu_transcoder.h>
+
+#include <mutex>
+#endif
+
+static const byte KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+enum Ktx2Supercompression : uint32
+{
+	KTX2_SUPERCOMPRESSION_NONE = 0,
+	KTX2_SUPERCOMPRESSION_BASIS_LZ = 1,
+	KTX2_SUPERCOMPRESSION_ZSTD = 2,
+	KTX2_SUPERCOMPRESSION_ZLIB = 3,
+};
+
+struct Ktx2Header
+{
+	byte identifier[12];
+	uint32 vkFormat;
+	uint32 typeSize;
+	uint32 pixelWidth;
+	uint32 pixelHeight;
+	uint32 pixelDepth;
+	uint32 layerCount;
+	uint32 faceCount;
+	uint32 levelCount;
+	uint32 supercompressionScheme;
+
+	uint32 dfdByteOffset;
+	uint32 dfdByteLength;
+	uint32 kvdByteOffset;
+	uint32 kvdByteLength;
+	uint64 sgdByteOffset;
+	uint64 sgdByteLength;
+};
+
+struct Ktx2LevelIndex
+{
+	uint64 byteOffset;
+	uint64 byteLength;
+	uint64 uncompressedByteLength;
+};
+
+static bool IsFormatSampleable(const DeviceCapabilities& capabilities, vk::Format format)
+{
+	return (bool)(capabilities.GetFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+}
+
+#ifdef KTX_BASIS_TRANSCODER
+
+struct TranscodeTarget
+{
+	basist::transcoder_texture_format format;
+	vk::Format unormFormat;
+	vk::Format srgbFormat;
+};
+
+const uint32 TRANSCODE_TARGET_COUNT = 5;
+
+// Best quality first, uncompressed RGBA is always there as the last resort
+static const TranscodeTarget TRANSCODE_TARGETS_ALPHA[TRANSCODE_TARGET_COUNT] = {
+	{ basist::transcoder_texture_format::cTFBC7_RGBA, vk::Format::eBc7UnormBlock, vk::Format::eBc7SrgbBlock },
+	{ basist::transcoder_texture_format::cTFASTC_4x4_RGBA, vk::Format::eAstc4x4UnormBlock, vk::Format::eAstc4x4SrgbBlock },
+	{ basist::transcoder_texture_format::cTFETC2_RGBA, vk::Format::eEtc2R8G8B8A8UnormBlock, vk::Format::eEtc2R8G8B8A8SrgbBlock },
+	{ basist::transcoder_texture_format::cTFBC3_RGBA, vk::Format::eBc3UnormBlock, vk::Format::eBc3SrgbBlock },
+	{ basist::transcoder_texture_format::cTFRGBA32, vk::Format::eR8G8B8A8Unorm, vk::Format::eR8G8B8A8Srgb },
+};
+
+static const TranscodeTarget TRANSCODE_TARGETS_OPAQUE[TRANSCODE_TARGET_COUNT] = {
+	{ basist::transcoder_texture_format::cTFBC7_RGBA, vk::Format::eBc7UnormBlock, vk::Format::eBc7SrgbBlock },
+	{ basist::transcoder_texture_format::cTFASTC_4x4_RGBA, vk::Format::eAstc4x4UnormBlock, vk::Format::eAstc4x4SrgbBlock },
+	{ basist::transcoder_texture_format::cTFETC1_RGB, vk::Format::eEtc2R8G8B8UnormBlock, vk::Format::eEtc2R8G8B8SrgbBlock },
+	{ basist::transcoder_texture_format::cTFBC1_RGB, vk::Format::eBc1RgbUnormBlock, vk::Format::eBc1RgbSrgbBlock },
+	{ basist::transcoder_texture_format::cTFRGBA32, vk::Format::eR8G8B8A8Unorm, vk::Format::eR8G8B8A8Srgb },
+};
+
+static void TranscodeBasis(Renderer* renderer, const std::vector<byte>& fileData, Ktx2Image& image)
+{
+	static std::once_flag initialized;
+	std::call_once(initialized, []() { basist::basisu_transcoder_init(); });
+
+	basist::ktx2_transcoder transcoder;
+	if (!transcoder.init(fileData.data(), (uint32)fileData.size()) || !transcoder.start_transcoding())
+		throw std::runtime_error("failed to read Basis Universal data in KTX2 file!");
+
+	bool srgb = transcoder.get_dfd_transfer_func() == basist::KTX2_KHR_DF_TRANSFER_SRGB;
+
+	const TranscodeTarget* targets = transcoder.get_has_alpha() ? TRANSCODE_TARGETS_ALPHA : TRANSCODE_TARGETS_OPAQUE;
+	const TranscodeTarget* target = &targets[TRANSCODE_TARGET_COUNT - 1];
+	for (uint32 index = 0; index < TRANSCODE_TARGET_COUNT - 1; index++)
+	{
+		if (IsFormatSampleable(renderer->GetCapabilities(), srgb ? targets[index].srgbFormat : targets[index].unormFormat))
+		{
+			target = &targets[index];
+			break;
+		}
+	}
+
+	image.format = srgb ? target->srgbFormat : target->unormFormat;
+
+	uint32 bytesPerBlock = basist::basis_get_bytes_per_block_or_pixel(target->format);
+	bool uncompressed = basist::basis_transcoder_format_is_uncompressed(target->format);
+
+	// Sized up front so the jobs can write their levels straight into the image
+	image.levels.resize(transcoder.get_levels());
+	std::vector<uint32> outputSizes(transcoder.get_levels());
+	vk::DeviceSize totalSize = 0;
+	for (uint32 level = 0; level < transcoder.get_levels(); level++)
+	{
+		basist::ktx2_image_level_info levelInfo;
+		transcoder.get_image_level_info(levelInfo, level, 0, 0);
+
+		outputSizes[level] = uncompressed ? levelInfo.m_orig_width * levelInfo.m_orig_height : levelInfo.m_total_blocks;
+
+		image.levels[level].offset = totalSize;
+		image.levels[level].size = outputSizes[level] * bytesPerBlock;
+		totalSize += image.levels[level].size;
+	}
+
+	image.data.resize((size_t)totalSize);
+
+	// The transcoder itself is read only once started, every job brings its own state
+	JobSystem* jobSystem = renderer->GetJobSystem();
+	JobCounter counter;
+	std::atomic<bool> failed(false);
+
+	for (uint32 level = 0; level < transcoder.get_levels(); level++)
+	{
+		jobSystem->Submit([&, level]()
+		{
+			basist::ktx2_transcoder_state state;
+			if (!transcoder.transcode_image_level(level, 0, 0, image.data.data() + image.levels[level].offset, outputSizes[level], 
+												  target->format, 0, 0, 0, -1, -1, &state))
+			{
+				failed = true;
+			}
+		}, &counter);
+	}
+
+	jobSystem->Wait(&counter);
+
+	if (failed)
+		throw std::runtime_error("failed to transcode Basis Universal data in KTX2 file!");
+}
+
+#endif
+
+Ktx2Image ParseKtx2(Renderer* renderer, std::vector<byte> fileData)
+{
+	if (fileData.size() < sizeof(Ktx2Header))
+		throw std::runtime_error("KTX2 file is too small!");
+
+	Ktx2Header header;
+	memcpy(&header, fileData.data(), sizeof(header));
+
+	if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		throw std::runtime_error("not a KTX2 file!");
+
+	if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+		throw std::runtime_error("only 2D KTX2 textures are supported!");
+
+	Ktx2Image result;
+	result.extent = vk::Extent2D(header.pixelWidth, header.pixelHeight);
+	result.generateMips = header.levelCount == 0;
+
+	if (header.levelCount > GetMipLevelCount(result.extent))
+		throw std::runtime_error("KTX2 file has more levels than its extent allows!");
+
+	uint32 levelCount = std::max(header.levelCount, 1u);
+	if (fileData.size() < sizeof(Ktx2Header) + levelCount * sizeof(Ktx2LevelIndex))
+		throw std::runtime_error("KTX2 level index is truncated!");
+
+	const Ktx2LevelIndex* levelIndex = (const Ktx2LevelIndex*)(fileData.data() + sizeof(Ktx2Header));
+
+	// Written so that no crafted offset or length can wrap around
+	uint64 fileSize = fileData.size();
+
+	result.levels.resize(levelCount);
+	for (uint32 level = 0; level < levelCount; level++)
+	{
+		if (levelIndex[level].byteLength > fileSize || levelIndex[level].byteOffset > fileSize - levelIndex[level].byteLength)
+			throw std::runtime_error("KTX2 level data is out of bounds!");
+
+		result.levels[level].offset = levelIndex[level].byteOffset;
+		result.levels[level].size = levelIndex[level].byteLength;
+	}
+
+	// No Vulkan format means Basis Universal data, supercompressed or not
+	bool basis = header.vkFormat == VK_FORMAT_UNDEFINED || header.supercompressionScheme == KTX2_SUPERCOMPRESSION_BASIS_LZ;
+	if (basis)
+	{
+#ifdef KTX_BASIS_TRANSCODER
+		TranscodeBasis(renderer, fileData, result);
+		return result;
+#else
+		throw std::runtime_error("KTX2 file holds Basis Universal data, build with KTX_BASIS_TRANSCODER to load it!");
+#endif
+	}
+
+	if (header.supercompressionScheme != KTX2_SUPERCOMPRESSION_NONE)
+		throw std::runtime_error("KTX2 supercompression is only supported for Basis Universal data!");
+
+	result.format = (vk::Format)header.vkFormat;
+	if (!IsFormatSampleable(renderer->GetCapabilities(), result.format))
+	{
+		printf("KTX2 format %s is not supported by the device\n", vk::to_string(result.format).c_str());
+		throw std::runtime_error("KTX2 texture format is not supported by the device!");
+	}
+
+	// The uploads copy whole levels of the image extent, a short level would be read past its end
+	for (uint32 level = 0; level < levelCount; level++)
+	{
+		vk::DeviceSize requiredSize = GetTextureLevelSize(result.format, GetMipExtent(result.extent, level));
+		if (requiredSize == 0)
+			throw std::runtime_error("KTX2 texture format has an unknown block layout!");
+
+		if (result.levels[level].size < requiredSize)
+			throw std::runtime_error("KTX2 level is smaller than its format and extent require!");
+	}
+
+	result.data = std::move(fileData);
+	return result;
+}
+
+Ktx2Image LoadKtx2(Renderer* renderer, const String& filename)
+{
+	BufferInfo file = ReadFileToBuffer(filename);
+
+	std::vector<byte> fileData(file.buffer, file.buffer + file.size);
+	delete[] file.buffer;
+
+	return ParseKtx2(renderer, std::move(fileData));
+}
+
+Texture CreateKtx2Texture(Renderer* renderer, const Ktx2Image& image)
+{
+	if (image.generateMips)
+		return CreateTexture(renderer, image.format, image.extent, TEXTURE_FULL_MIP_CHAIN);
+
+	return CreateTexture(renderer, image.format, image.extent, (uint32)image.levels.size());
+}
+
+void UploadKtx2Texture(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, const Ktx2Image& image)
+{
+	if (image.generateMips)
+	{
+		TextureLevelData level = image.GetLevel(0);
+		UploadTexture(renderer, commandBuffer, texture, level.data, level.size);
+		return;
+	}
+
+	// Usually recorded in the frame loop
+	FrameVector<TextureLevelData> levels(image.levels.size());
+	for (uint32 mip = 0; mip < levels.size(); mip++)
+		levels[mip] = image.GetLevel(mip);
+
+	UploadTextureLevels(renderer, commandBuffer, texture, vk::ArrayProxy<const TextureLevelData>((uint32)levels.size(), levels.data()));
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "texture.h"
+
+class Renderer;
+
+// KTX2 containers holding 2D textures. BC, ETC2 and ASTC blocks are uploaded as they are stored once
+// the device reports the format as sampleable. Basis Universal data (BasisLZ/ETC1S and UASTC) needs
+// the transcoder from the basis_universal repository, build with KTX_BASIS_TRANSCODER defined and
+// basisu_transcoder.cpp added. It is transcoded on the job system, one job per mip level, to the best
+// block format the device supports
+
+struct Ktx2Level
+{
+	vk::DeviceSize offset;
+	vk::DeviceSize size;
+};
+
+struct Ktx2Image
+{
+	vk::Format format = vk::Format::eUndefined;
+	vk::Extent2D extent;
+
+	// Files that store a level count of 0 ask for mips to be generated at load time
+	bool generateMips = false;
+
+	// Largest level first, offsets are into data
+	std::vector<Ktx2Level> levels;
+	std::vector<byte> data;
+
+	TextureLevelData GetLevel(uint32 mip) const { return { data.data() + levels[mip].offset, levels[mip].size }; }
+};
+
+// Throws when the file is not a 2D KTX2 texture or the device can't sample its format
+Ktx2Image ParseKtx2(Renderer* renderer, std::vector<byte> fileData);
+Ktx2Image LoadKtx2(Renderer* renderer, const String& filename);
+
+Texture CreateKtx2Texture(Renderer* renderer, const Ktx2Image& image);
+
+// Records the upload of every level, same lifetime rules as UploadTexture
+void UploadKtx2Texture(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, const Ktx2Image& image);
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <chrono>
 #include <iostream>
 
 #include <SDL/SDL.h>
@@ -13,22 +15,17 @@
 #include "types.h"
 
 #include "renderer.h"
-
-struct Vector2f
-{
-	float x, y;
-};
-
-struct Vector3f
-{
-	float x, y, z;
-};
-
-struct Vertex
-{
-	Vector2f pos;
-	Vector3f color;
-};
+#include "file.h"
+#include "shader.h"
+#include "mesh.h"
+#include "pipeline.h"
+#include "instancing.h"
+#include "culling.h"
+#include "rendergraph.h"
+#include "shadervariant.h"
+#include "benchmark.h"
+#include "ktx2.h"
+#include "texturestreamer.h"
 
 Vertex vertices[] = {
 	{ { 0.0f, -0.5f }, { 0.0f, 1.0f, 0.0f } },
@@ -36,414 +33,363 @@ Vertex vertices[] = {
 	{ { -0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f } },
 };
 
-struct BufferInfo
-{
-	byte* buffer;
-	size_t size;
-};
-
-BufferInfo ReadFileToBuffer(const std::string& filename)
-{
-	FILE* file = NULL;
-	fopen_s(&file, filename.c_str(), "rb");
-	assert(file != NULL);
-
-	fseek(file, 0, SEEK_END);
-	uint32 length = ftell(file);
-	fseek(file, 0, SEEK_SET);
+uint32 indices[] = { 0, 1, 2 };
 
-	byte* buffer = new byte[length];
-	fread(buffer, 1, length, file);
-
-	BufferInfo result;
-	result.buffer = buffer;
-	result.size = length;
-
-	fclose(file);
-	return result;
-}
+const uint32 SCENE_GRID_SIZE = 32;
+const uint32 SCENE_OBJECT_COUNT = SCENE_GRID_SIZE * SCENE_GRID_SIZE;
 
-std::string ReadFileToString(const std::string& filename)
+// Offline shader build, every shader is compiled as debug and release SPIR-V and both are written
+// next to the source so they can be compared and shipped side by side
+static void CompileShaderBinaries(ShaderOptimization releaseOptimization)
 {
-	FILE* file = NULL;
-	fopen_s(&file, filename.c_str(), "rt");
-	assert(file != NULL);
-
-	fseek(file, 0, SEEK_END);
-	uint32 length = ftell(file);
-	fseek(file, 0, SEEK_SET);
-
-	std::string result(length, 0);
-	fread(&result[0], 1, length, file);
-
-	fclose(file);
-	return result;
-}
-
-vk::ShaderModule CreateShader(vk::Device device, BufferInfo buffer)
-{
-	vk::ShaderModule result = device.createShaderModule(vk::ShaderModuleCreateInfo(vk::ShaderModuleCreateFlags(), buffer.size, (uint32*)buffer.buffer));
-
-	return result;
-}
-
-vk::RenderPass CreateRenderPass(vk::Device device, vk::Format swapchainImageFormat)
-{
-	vk::AttachmentDescription colorAttachment = {};
-	colorAttachment.setFormat(swapchainImageFormat);
-	colorAttachment.setSamples(vk::SampleCountFlagBits::e1);
-	
-	colorAttachment.setLoadOp(vk::AttachmentLoadOp::eClear);
-	colorAttachment.setStoreOp(vk::AttachmentStoreOp::eStore);
-	
-	colorAttachment.setStencilLoadOp(vk::AttachmentLoadOp::eDontCare);
-	colorAttachment.setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
-
-	colorAttachment.setInitialLayout(vk::ImageLayout::eUndefined);
-	colorAttachment.setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
-
-	vk::AttachmentReference colorAttachmentRef(0, vk::ImageLayout::eColorAttachmentOptimal);
-
-	vk::SubpassDescription subpass = {};
-	subpass.setPipelineBindPoint(vk::PipelineBindPoint::eGraphics);
-	subpass.setColorAttachmentCount(1);
-	subpass.setPColorAttachments(&colorAttachmentRef);
-
-	vk::RenderPassCreateInfo renderPassCreateInfo = {};
-	renderPassCreateInfo.setAttachmentCount(1);
-	renderPassCreateInfo.setPAttachments(&colorAttachment);
-	renderPassCreateInfo.setSubpassCount(1);
-	renderPassCreateInfo.setPSubpasses(&subpass);
-
-	vk::RenderPass result = device.createRenderPass(renderPassCreateInfo);
-
-	return result;
-}
-
-struct Pipeline
-{
-	vk::Pipeline pipeline;
-	vk::PipelineLayout layout;
-};
-
-Pipeline CreateGraphicsPipeline(vk::Device device, vk::Extent2D swapchainExtent, vk::RenderPass renderPass, vk::ShaderModule vertShader, vk::ShaderModule fragShader)
-{
-	vk::PipelineShaderStageCreateInfo vertexShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
-															vk::ShaderStageFlagBits::eVertex,
-															vertShader,
-															"main",
-															nullptr);
-
-	vk::PipelineShaderStageCreateInfo fragmentShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
-															  vk::ShaderStageFlagBits::eFragment,
-															  fragShader,
-															  "main",
-															  nullptr);
-	vk::PipelineShaderStageCreateInfo  shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
-
-	vk::VertexInputBindingDescription vertexInputBindingDesc(0, sizeof(Vertex), vk::VertexInputRate::eVertex);
-
-	vk::VertexInputAttributeDescription attrubuteDescriptions[] = {
-		vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, pos)),
-		vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color)),
+	struct ShaderSource
+	{
+		const char* filename;
+		shaderc_shader_kind kind;
 	};
 
-	vk::PipelineVertexInputStateCreateInfo vertexInputStateInfo = {};
-	vertexInputStateInfo.setVertexBindingDescriptionCount(1);
-	vertexInputStateInfo.setPVertexBindingDescriptions(&vertexInputBindingDesc);
-
-	vertexInputStateInfo.setVertexAttributeDescriptionCount(2);
-	vertexInputStateInfo.setPVertexAttributeDescriptions(attrubuteDescriptions);
-
-	vk::PipelineInputAssemblyStateCreateInfo assemblyInputStateInfo(vk::PipelineInputAssemblyStateCreateFlags(), vk::PrimitiveTopology::eTriangleList, false);
-
-	vk::Viewport viewport(0.0f, 0.0f, (float)swapchainExtent.width, (float)swapchainExtent.height, 0.0f, 1.0f);
-	vk::Rect2D scissor({ 0, 0 }, swapchainExtent);
-
-	vk::PipelineViewportStateCreateInfo viewportStateInfo(vk::PipelineViewportStateCreateFlags(), 1, &viewport, 1, &scissor);
-
-	vk::PipelineRasterizationStateCreateInfo rasterizationStateInfo = {};
-	rasterizationStateInfo.setDepthClampEnable(false);
-
-	rasterizationStateInfo.setRasterizerDiscardEnable(false);
-	rasterizationStateInfo.setPolygonMode(vk::PolygonMode::eFill);
-	rasterizationStateInfo.setLineWidth(1.0f);
-	rasterizationStateInfo.setCullMode(vk::CullModeFlagBits::eBack);
-	rasterizationStateInfo.setFrontFace(vk::FrontFace::eClockwise);
-	rasterizationStateInfo.setDepthBiasEnable(false);
-
-	vk::PipelineMultisampleStateCreateInfo multisampleStateInfo = {};
-	multisampleStateInfo.setSampleShadingEnable(false);
-	multisampleStateInfo.setRasterizationSamples(vk::SampleCountFlagBits::e1);
-	multisampleStateInfo.setMinSampleShading(1.0f);
-
-	vk::PipelineColorBlendAttachmentState colorBlendAttachment = {};
-	colorBlendAttachment.setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
-	colorBlendAttachment.setBlendEnable(false);
-	
-	colorBlendAttachment.setSrcColorBlendFactor(vk::BlendFactor::eOne);
-	colorBlendAttachment.setDstColorBlendFactor(vk::BlendFactor::eZero);
-	colorBlendAttachment.setColorBlendOp(vk::BlendOp::eAdd);
-
-	colorBlendAttachment.setSrcAlphaBlendFactor(vk::BlendFactor::eOne);
-	colorBlendAttachment.setDstAlphaBlendFactor(vk::BlendFactor::eZero);
-	colorBlendAttachment.setAlphaBlendOp(vk::BlendOp::eAdd);
-	
-	vk::PipelineColorBlendStateCreateInfo colorBlendingStateInfo = {};
-	colorBlendingStateInfo.setLogicOpEnable(VK_FALSE);
-	colorBlendingStateInfo.setLogicOp(vk::LogicOp::eCopy);
-	colorBlendingStateInfo.setAttachmentCount(1);
-	colorBlendingStateInfo.setPAttachments(&colorBlendAttachment);
-
-	colorBlendingStateInfo.setBlendConstants(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 0.0f });
-	
-	vk::DynamicState dynamicStates[] = {
-		vk::DynamicState::eViewport
+	ShaderSource shaders[] = {
+		{ "Resources/shader.vert", shaderc_shader_kind::shaderc_vertex_shader },
+		{ "Resources/shader.frag", shaderc_shader_kind::shaderc_fragment_shader },
+		{ "Resources/instanced.vert", shaderc_shader_kind::shaderc_vertex_shader },
+		{ "Resources/material.frag", shaderc_shader_kind::shaderc_fragment_shader },
+		{ "Resources/bindless.frag", shaderc_shader_kind::shaderc_fragment_shader },
+		{ "Resources/cull.comp", shaderc_shader_kind::shaderc_compute_shader },
+		{ "Resources/mipfeedback.comp", shaderc_shader_kind::shaderc_compute_shader },
 	};
 
-	vk::PipelineDynamicStateCreateInfo dynamicStateInfo(vk::PipelineDynamicStateCreateFlags(), 1, dynamicStates);
-
-	vk::PipelineLayout layout = device.createPipelineLayout(vk::PipelineLayoutCreateInfo());
-
-	
-	vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo = {};
-	graphicsPipelineCreateInfo.setStageCount(2);
-	graphicsPipelineCreateInfo.setPStages(shaderStages);
-	
-	graphicsPipelineCreateInfo.setPVertexInputState(&vertexInputStateInfo);
-	graphicsPipelineCreateInfo.setPInputAssemblyState(&assemblyInputStateInfo);
-	graphicsPipelineCreateInfo.setPViewportState(&viewportStateInfo);
-	graphicsPipelineCreateInfo.setPRasterizationState(&rasterizationStateInfo);
-	graphicsPipelineCreateInfo.setPMultisampleState(&multisampleStateInfo);
-	graphicsPipelineCreateInfo.setPDepthStencilState(nullptr);
-	graphicsPipelineCreateInfo.setPColorBlendState(&colorBlendingStateInfo);
-	graphicsPipelineCreateInfo.setPDynamicState(nullptr);
-
-	graphicsPipelineCreateInfo.setLayout(layout);
-	graphicsPipelineCreateInfo.setRenderPass(renderPass);
-	graphicsPipelineCreateInfo.setSubpass(0);
+	for (const ShaderSource& shader : shaders)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<uint32> debugCode = CompileShaderToSpirv(shader.filename, shader.kind, ShaderCompileOptions::Debug());
 
-	graphicsPipelineCreateInfo.setBasePipelineHandle(nullptr);
-	graphicsPipelineCreateInfo.setBasePipelineIndex(-1);
+		auto middle = std::chrono::high_resolution_clock::now();
+		std::vector<uint32> releaseCode = CompileShaderToSpirv(shader.filename, shader.kind, ShaderCompileOptions::Release(releaseOptimization));
 
-	vk::Pipeline pipeline = device.createGraphicsPipeline(nullptr, graphicsPipelineCreateInfo);
+		auto end = std::chrono::high_resolution_clock::now();
 
-	Pipeline result = {};
-	result.pipeline = pipeline;
-	result.layout = layout;
+		String filename = shader.filename;
+		WriteBufferToFile(filename + ".debug.spv", debugCode.data(), debugCode.size() * sizeof(uint32));
+		WriteBufferToFile(filename + ".release.spv", releaseCode.data(), releaseCode.size() * sizeof(uint32));
 
-	return result;
-}
+		std::chrono::duration<double, std::milli> debugTime = middle - start;
+		std::chrono::duration<double, std::milli> releaseTime = end - middle;
 
-uint32 FindMemoryType(vk::PhysicalDevice gpuDevice, uint32 typeFilter, VkMemoryPropertyFlags properties) {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(gpuDevice, &memProperties);
+		size_t debugSize = debugCode.size() * sizeof(uint32);
+		size_t releaseSize = releaseCode.size() * sizeof(uint32);
 
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-			return i;
-		}
+		printf("%s\n", shader.filename);
+		printf("  debug:   %6zu bytes, compiled in %.3f ms\n", debugSize, debugTime.count());
+		printf("  release: %6zu bytes, compiled in %.3f ms (%.1f%% of debug)\n", releaseSize, releaseTime.count(), 100.0 * releaseSize / debugSize);
 	}
-
-	throw std::runtime_error("failed to find suitable memory type!");
 }
 
-const uint32 NUM_FRAMES = 2;
-
-#if 1
 int main(int argc, char** argv)
 {
-	shaderc::Compiler compiler;
-	shaderc::CompileOptions options;
+	// Offline shader build, release binaries are optimized for size when asked for, performance otherwise
+	if (argc > 1 && strcmp(argv[1], "--compile-shaders") == 0)
+	{
+		bool optimizeSize = argc > 2 && strcmp(argv[2], "--optimize-size") == 0;
+		CompileShaderBinaries(optimizeSize ? ShaderOptimization::Size : ShaderOptimization::Performance);
+		return 0;
+	}
 
-	std::string file = ReadFileToString("Resources/shader.vert");
+	if (argc > 1 && strcmp(argv[1], "--bench-math") == 0)
+	{
+		RunMathBenchmark();
+		return 0;
+	}
 
-	auto result = compiler.CompileGlslToSpvAssembly(file, shaderc_shader_kind::shaderc_vertex_shader, "shader.vert", options);
-	std::string test(result.begin(), result.end());
-	printf("Error: %s\n", result.GetErrorMessage().c_str());
-	printf("Result Text: %s\n", test.c_str());
-	return 0;
-}
-#else
-int main(int argc, char** argv)
-{
 	SDL_Init(SDL_INIT_VIDEO);
 
 	SDL_Window* window = SDL_CreateWindow("Hello World", 
 										  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 
 										  1280, 720, 
-										  SDL_WINDOW_VULKAN);
+										  SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
 	assert(window != NULL);
 
-	Renderer* renderer = new Renderer(window);
+	RendererSettings settings;
+	const char* memoryStatsFile = nullptr;
+	const char* textureFile = nullptr;
+	const char* streamedTextureFile = nullptr;
+	bool depthPrepass = false;
+	uint32 allocationTestFrames = 0;
+	for (int32 index = 1; index < argc; index++)
+	{
+		if (strcmp(argv[index], "--no-bindless") == 0)
+			settings.bindless = false;
+		else if (strcmp(argv[index], "--no-host-allocator") == 0)
+			settings.hostAllocator = false;
+		else if (strcmp(argv[index], "--no-validation") == 0)
+			settings.validation = false;
+		else if (strcmp(argv[index], "--validation") == 0)
+			settings.validation = true;
+		else if (strcmp(argv[index], "--memory-stats") == 0 && index + 1 < argc)
+			memoryStatsFile = argv[++index];
+		else if (strcmp(argv[index], "--texture") == 0 && index + 1 < argc)
+			textureFile = argv[++index];
+		else if (strcmp(argv[index], "--stream") == 0 && index + 1 < argc)
+			streamedTextureFile = argv[++index];
+		else if (strcmp(argv[index], "--depth-prepass") == 0)
+			depthPrepass = true;
+		else if (strcmp(argv[index], "--test-allocations") == 0)
+			allocationTestFrames = 64;
+	}
+
+	Renderer* renderer = new Renderer(window, settings);
 
 	vk::Device device = renderer->GetDevice();
 	Swapchain* swapchain = renderer->GetSwapchain();
 
-	vk::PhysicalDeviceProperties deviceProperties = renderer->GetGPUDevice().getProperties();
+	const vk::PhysicalDeviceProperties& deviceProperties = renderer->GetCapabilities().properties;
 	printf("GPU Device Name: %s\n", deviceProperties.deviceName);
+	printf("Bindless: %s\n", renderer->IsBindlessEnabled() ? "enabled" : "disabled");
 
 	const std::vector<vk::ImageView>& imageViews = swapchain->GetImageViews();
 	const std::vector<vk::Image>& images = swapchain->GetImages();
-	QueueFamilyIndicies queueIndicies = renderer->GetQueueFamilyIndicies(renderer->GetGPUDevice());
+	QueueFamilyIndicies queueIndicies = renderer->GetQueueFamilyIndicies();
 
-	BufferInfo vertexShaderFile = ReadFileToBuffer("Resources/vert.spv");
-	vk::ShaderModule vertexShaderModule = CreateShader(device, vertexShaderFile);
+	vk::ShaderModule vertexShaderModule = CompileShader(device, "Resources/instanced.vert", shaderc_shader_kind::shaderc_vertex_shader);
 
 	BufferInfo fragmentShaderFile = ReadFileToBuffer("Resources/frag.spv");
 	vk::ShaderModule fragmentShaderModule = CreateShader(device, fragmentShaderFile);
 
-	vk::RenderPass renderPass = CreateRenderPass(device, swapchain->GetImageFormat().format);
-	Pipeline pipeline = CreateGraphicsPipeline(device, swapchain->GetExtent(), renderPass, vertexShaderModule, fragmentShaderModule);
+	// Bindless scenes sample their texture through the heap, without it objects only have vertex colors
+	BindlessHeap* bindlessHeap = renderer->GetBindlessHeap();
+	vk::ShaderModule bindlessShaderModule;
+	if (bindlessHeap)
+		bindlessShaderModule = CompileShader(device, "Resources/bindless.frag", shaderc_shader_kind::shaderc_fragment_shader);
+
+	// The render graph moves the swapchain image in and out of the attachment layout
+	RenderPassCache* renderPassCache = renderer->GetRenderPassCache();
+	FramebufferCache* framebufferCache = renderer->GetFramebufferCache();
+
+	vk::Format depthFormat = renderer->GetDepthFormat();
+	printf("Depth: %s%s\n", vk::to_string(depthFormat).c_str(), depthPrepass ? " with pre-pass" : "");
 
-	
-	std::vector<vk::Framebuffer> framebuffers;
-	framebuffers.resize(imageViews.size());
+	// With the pre-pass the scene pass only tests against the depth it laid down, every pixel is shaded once
+	AttachmentDesc colorAttachment;
+	colorAttachment.format = swapchain->GetImageFormat().format;
+	colorAttachment.initialLayout = vk::ImageLayout::eColorAttachmentOptimal;
+	colorAttachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
 
-	for (uint32 index = 0; index < imageViews.size(); index++)
+	AttachmentDesc depthAttachment;
+	depthAttachment.format = depthFormat;
+	depthAttachment.loadOp = depthPrepass ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+	depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+	depthAttachment.initialLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+	depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+
+	RenderPassKey renderPassKey;
+	renderPassKey.colorAttachments.push_back(colorAttachment);
+	renderPassKey.depthAttachment = depthAttachment;
+
+	vk::RenderPass renderPass = renderPassCache->GetRenderPass(renderPassKey);
+
+	RenderPassKey prepassKey;
+	prepassKey.depthAttachment = depthAttachment;
+	prepassKey.depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+	prepassKey.depthAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+
+	vk::RenderPass prepassRenderPass = renderPassCache->GetRenderPass(prepassKey);
+
+	UniformAllocator* uniformAllocator = renderer->GetUniformAllocator();
+
+	PipelineStateCache* pipelineCache = renderer->GetPipelineStateCache();
+
+	GraphicsPipelineDesc pipelineDesc;
+	pipelineDesc.vertexShader = vertexShaderModule;
+	pipelineDesc.fragmentShader = fragmentShaderModule;
+	pipelineDesc.vertexLayout = InstanceData::GetInstancedLayout();
+	pipelineDesc.renderPass = renderPass;
+	pipelineDesc.setLayouts = { uniformAllocator->GetLayout() };
+	pipelineDesc.pushConstantRanges = { vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(DrawPushConstants)) };
+
+	// Only the plain layout, for what draws without the heap
+	GraphicsPipelineDesc plainDesc = pipelineDesc;
+
+	// The texture indices follow the draw constants
+	vk::PushConstantRange bindlessIndicesRange;
+	if (bindlessHeap)
 	{
-		vk::ImageView attachments[] = {
-			imageViews[index]
-		};
-
-		vk::FramebufferCreateInfo framebufferCreateInfo = {};
-		framebufferCreateInfo.setRenderPass(renderPass);
-		framebufferCreateInfo.setAttachmentCount(1);
-		framebufferCreateInfo.setPAttachments(attachments);
-		framebufferCreateInfo.setWidth(swapchain->GetExtent().width);
-		framebufferCreateInfo.setHeight(swapchain->GetExtent().height);
-		framebufferCreateInfo.setLayers(1);
-
-		framebuffers[index] = device.createFramebuffer(framebufferCreateInfo);
+		bindlessIndicesRange = bindlessHeap->GetPushConstantRange(sizeof(DrawPushConstants));
+
+		pipelineDesc.fragmentShader = bindlessShaderModule;
+		pipelineDesc.setLayouts.push_back(bindlessHeap->GetLayout());
+		pipelineDesc.pushConstantRanges.push_back(bindlessIndicesRange);
 	}
 
-	vk::BufferCreateInfo vertexBufferCreateInfo = {};
-	vertexBufferCreateInfo.setSize(sizeof(Vertex) * 3);
-	vertexBufferCreateInfo.setUsage(vk::BufferUsageFlagBits::eVertexBuffer);
-	vertexBufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+	// Equal depth still passes, the scene is flat and overlapping objects keep drawing in order
+	pipelineDesc.depthTestEnable = true;
+	pipelineDesc.depthWriteEnable = !depthPrepass;
+	pipelineDesc.depthCompareOp = depthPrepass ? vk::CompareOp::eEqual : vk::CompareOp::eLessOrEqual;
 
-	vk::Buffer vertexBuffer = device.createBuffer(vertexBufferCreateInfo);
+	Pipeline pipeline = pipelineCache->GetGraphicsPipeline(pipelineDesc);
 
-	vk::MemoryRequirements memRequirements = device.getBufferMemoryRequirements(vertexBuffer);
+	// Same vertex shader and inputs as the scene so the depth matches exactly, and no culling so every
+	// face the scene pipelines may draw has its depth written
+	GraphicsPipelineDesc prepassDesc = pipelineDesc;
+	prepassDesc.fragmentShader = nullptr;
+	prepassDesc.colorAttachmentCount = 0;
+	prepassDesc.cullMode = vk::CullModeFlagBits::eNone;
+	prepassDesc.depthWriteEnable = true;
+	prepassDesc.depthCompareOp = vk::CompareOp::eLessOrEqual;
+	prepassDesc.renderPass = prepassRenderPass;
 
-	vk::MemoryAllocateInfo allocInfo = {};
-	allocInfo.setAllocationSize(memRequirements.size);
-	allocInfo.setMemoryTypeIndex(FindMemoryType(renderer->GetGPUDevice(), 
-								 memRequirements.memoryTypeBits, 
-								 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+	Pipeline prepassPipeline = pipelineCache->GetGraphicsPipeline(prepassDesc);
 
-	vk::DeviceMemory vertexBufferMemory = device.allocateMemory(allocInfo);
+	// Stands in for a material that streams in later, it compiles in the background while the
+	// scene keeps drawing with the base pipeline
+	GraphicsPipelineDesc materialDesc = pipelineDesc;
+	materialDesc.cullMode = vk::CullModeFlagBits::eNone;
+	materialDesc.blendEnable = true;
+	materialDesc.dstColorBlendFactor = vk::BlendFactor::eOne;
 
-	device.bindBufferMemory(vertexBuffer, vertexBufferMemory, 0);
+	// The material flips between its color and grayscale variant, brightness is a specialization constant
+	ShaderVariants* materialShaders = new ShaderVariants(renderer, "Resources/instanced.vert", "Resources/material.frag", 
+														 { "FEATURE_GRAYSCALE", "FEATURE_TEXTURED" }, materialDesc);
 
-	void* data = device.mapMemory(vertexBufferMemory, 0, vertexBufferCreateInfo.size);
-	memcpy(data, vertices, vertexBufferCreateInfo.size);
-	device.unmapMemory(vertexBufferMemory);
+	const uint32 MATERIAL_FEATURE_GRAYSCALE = 1 << 0;
+	const uint32 MATERIAL_FEATURE_TEXTURED = 1 << 1;
+	const uint32 MATERIAL_CONSTANT_BRIGHTNESS = 0;
 
-	vk::CommandPool commandPool = device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlags(), queueIndicies.graphicsIndex));
+	Mesh triangle = CreateMesh(renderer, vertices, 3, indices, 3);
 
-	vk::CommandBufferAllocateInfo commandBufferAllocInfo(commandPool, vk::CommandBufferLevel::ePrimary, (uint32)framebuffers.size());
-	std::vector<vk::CommandBuffer> commandBuffers = device.allocateCommandBuffers(commandBufferAllocInfo);
+	if (argc > 1 && strcmp(argv[1], "--bench-instancing") == 0)
+	{
+		// Runs outside of the render graph, so it uses a compatible pass that does its own transitions
+		vk::RenderPass benchmarkPass = renderPassCache->GetRenderPass(swapchain->GetImageFormat().format, 
+																	  vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR);
+		vk::Framebuffer benchmarkFramebuffer = framebufferCache->GetFramebuffer(benchmarkPass, { imageViews[0] }, swapchain->GetExtent());
 
-	vk::ClearValue clearColor(vk::ClearColorValue(std::array<float, 4> { 1.0f, 0.0f, 1.0f, 1.0f }));
+		GraphicsPipelineDesc benchmarkDesc = plainDesc;
+		benchmarkDesc.renderPass = benchmarkPass;
+		benchmarkDesc.depthTestEnable = false;
+		benchmarkDesc.depthWriteEnable = false;
 
-	VkImageSubresourceRange subResourceRange = {};
-	subResourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subResourceRange.baseMipLevel = 0;
-	subResourceRange.levelCount = 1;
-	subResourceRange.baseArrayLayer = 0;
-	subResourceRange.layerCount = 1;
+		RunInstancingBenchmark(renderer, benchmarkPass, benchmarkFramebuffer, swapchain->GetExtent(), pipelineCache->GetGraphicsPipeline(benchmarkDesc), triangle);
+	}
 
-/*	for (uint32 index = 0; index < imageViews.size(); index++)
-	{
-		vk::CommandBuffer commandBuffer = commandBuffers[index];
-		commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse, nullptr));
-
-		vk::ImageMemoryBarrier presentToClearBarrier = {};
-		presentToClearBarrier.setSrcAccessMask(vk::AccessFlagBits::eMemoryRead);
-		presentToClearBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
-		
-		presentToClearBarrier.setOldLayout(vk::ImageLayout::eUndefined);
-		presentToClearBarrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
-		
-		presentToClearBarrier.setSrcQueueFamilyIndex(queueIndicies.presentIndex);
-		presentToClearBarrier.setDstQueueFamilyIndex(queueIndicies.presentIndex);
-		
-		presentToClearBarrier.setImage(images[index]);
-		presentToClearBarrier.setSubresourceRange(subResourceRange);
-
-		// Change layout of image to be optimal for presenting
-		vk::ImageMemoryBarrier clearToPresentBarrier = {};
-		
-		clearToPresentBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-		clearToPresentBarrier.setDstAccessMask(vk::AccessFlagBits::eMemoryRead);
-
-		clearToPresentBarrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-		clearToPresentBarrier.setNewLayout(vk::ImageLayout::ePresentSrcKHR);
-		
-		clearToPresentBarrier.setSrcQueueFamilyIndex(queueIndicies.presentIndex);
-		clearToPresentBarrier.setDstQueueFamilyIndex(queueIndicies.presentIndex);
-		
-		clearToPresentBarrier.setImage(images[index]);
-		clearToPresentBarrier.setSubresourceRange(subResourceRange);
-
-		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr, nullptr, { presentToClearBarrier });
-		commandBuffer.clearColorImage(images[index], vk::ImageLayout::eTransferDstOptimal, clearColor, { subResourceRange });
-		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr, nullptr, { clearToPresentBarrier });
-
-		commandBuffer.end();
-	}*/
-
-	for (uint32 index = 0; index < imageViews.size(); index++)
-	{
-		vk::CommandBuffer commandBuffer = commandBuffers[index];
-		commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse, nullptr));
+	if (argc > 1 && strcmp(argv[1], "--test-graph") == 0 && !RunRenderGraphTests(renderer))
+		throw std::runtime_error("Render graph tests failed!");
 
-		vk::ImageMemoryBarrier presentToClearBarrier = {};
-		presentToClearBarrier.setSrcAccessMask(vk::AccessFlagBits::eMemoryRead);
-		presentToClearBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+	if (argc > 1 && strcmp(argv[1], "--report-aliasing") == 0)
+		RunAliasingReport(renderer, swapchain->GetExtent());
 
-		presentToClearBarrier.setOldLayout(vk::ImageLayout::eUndefined);
-		presentToClearBarrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+	if (argc > 1 && strcmp(argv[1], "--bench-dispatch") == 0)
+		RunDispatchBenchmark(renderer);
 
-		presentToClearBarrier.setSrcQueueFamilyIndex(queueIndicies.presentIndex);
-		presentToClearBarrier.setDstQueueFamilyIndex(queueIndicies.presentIndex);
+	if (argc > 1 && strcmp(argv[1], "--report-defrag") == 0)
+		RunDefragmentReport(renderer);
 
-		presentToClearBarrier.setImage(images[index]);
-		presentToClearBarrier.setSubresourceRange(subResourceRange);
+	if (argc > 1 && strcmp(argv[1], "--report-shaders") == 0)
+		RunShaderReport(renderer, pipelineDesc, "Resources/instanced.vert", "Resources/material.frag");
 
-		// Change layout of image to be optimal for presenting
-		vk::ImageMemoryBarrier clearToPresentBarrier = {};
+	// Device local and sub-allocated, so the defragmenter may move it between frames. The contents
+	// are uploaded with the first frame and the handle is resolved again every frame
+	BufferAllocator* bufferAllocator = renderer->GetBufferAllocator();
+	vk::DeviceSize sceneInstanceSize = sizeof(InstanceData) * SCENE_OBJECT_COUNT;
+	BufferHandle sceneInstanceHandle = bufferAllocator->Allocate(sceneInstanceSize);
 
-		clearToPresentBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-		clearToPresentBarrier.setDstAccessMask(vk::AccessFlagBits::eMemoryRead);
+	// The scene spans twice the screen in each direction so the culling has something to reject
+	std::vector<InstanceData> sceneInstances(SCENE_OBJECT_COUNT);
+	std::vector<CullObject> sceneObjects(SCENE_OBJECT_COUNT);
 
-		clearToPresentBarrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-		clearToPresentBarrier.setNewLayout(vk::ImageLayout::ePresentSrcKHR);
+	float cellSize = 4.0f / SCENE_GRID_SIZE;
+	for (uint32 index = 0; index < SCENE_OBJECT_COUNT; index++)
+	{
+		uint32 x = index % SCENE_GRID_SIZE;
+		uint32 y = index / SCENE_GRID_SIZE;
 
-		clearToPresentBarrier.setSrcQueueFamilyIndex(queueIndicies.presentIndex);
-		clearToPresentBarrier.setDstQueueFamilyIndex(queueIndicies.presentIndex);
+		float centerX = -2.0f + cellSize * (x + 0.5f);
+		float centerY = -2.0f + cellSize * (y + 0.5f);
 
-		clearToPresentBarrier.setImage(images[index]);
-		clearToPresentBarrier.setSubresourceRange(subResourceRange);
+		sceneInstances[index].transform = Matrix4f::Translation({ centerX, centerY, 0.0f }) * Matrix4f::Scale({ cellSize, cellSize, 1.0f });
+		sceneInstances[index].color = { 1.0f, (float)x / SCENE_GRID_SIZE, (float)y / SCENE_GRID_SIZE };
 
-		vk::RenderPassBeginInfo renderPassInfo(renderPass, 
-											   framebuffers[index], 
-											   vk::Rect2D(vk::Offset2D(), swapchain->GetExtent()), 
-											   1, &clearColor);
+		sceneObjects[index].center = { centerX, centerY, 0.0f };
+		sceneObjects[index].radius = cellSize * 0.71f;
+		sceneObjects[index].indexCount = triangle.indexCount;
+		sceneObjects[index].firstIndex = 0;
+		sceneObjects[index].vertexOffset = 0;
+	}
 
-		commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline);
+	GpuCuller* culler = new GpuCuller(renderer, SCENE_OBJECT_COUNT);
+	culler->SetObjects(sceneObjects.data(), SCENE_OBJECT_COUNT);
 
-		commandBuffer.bindVertexBuffers(0, { vertexBuffer }, { 0 });
+	// A KTX2 file from the command line, or placeholder content until there are real assets. Either
+	// way it is uploaded with the first frame
+	Ktx2Image sceneTextureImage;
+	if (textureFile)
+	{
+		sceneTextureImage = LoadKtx2(renderer, textureFile);
+		printf("Loaded %s: %ux%u %s, %u levels\n", textureFile, sceneTextureImage.extent.width, sceneTextureImage.extent.height, 
+			   vk::to_string(sceneTextureImage.format).c_str(), (uint32)sceneTextureImage.levels.size());
+	}
+	else
+	{
+		const uint32 CHECKERBOARD_SIZE = 256;
 
-		commandBuffer.draw(3, 1, 0, 0);
+		sceneTextureImage.format = vk::Format::eR8G8B8A8Unorm;
+		sceneTextureImage.extent = vk::Extent2D(CHECKERBOARD_SIZE, CHECKERBOARD_SIZE);
+		sceneTextureImage.generateMips = true;
+		sceneTextureImage.levels.push_back({ 0, CHECKERBOARD_SIZE * CHECKERBOARD_SIZE * sizeof(uint32) });
+		sceneTextureImage.data.resize(CHECKERBOARD_SIZE * CHECKERBOARD_SIZE * sizeof(uint32));
 
-		commandBuffer.endRenderPass();
+		uint32* pixels = (uint32*)sceneTextureImage.data.data();
+		for (uint32 index = 0; index < CHECKERBOARD_SIZE * CHECKERBOARD_SIZE; index++)
+		{
+			uint32 x = (index % CHECKERBOARD_SIZE) / 32;
+			uint32 y = (index / CHECKERBOARD_SIZE) / 32;
+			pixels[index] = (x + y) % 2 ? 0xFFFFFFFF : 0xFF404040;
+		}
+	}
+
+	Texture sceneTexture = CreateKtx2Texture(renderer, sceneTextureImage);
+	SetObjectName(device, sceneTexture.image, textureFile ? textureFile : "Checkerboard");
 
-		commandBuffer.end();
+	SamplerDesc samplerDesc;
+	samplerDesc.maxAnisotropy = 8.0f;
+	vk::Sampler sceneTextureSampler = renderer->GetSamplerCache()->GetSampler(samplerDesc);
+
+	// Bindless draws reach it through these indices, the slot is only read once the upload is done
+	BindlessPushConstants sceneTextureIndices = {};
+	if (bindlessHeap)
+	{
+		sceneTextureIndices.textureIndex = bindlessHeap->RegisterTexture(sceneTexture.view, vk::ImageLayout::eShaderReadOnlyOptimal);
+		sceneTextureIndices.samplerIndex = bindlessHeap->RegisterSampler(sceneTextureSampler);
 	}
 
+	// Every scene object uses the streamed texture, its levels follow how large the objects are on screen
+	TextureStreamer* textureStreamer = new TextureStreamer(renderer, 16, SCENE_OBJECT_COUNT);
+	StreamedTextureId streamedTexture = INVALID_STREAMED_TEXTURE;
+	if (streamedTextureFile)
+	{
+		streamedTexture = textureStreamer->Load(streamedTextureFile);
+
+		std::vector<StreamingObject> streamingObjects(SCENE_OBJECT_COUNT);
+		for (uint32 index = 0; index < SCENE_OBJECT_COUNT; index++)
+		{
+			streamingObjects[index].center = sceneObjects[index].center;
+			streamingObjects[index].radius = sceneObjects[index].radius;
+			streamingObjects[index].texture = streamedTexture;
+		}
+
+		textureStreamer->SetObjects(streamingObjects.data(), SCENE_OBJECT_COUNT);
+	}
+
+	vk::CommandPool commandPool = device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueIndicies.graphicsIndex), GetAllocationCallbacks(vk::ObjectType::eCommandPool));
+
+	vk::CommandBufferAllocateInfo commandBufferAllocInfo(commandPool, vk::CommandBufferLevel::ePrimary, NUM_FRAMES);
+	std::vector<vk::CommandBuffer> commandBuffers = device.allocateCommandBuffers(commandBufferAllocInfo);
+	for (vk::CommandBuffer commandBuffer : commandBuffers)
+		SetObjectName(device, commandBuffer, "Frame");
+
+	vk::ClearValue clearValues[2];
+	clearValues[0].setColor(vk::ClearColorValue(std::array<float, 4> { 1.0f, 0.0f, 1.0f, 1.0f }));
+	clearValues[1].setDepthStencil(vk::ClearDepthStencilValue(1.0f, 0));
+
+	RenderGraph* renderGraph = new RenderGraph(renderer);
 
 	std::vector<vk::Semaphore> imageAvailableSemaphore(NUM_FRAMES);
 	std::vector<vk::Semaphore> renderingDoneSemaphore(NUM_FRAMES);
@@ -454,12 +400,34 @@ int main(int argc, char** argv)
 
 	for (uint32 index = 0; index < NUM_FRAMES; index++)
 	{
-		imageAvailableSemaphore[index] = device.createSemaphore(semaphoreCreateInfo);
-		renderingDoneSemaphore[index] = device.createSemaphore(semaphoreCreateInfo);
-		fences[index] = device.createFence(fenceCreateInfo);
+		imageAvailableSemaphore[index] = device.createSemaphore(semaphoreCreateInfo, GetAllocationCallbacks(vk::ObjectType::eSemaphore));
+		renderingDoneSemaphore[index] = device.createSemaphore(semaphoreCreateInfo, GetAllocationCallbacks(vk::ObjectType::eSemaphore));
+		fences[index] = device.createFence(fenceCreateInfo, GetAllocationCallbacks(vk::ObjectType::eFence));
 	}
 
 	uint32 currentFrame = 0;
+	bool swapchainDirty = false;
+	bool minimized = false;
+
+	// The report on exit only covers driver allocations made by the frame loop
+	HostAllocator* hostAllocator = GetHostAllocator();
+	if (hostAllocator)
+		hostAllocator->ResetCounters();
+
+	// The variant keys hold vectors, so both materials are set up once rather than every frame
+	ShaderVariantKey materialKeys[2];
+	materialKeys[1].featureMask = MATERIAL_FEATURE_GRAYSCALE;
+	for (ShaderVariantKey& materialKey : materialKeys)
+	{
+		materialKey.SetConstant(MATERIAL_CONSTANT_BRIGHTNESS, 1.25f);
+		if (bindlessHeap)
+			materialKey.featureMask |= MATERIAL_FEATURE_TEXTURED;
+	}
+
+	// Transient CPU data comes from the frame allocators, a frame that still hits the heap is a regression
+	uint64 lastFrameHeapAllocations = 0;
+	uint32 heapAllocatingFrames = 0;
+	uint32 frameCount = 0;
 
 	bool running = true;
 	while (running)
@@ -469,22 +437,228 @@ int main(int argc, char** argv)
 		{
 			if (event.type == SDL_QUIT)
 				running = false;
+			else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+				swapchainDirty = true;
+			else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_MINIMIZED)
+				minimized = true;
+			else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESTORED)
+				minimized = false;
+		}
+
+		// Nothing is presented while minimized, and a 0x0 surface can't get a swapchain. The swapchain
+		// stays dirty and the loop sleeps until the next window event instead of spinning
+		if (minimized)
+		{
+			SDL_WaitEvent(nullptr);
+			continue;
+		}
+
+		if (swapchainDirty)
+		{
+			if (!renderer->RecreateSwapchain())
+			{
+				SDL_WaitEvent(nullptr);
+				continue;
+			}
+
+			swapchainDirty = false;
+		}
+
+		uint64 frameHeapAllocations = GetThreadHeapAllocationCount();
+
+		device.waitForFences({ fences[currentFrame] }, true, UINT64_MAX, GetDispatch());
+
+		renderer->BeginFrame(currentFrame);
+
+		uint32 imageIndex = 0;
+		try
+		{
+			vk::ResultValue<uint32> acquireResult = device.acquireNextImageKHR(swapchain->GetSwapchainHandle(), 
+																			   UINT64_MAX, 
+																			   imageAvailableSemaphore[currentFrame], 
+																			   nullptr, GetDispatch());
+			if (acquireResult.result != vk::Result::eSuccess && 
+				acquireResult.result != vk::Result::eSuboptimalKHR) 
+			{
+				std::cerr << "Error: Failed to acquire image" << std::endl;
+				exit(1);
+			}
+
+			imageIndex = acquireResult.value;
+		}
+		catch (const vk::OutOfDateKHRError&)
+		{
+			// The fence is still signaled, the frame is simply tried again on the new swapchain
+			swapchainDirty = true;
+			continue;
 		}
 
-		device.waitForFences({ fences[currentFrame] }, true, UINT64_MAX);
-		device.resetFences({ fences[currentFrame] });
+		device.resetFences({ fences[currentFrame] }, GetDispatch());
+
+		vk::CommandBuffer commandBuffer = commandBuffers[currentFrame];
+		commandBuffer.reset(vk::CommandBufferResetFlags(), GetDispatch());
+		commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr), GetDispatch());
+
+		// Every render graph pass becomes a profiler scope and a label
+		Profiler* profiler = renderer->GetProfiler();
+		profiler->ResetQueries(commandBuffer);
+
+		// Before anything resolves buffer handles for this frame
+		bufferAllocator->Defragment(commandBuffer);
+		BufferRange sceneInstanceRange = bufferAllocator->Resolve(sceneInstanceHandle);
+
+		if (frameCount == 0)
+		{
+			UploadKtx2Texture(renderer, commandBuffer, sceneTexture, sceneTextureImage);
+
+			StagingAllocation staging = renderer->GetStagingRing()->Upload(sceneInstances.data(), sceneInstanceSize);
+			commandBuffer.copyBuffer(staging.buffer, sceneInstanceRange.buffer, vk::BufferCopy(staging.offset, sceneInstanceRange.offset, sceneInstanceSize), GetDispatch());
+
+			vk::MemoryBarrier uploadBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eVertexAttributeRead);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, 
+										  vk::DependencyFlags(), uploadBarrier, nullptr, nullptr, GetDispatch());
+		}
+
+		textureStreamer->Update(commandBuffer);
+
+		// The camera pans across the scene, objects leaving the view get culled on the GPU
+		float time = SDL_GetTicks() / 1000.0f;
+
+		FrameUniforms frameUniforms = {};
+		frameUniforms.viewProjection = Matrix4f::Translation({ sinf(time * 0.5f), cosf(time * 0.5f) * 0.5f, 0.0f });
+		UniformAllocation frameAllocation = uniformAllocator->Push(frameUniforms);
+
+		DrawPushConstants drawConstants = {};
+		drawConstants.tint = Vector4f(1.0f, 0.75f + sinf(time) * 0.25f, 1.0f, 1.0f);
+
+		Frustum frustum = ExtractFrustum(frameUniforms.viewProjection);
+
+		// The streamed texture once its first levels are in, the scene texture until then
+		BindlessPushConstants textureIndices = sceneTextureIndices;
+		if (streamedTexture != INVALID_STREAMED_TEXTURE && textureStreamer->GetBindlessIndex(streamedTexture) != BINDLESS_INVALID_INDEX)
+			textureIndices.textureIndex = textureStreamer->GetBindlessIndex(streamedTexture);
+
+		const ShaderVariantKey& materialKey = materialKeys[((uint32)time / 4) % 2];
+		Pipeline scenePipeline = materialShaders->GetPipelineAsync(materialKey, pipeline);
+
+		// The swapchain image contents are thrown away, but the first write has to wait for the acquire
+		ResourceState acquiredState;
+		acquiredState.stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+
+		// The draw buffers were last read by the indirect draws of the previous frame
+		ResourceState drawBufferState = GetUsageState(ResourceUsage::IndirectRead);
+
+		renderGraph->Reset();
 
-		vk::ResultValue<uint32> imageIndex = device.acquireNextImageKHR(swapchain->GetSwapchainHandle(), 
-																		UINT64_MAX, 
-																		imageAvailableSemaphore[currentFrame], 
-																		nullptr);
-		if (imageIndex.result != vk::Result::eSuccess && 
-			imageIndex.result != vk::Result::eSuboptimalKHR) 
+		RenderGraphResource backbuffer = renderGraph->ImportImage("Backbuffer", images[imageIndex], vk::ImageAspectFlagBits::eColor, acquiredState);
+		RenderGraphResource drawCommands = renderGraph->ImportBuffer("DrawCommands", culler->GetDrawCommandBuffer(), drawBufferState);
+		RenderGraphResource drawCount = renderGraph->ImportBuffer("DrawCount", culler->GetDrawCountBuffer(), drawBufferState);
+		renderGraph->MarkOutput(backbuffer, ResourceUsage::Present);
+
+		// Transient so it is only backed while a pass uses it and follows the swapchain extent on resize
+		RenderGraphResource depth = renderGraph->CreateImage("Depth", { depthFormat, swapchain->GetExtent(), 
+										vk::ImageUsageFlagBits::eDepthStencilAttachment, GetDepthAspect(depthFormat) });
+
+		// Read on the host once the frame is done, the next time this frame index comes around
+		RenderGraphResource mipFeedback = renderGraph->ImportBuffer("MipFeedback", textureStreamer->GetFeedbackBuffer(), GetUsageState(ResourceUsage::HostRead));
+		renderGraph->MarkOutput(mipFeedback, ResourceUsage::HostRead);
+
+		renderGraph->AddPass("Cull", queueIndicies.graphicsIndex, 
+			[&](RenderPassBuilder& builder)
+			{
+				builder.Write(drawCommands, ResourceUsage::TransferWrite).Write(drawCommands, ResourceUsage::ComputeBufferWrite);
+				builder.Write(drawCount, ResourceUsage::TransferWrite).Write(drawCount, ResourceUsage::ComputeBufferWrite);
+			},
+			[&](vk::CommandBuffer passCommandBuffer)
+			{
+				culler->Cull(passCommandBuffer, frustum);
+			});
+
+		renderGraph->AddPass("MipFeedback", queueIndicies.graphicsIndex, 
+			[&](RenderPassBuilder& builder)
+			{
+				builder.Write(mipFeedback, ResourceUsage::TransferWrite).Write(mipFeedback, ResourceUsage::ComputeBufferWrite);
+			},
+			[&](vk::CommandBuffer passCommandBuffer)
+			{
+				textureStreamer->RecordFeedback(passCommandBuffer, frameUniforms.viewProjection, swapchain->GetExtent());
+			});
+
+		if (depthPrepass)
 		{
-			std::cerr << "Error: Failed to acquire image" << std::endl;
-			exit(1);
+			renderGraph->AddPass("DepthPrepass", queueIndicies.graphicsIndex, 
+				[&](RenderPassBuilder& builder)
+				{
+					builder.Write(depth, ResourceUsage::DepthAttachment);
+					builder.Read(drawCommands, ResourceUsage::IndirectRead).Read(drawCount, ResourceUsage::IndirectRead);
+				},
+				[&](vk::CommandBuffer passCommandBuffer)
+				{
+					vk::Extent2D extent = swapchain->GetExtent();
+					vk::Framebuffer framebuffer = framebufferCache->GetFramebuffer(prepassRenderPass, { renderGraph->GetImageView(depth) }, extent);
+
+					vk::RenderPassBeginInfo renderPassInfo(prepassRenderPass, framebuffer, vk::Rect2D(vk::Offset2D(), extent), 1, &clearValues[1]);
+
+					passCommandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline, GetDispatch());
+					passCommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, prepassPipeline.pipeline, GetDispatch());
+					SetViewport(passCommandBuffer, extent);
+
+					passCommandBuffer.bindVertexBuffers(0, { triangle.vertexBuffer.buffer, sceneInstanceRange.buffer }, { 0, sceneInstanceRange.offset }, GetDispatch());
+					passCommandBuffer.bindIndexBuffer(triangle.indexBuffer.buffer, 0, vk::IndexType::eUint32, GetDispatch());
+
+					uniformAllocator->Bind(passCommandBuffer, vk::PipelineBindPoint::eGraphics, prepassPipeline.layout, 0, frameAllocation);
+					PushConstants(passCommandBuffer, prepassPipeline, vk::ShaderStageFlagBits::eVertex, drawConstants);
+
+					culler->Draw(passCommandBuffer);
+
+					passCommandBuffer.endRenderPass(GetDispatch());
+				});
 		}
 
+		renderGraph->AddPass("Scene", queueIndicies.graphicsIndex, 
+			[&](RenderPassBuilder& builder)
+			{
+				builder.Write(backbuffer, ResourceUsage::ColorAttachment);
+				if (depthPrepass)
+					builder.Read(depth, ResourceUsage::DepthAttachmentRead);
+				else
+					builder.Write(depth, ResourceUsage::DepthAttachment);
+				builder.Read(drawCommands, ResourceUsage::IndirectRead).Read(drawCount, ResourceUsage::IndirectRead);
+			},
+			[&](vk::CommandBuffer passCommandBuffer)
+			{
+				vk::Extent2D extent = swapchain->GetExtent();
+				vk::Framebuffer framebuffer = framebufferCache->GetFramebuffer(renderPass, { imageViews[imageIndex], renderGraph->GetImageView(depth) }, extent);
+
+				vk::RenderPassBeginInfo renderPassInfo(renderPass, framebuffer, vk::Rect2D(vk::Offset2D(), extent), 2, clearValues);
+
+				passCommandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline, GetDispatch());
+				passCommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, scenePipeline.pipeline, GetDispatch());
+				SetViewport(passCommandBuffer, extent);
+
+				passCommandBuffer.bindVertexBuffers(0, { triangle.vertexBuffer.buffer, sceneInstanceRange.buffer }, { 0, sceneInstanceRange.offset }, GetDispatch());
+				passCommandBuffer.bindIndexBuffer(triangle.indexBuffer.buffer, 0, vk::IndexType::eUint32, GetDispatch());
+
+				uniformAllocator->Bind(passCommandBuffer, vk::PipelineBindPoint::eGraphics, scenePipeline.layout, 0, frameAllocation);
+				PushConstants(passCommandBuffer, scenePipeline, vk::ShaderStageFlagBits::eVertex, drawConstants);
+
+				// One heap bind for the pass, switching textures is only a push constant
+				if (bindlessHeap)
+				{
+					bindlessHeap->Bind(passCommandBuffer, vk::PipelineBindPoint::eGraphics, scenePipeline.layout);
+					PushConstants(passCommandBuffer, scenePipeline, bindlessIndicesRange.stageFlags, textureIndices, bindlessIndicesRange.offset);
+				}
+
+				culler->Draw(passCommandBuffer);
+
+				passCommandBuffer.endRenderPass(GetDispatch());
+			});
+
+		renderGraph->Compile();
+		renderGraph->Execute(commandBuffer, queueIndicies.graphicsIndex);
+
+		commandBuffer.end(GetDispatch());
+
 		vk::SubmitInfo submitInfo = {};
 		submitInfo.setWaitSemaphoreCount(1);
 		submitInfo.setPWaitSemaphores(&imageAvailableSemaphore[currentFrame]);
@@ -496,9 +670,9 @@ int main(int argc, char** argv)
 		submitInfo.setPWaitDstStageMask(&destStateMask);
 
 		submitInfo.setCommandBufferCount(1);
-		submitInfo.setPCommandBuffers(&commandBuffers[imageIndex.value]);
+		submitInfo.setPCommandBuffers(&commandBuffer);
 
-		renderer->GetPresentQueue().submit({ submitInfo }, fences[currentFrame]);
+		renderer->GetGraphicsQueue().submit({ submitInfo }, fences[currentFrame], GetDispatch());
 
 		vk::PresentInfoKHR presentInfo = {};
 		presentInfo.setWaitSemaphoreCount(1);
@@ -506,9 +680,26 @@ int main(int argc, char** argv)
 
 		presentInfo.setSwapchainCount(1);
 		presentInfo.setPSwapchains(&swapchain->GetSwapchainHandle());
-		presentInfo.setPImageIndices(&imageIndex.value);
+		presentInfo.setPImageIndices(&imageIndex);
 
-		renderer->GetPresentQueue().presentKHR(presentInfo);
+		try
+		{
+			if (renderer->GetPresentQueue().presentKHR(presentInfo, GetDispatch()) == vk::Result::eSuboptimalKHR)
+				swapchainDirty = true;
+		}
+		catch (const vk::OutOfDateKHRError&)
+		{
+			swapchainDirty = true;
+		}
+
+		lastFrameHeapAllocations = GetThreadHeapAllocationCount() - frameHeapAllocations;
+		if (lastFrameHeapAllocations > 0)
+			heapAllocatingFrames++;
+		frameCount++;
+
+		// Enough frames for every cache and pool to be warmed up, the last one has to stay off the heap
+		if (allocationTestFrames > 0 && frameCount == allocationTestFrames)
+			running = false;
 
 		currentFrame = (currentFrame + 1) % NUM_FRAMES;
 		SDL_Delay(100);
@@ -516,34 +707,69 @@ int main(int argc, char** argv)
 
 	device.waitIdle();
 
-	device.destroyBuffer(vertexBuffer);
-	device.freeMemory(vertexBufferMemory);
+	const PipelineCacheStats& pipelineStats = pipelineCache->GetStats();
+	printf("Pipelines: %u created in %.3f ms, %u cache hits, %u fallback draws\n", 
+		   pipelineStats.misses, pipelineStats.creationMilliseconds, pipelineStats.hits, pipelineStats.fallbacks);
+	printf("Material: %u variant pipelines from %u shader modules\n", materialShaders->GetPipelineCount(), materialShaders->GetModuleCount());
 
-	for (vk::Framebuffer& framebuffer : framebuffers)
-		device.destroyFramebuffer(framebuffer);
+	textureStreamer->PrintStats();
+
+	printf("Last frame:\n");
+	renderer->GetProfiler()->PrintResults();
+
+	if (hostAllocator)
+		hostAllocator->PrintReport();
+
+	printf("Heap allocations: %llu in the last frame, %u of %u frames allocated\n", 
+		   (unsigned long long)lastFrameHeapAllocations, heapAllocatingFrames, frameCount);
+
+	int32 exitCode = 0;
+	if (allocationTestFrames > 0 && lastFrameHeapAllocations > 0)
+	{
+		printf("Allocation test failed: the steady state frame still allocates from the heap\n");
+		exitCode = 1;
+	}
+
+	// Written while the scene is still alive, so it shows what a session actually needed
+	if (memoryStatsFile)
+	{
+		renderer->GetMemoryBudget()->WriteJson(memoryStatsFile);
+		printf("Memory stats written to %s\n", memoryStatsFile);
+	}
+
+	delete materialShaders;
+
+	delete renderGraph;
+	delete textureStreamer;
+	delete culler;
+
+	if (bindlessHeap)
+	{
+		bindlessHeap->ReleaseTexture(sceneTextureIndices.textureIndex);
+		bindlessHeap->ReleaseSampler(sceneTextureIndices.samplerIndex);
+	}
+	DestroyTexture(renderer, sceneTexture);
+	bufferAllocator->Free(sceneInstanceHandle);
+	DestroyMesh(renderer, triangle);
 
-	device.destroyPipeline(pipeline.pipeline);
-	device.destroyPipelineLayout(pipeline.layout);
-	device.destroyRenderPass(renderPass);
 
-	free(vertexShaderFile.buffer);
 	free(fragmentShaderFile.buffer);
 
-	device.destroyShaderModule(vertexShaderModule);
-	device.destroyShaderModule(fragmentShaderModule);
+	device.destroyShaderModule(vertexShaderModule, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+	device.destroyShaderModule(fragmentShaderModule, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+	device.destroyShaderModule(bindlessShaderModule, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
 
 	for (uint32 index = 0; index < NUM_FRAMES; index++)
 	{
-		device.destroySemaphore(imageAvailableSemaphore[index]);
-		device.destroySemaphore(renderingDoneSemaphore[index]);
-		device.destroyFence(fences[index]);
+		device.destroySemaphore(imageAvailableSemaphore[index], GetAllocationCallbacks(vk::ObjectType::eSemaphore));
+		device.destroySemaphore(renderingDoneSemaphore[index], GetAllocationCallbacks(vk::ObjectType::eSemaphore));
+		device.destroyFence(fences[index], GetAllocationCallbacks(vk::ObjectType::eFence));
 	}
 
-	device.destroyCommandPool(commandPool);
+	device.destroyCommandPool(commandPool, GetAllocationCallbacks(vk::ObjectType::eCommandPool));
 	delete renderer;
 
 	SDL_DestroyWindow(window);
 	SDL_Quit();
-	return 0;
-}
-#endif
\ No newline at end of file
+	return exitCode;
+}
\ No newline at end of file
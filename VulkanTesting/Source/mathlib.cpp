@@ -0,0 +1,328 @@
+#include "mathlib.h"
+
+Matrix4f Matrix4f::Identity()
+{
+	Matrix4f result;
+	result.columns[0] = Vector4f(1.0f, 0.0f, 0.0f, 0.0f);
+	result.columns[1] = Vector4f(0.0f, 1.0f, 0.0f, 0.0f);
+	result.columns[2] = Vector4f(0.0f, 0.0f, 1.0f, 0.0f);
+	result.columns[3] = Vector4f(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return result;
+}
+
+Matrix4f Matrix4f::Translation(const Vector3f& translation)
+{
+	Matrix4f result = Identity();
+	result.columns[3] = Vector4f(translation, 1.0f);
+
+	return result;
+}
+
+Matrix4f Matrix4f::Scale(const Vector3f& scale)
+{
+	Matrix4f result = Identity();
+	result.columns[0].x = scale.x;
+	result.columns[1].y = scale.y;
+	result.columns[2].z = scale.z;
+
+	return result;
+}
+
+Matrix4f Matrix4f::Rotation(const Quaternion& rotation)
+{
+	float xx = rotation.x * rotation.x;
+	float yy = rotation.y * rotation.y;
+	float zz = rotation.z * rotation.z;
+	float xy = rotation.x * rotation.y;
+	float xz = rotation.x * rotation.z;
+	float yz = rotation.y * rotation.z;
+	float wx = rotation.w * rotation.x;
+	float wy = rotation.w * rotation.y;
+	float wz = rotation.w * rotation.z;
+
+	Matrix4f result;
+	result.columns[0] = Vector4f(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f);
+	result.columns[1] = Vector4f(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f);
+	result.columns[2] = Vector4f(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f);
+	result.columns[3] = Vector4f(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return result;
+}
+
+Matrix4f Matrix4f::Perspective(float fovY, float aspect, float nearZ, float farZ)
+{
+	float focalLength = 1.0f / tanf(fovY * 0.5f);
+
+	Matrix4f result;
+	result.columns[0] = Vector4f(focalLength / aspect, 0.0f, 0.0f, 0.0f);
+	result.columns[1] = Vector4f(0.0f, -focalLength, 0.0f, 0.0f);
+	result.columns[2] = Vector4f(0.0f, 0.0f, farZ / (nearZ - farZ), -1.0f);
+	result.columns[3] = Vector4f(0.0f, 0.0f, (nearZ * farZ) / (nearZ - farZ), 0.0f);
+
+	return result;
+}
+
+Matrix4f Matrix4f::Orthographic(float left, float right, float top, float bottom, float nearZ, float farZ)
+{
+	Matrix4f result;
+	result.columns[0] = Vector4f(2.0f / (right - left), 0.0f, 0.0f, 0.0f);
+	result.columns[1] = Vector4f(0.0f, 2.0f / (bottom - top), 0.0f, 0.0f);
+	result.columns[2] = Vector4f(0.0f, 0.0f, -1.0f / (farZ - nearZ), 0.0f);
+	result.columns[3] = Vector4f(-(right + left) / (right - left), -(bottom + top) / (bottom - top), -nearZ / (farZ - nearZ), 1.0f);
+
+	return result;
+}
+
+Matrix4f Matrix4f::LookAt(const Vector3f& eye, const Vector3f& target, const Vector3f& up)
+{
+	Vector3f forward = (target - eye).Normalized();
+	Vector3f side = forward.Cross(up).Normalized();
+	Vector3f newUp = side.Cross(forward);
+
+	Matrix4f result;
+	result.columns[0] = Vector4f(side.x, newUp.x, -forward.x, 0.0f);
+	result.columns[1] = Vector4f(side.y, newUp.y, -forward.y, 0.0f);
+	result.columns[2] = Vector4f(side.z, newUp.z, -forward.z, 0.0f);
+	result.columns[3] = Vector4f(-side.Dot(eye), -newUp.Dot(eye), forward.Dot(eye), 1.0f);
+
+	return result;
+}
+
+Matrix4f Matrix4f::Transposed() const
+{
+	const float* data = Data();
+
+	Matrix4f result;
+	for (uint32 column = 0; column < 4; column++)
+		result.columns[column] = Vector4f(data[column], data[4 + column], data[8 + column], data[12 + column]);
+
+	return result;
+}
+
+Quaternion Quaternion::FromAxisAngle(const Vector3f& axis, float angle)
+{
+	Vector3f normalizedAxis = axis.Normalized();
+	float halfSin = sinf(angle * 0.5f);
+
+	return { normalizedAxis.x * halfSin, normalizedAxis.y * halfSin, normalizedAxis.z * halfSin, cosf(angle * 0.5f) };
+}
+
+Quaternion Quaternion::operator*(const Quaternion& other) const
+{
+	return {
+		w * other.x + x * other.w + y * other.z - z * other.y,
+		w * other.y - x * other.z + y * other.w + z * other.x,
+		w * other.z + x * other.y - y * other.x + z * other.w,
+		w * other.w - x * other.x - y * other.y - z * other.z,
+	};
+}
+
+Quaternion Quaternion::Normalized() const
+{
+	float inverseLength = 1.0f / sqrtf(x * x + y * y + z * z + w * w);
+	return { x * inverseLength, y * inverseLength, z * inverseLength, w * inverseLength };
+}
+
+Vector3f Quaternion::Rotate(const Vector3f& vector) const
+{
+	// v' = v + 2w(q x v) + 2(q x (q x v))
+	Vector3f axis = { x, y, z };
+	Vector3f cross = axis.Cross(vector) * 2.0f;
+
+	return vector + cross * w + axis.Cross(cross);
+}
+
+Quaternion Quaternion::Slerp(const Quaternion& a, const Quaternion& b, float t)
+{
+	Quaternion end = b;
+	float cosAngle = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+
+	// Take the short way around
+	if (cosAngle < 0.0f)
+	{
+		end = { -b.x, -b.y, -b.z, -b.w };
+		cosAngle = -cosAngle;
+	}
+
+	float weightA = 1.0f - t;
+	float weightB = t;
+
+	// Close enough to fall back on a normalized lerp
+	if (cosAngle < 0.9995f)
+	{
+		float angle = acosf(cosAngle);
+		float inverseSin = 1.0f / sinf(angle);
+
+		weightA = sinf((1.0f - t) * angle) * inverseSin;
+		weightB = sinf(t * angle) * inverseSin;
+	}
+
+	Quaternion result = {
+		a.x * weightA + end.x * weightB,
+		a.y * weightA + end.y * weightB,
+		a.z * weightA + end.z * weightB,
+		a.w * weightA + end.w * weightB,
+	};
+
+	return result.Normalized();
+}
+
+// Points are treated as w = 1 and no projective divide is applied
+void TransformPointsSoAScalar(const Matrix4f& matrix, 
+							  const float* inX, const float* inY, const float* inZ, 
+							  float* outX, float* outY, float* outZ, uint32 count)
+{
+	const float* m = matrix.Data();
+
+	for (uint32 index = 0; index < count; index++)
+	{
+		float x = inX[index];
+		float y = inY[index];
+		float z = inZ[index];
+
+		outX[index] = m[0] * x + m[4] * y + m[8] * z + m[12];
+		outY[index] = m[1] * x + m[5] * y + m[9] * z + m[13];
+		outZ[index] = m[2] * x + m[6] * y + m[10] * z + m[14];
+	}
+}
+
+void TransformPointsSoA(const Matrix4f& matrix, 
+						const float* inX, const float* inY, const float* inZ, 
+						float* outX, float* outY, float* outZ, uint32 count)
+{
+	const float* m = matrix.Data();
+	uint32 index = 0;
+
+#if defined(SIMD_AVX2)
+	__m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+	__m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+	__m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+	__m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+
+	for (; index + 8 <= count; index += 8)
+	{
+		__m256 x = _mm256_loadu_ps(inX + index);
+		__m256 y = _mm256_loadu_ps(inY + index);
+		__m256 z = _mm256_loadu_ps(inZ + index);
+
+		__m256 resultX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, x), _mm256_mul_ps(m4, y)), _mm256_add_ps(_mm256_mul_ps(m8, z), m12));
+		__m256 resultY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m1, x), _mm256_mul_ps(m5, y)), _mm256_add_ps(_mm256_mul_ps(m9, z), m13));
+		__m256 resultZ = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m2, x), _mm256_mul_ps(m6, y)), _mm256_add_ps(_mm256_mul_ps(m10, z), m14));
+
+		_mm256_storeu_ps(outX + index, resultX);
+		_mm256_storeu_ps(outY + index, resultY);
+		_mm256_storeu_ps(outZ + index, resultZ);
+	}
+#endif
+
+#if !defined(SIMD_SCALAR)
+	SimdFloat4 m0x4 = SimdSplat(m[0]), m1x4 = SimdSplat(m[1]), m2x4 = SimdSplat(m[2]);
+	SimdFloat4 m4x4 = SimdSplat(m[4]), m5x4 = SimdSplat(m[5]), m6x4 = SimdSplat(m[6]);
+	SimdFloat4 m8x4 = SimdSplat(m[8]), m9x4 = SimdSplat(m[9]), m10x4 = SimdSplat(m[10]);
+	SimdFloat4 m12x4 = SimdSplat(m[12]), m13x4 = SimdSplat(m[13]), m14x4 = SimdSplat(m[14]);
+
+	for (; index + 4 <= count; index += 4)
+	{
+		SimdFloat4 x = SimdLoadUnaligned(inX + index);
+		SimdFloat4 y = SimdLoadUnaligned(inY + index);
+		SimdFloat4 z = SimdLoadUnaligned(inZ + index);
+
+		SimdStoreUnaligned(outX + index, SimdMulAdd(m0x4, x, SimdMulAdd(m4x4, y, SimdMulAdd(m8x4, z, m12x4))));
+		SimdStoreUnaligned(outY + index, SimdMulAdd(m1x4, x, SimdMulAdd(m5x4, y, SimdMulAdd(m9x4, z, m13x4))));
+		SimdStoreUnaligned(outZ + index, SimdMulAdd(m2x4, x, SimdMulAdd(m6x4, y, SimdMulAdd(m10x4, z, m14x4))));
+	}
+#endif
+
+	TransformPointsSoAScalar(matrix, inX + index, inY + index, inZ + index, outX + index, outY + index, outZ + index, count - index);
+}
+
+uint32 CullSpheresSoAScalar(const Vector4f planes[6], 
+							const float* x, const float* y, const float* z, const float* radius, 
+							uint8* visible, uint32 count)
+{
+	uint32 visibleCount = 0;
+
+	for (uint32 index = 0; index < count; index++)
+	{
+		bool inside = true;
+		for (uint32 plane = 0; plane < 6; plane++)
+		{
+			float distance = planes[plane].x * x[index] + planes[plane].y * y[index] + planes[plane].z * z[index] + planes[plane].w;
+			if (distance < -radius[index])
+				inside = false;
+		}
+
+		visible[index] = inside ? 1 : 0;
+		visibleCount += visible[index];
+	}
+
+	return visibleCount;
+}
+
+uint32 CullSpheresSoA(const Vector4f planes[6], 
+					  const float* x, const float* y, const float* z, const float* radius, 
+					  uint8* visible, uint32 count)
+{
+	uint32 visibleCount = 0;
+	uint32 index = 0;
+
+#if defined(SIMD_AVX2)
+	__m256 zero8 = _mm256_setzero_ps();
+
+	for (; index + 8 <= count; index += 8)
+	{
+		__m256 sphereX = _mm256_loadu_ps(x + index);
+		__m256 sphereY = _mm256_loadu_ps(y + index);
+		__m256 sphereZ = _mm256_loadu_ps(z + index);
+		__m256 sphereRadius = _mm256_loadu_ps(radius + index);
+
+		uint32 mask = 0xFF;
+		for (uint32 plane = 0; plane < 6; plane++)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[plane].x), sphereX), _mm256_set1_ps(planes[plane].w));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[plane].y), sphereY));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[plane].z), sphereZ));
+
+			mask &= (uint32)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, sphereRadius), zero8, _CMP_GE_OQ));
+		}
+
+		for (uint32 lane = 0; lane < 8; lane++)
+		{
+			visible[index + lane] = (mask >> lane) & 1;
+			visibleCount += visible[index + lane];
+		}
+	}
+#endif
+
+#if !defined(SIMD_SCALAR)
+	SimdFloat4 zero = SimdSplat(0.0f);
+
+	for (; index + 4 <= count; index += 4)
+	{
+		SimdFloat4 sphereX = SimdLoadUnaligned(x + index);
+		SimdFloat4 sphereY = SimdLoadUnaligned(y + index);
+		SimdFloat4 sphereZ = SimdLoadUnaligned(z + index);
+		SimdFloat4 sphereRadius = SimdLoadUnaligned(radius + index);
+
+		uint32 mask = 0xF;
+		for (uint32 plane = 0; plane < 6; plane++)
+		{
+			SimdFloat4 distance = SimdMulAdd(SimdSplat(planes[plane].x), sphereX, SimdSplat(planes[plane].w));
+			distance = SimdMulAdd(SimdSplat(planes[plane].y), sphereY, distance);
+			distance = SimdMulAdd(SimdSplat(planes[plane].z), sphereZ, distance);
+
+			mask &= SimdGreaterEqualMask(SimdAdd(distance, sphereRadius), zero);
+		}
+
+		for (uint32 lane = 0; lane < 4; lane++)
+		{
+			visible[index + lane] = (mask >> lane) & 1;
+			visibleCount += visible[index + lane];
+		}
+	}
+#endif
+
+	visibleCount += CullSpheresSoAScalar(planes, x + index, y + index, z + index, radius + index, visible + index, count - index);
+	return visibleCount;
+}
\ No newline at end of file
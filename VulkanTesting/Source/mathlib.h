@@ -0,0 +1,160 @@
+#pragma once
+
+#include <math.h>
+
+#include "types.h"
+#include "simd.h"
+
+const float PI = 3.14159265358979f;
+
+inline float ToRadians(float degrees) { return degrees * (PI / 180.0f); }
+
+// Vector2f and Vector3f stay tightly packed so they can be used directly in vertex and
+// storage buffer layouts, Vector4f and Matrix4f are 16 byte aligned and go through SIMD
+
+struct Vector2f
+{
+	float x, y;
+
+	Vector2f operator+(const Vector2f& other) const { return { x + other.x, y + other.y }; }
+	Vector2f operator-(const Vector2f& other) const { return { x - other.x, y - other.y }; }
+	Vector2f operator*(float scalar) const { return { x * scalar, y * scalar }; }
+
+	float Dot(const Vector2f& other) const { return x * other.x + y * other.y; }
+	float Length() const { return sqrtf(Dot(*this)); }
+};
+
+struct Vector3f
+{
+	float x, y, z;
+
+	Vector3f operator+(const Vector3f& other) const { return { x + other.x, y + other.y, z + other.z }; }
+	Vector3f operator-(const Vector3f& other) const { return { x - other.x, y - other.y, z - other.z }; }
+	Vector3f operator*(float scalar) const { return { x * scalar, y * scalar, z * scalar }; }
+	Vector3f operator-() const { return { -x, -y, -z }; }
+
+	float Dot(const Vector3f& other) const { return x * other.x + y * other.y + z * other.z; }
+	Vector3f Cross(const Vector3f& other) const
+	{
+		return { y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x };
+	}
+
+	float Length() const { return sqrtf(Dot(*this)); }
+	Vector3f Normalized() const { return *this * (1.0f / Length()); }
+};
+
+struct alignas(16) Vector4f
+{
+	float x, y, z, w;
+
+	Vector4f() = default;
+	Vector4f(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	Vector4f(const Vector3f& xyz, float w) : x(xyz.x), y(xyz.y), z(xyz.z), w(w) {}
+	Vector4f(SimdFloat4 value) { SimdStore(&x, value); }
+
+	SimdFloat4 Load() const { return SimdLoad(&x); }
+
+	Vector4f operator+(const Vector4f& other) const { return SimdAdd(Load(), other.Load()); }
+	Vector4f operator-(const Vector4f& other) const { return SimdSub(Load(), other.Load()); }
+	Vector4f operator*(const Vector4f& other) const { return SimdMul(Load(), other.Load()); }
+	Vector4f operator*(float scalar) const { return SimdMul(Load(), SimdSplat(scalar)); }
+
+	float Dot(const Vector4f& other) const { return SimdGetX(SimdHorizontalAdd(SimdMul(Load(), other.Load()))); }
+	float Length() const { return sqrtf(Dot(*this)); }
+
+	Vector3f XYZ() const { return { x, y, z }; }
+};
+
+struct Quaternion;
+
+// Column major, columns[N] is column N, which matches GLSL mat4 memory layout
+struct alignas(16) Matrix4f
+{
+	Vector4f columns[4];
+
+	static Matrix4f Identity();
+	static Matrix4f Translation(const Vector3f& translation);
+	static Matrix4f Scale(const Vector3f& scale);
+	static Matrix4f Rotation(const Quaternion& rotation);
+
+	// Right handed, depth range 0 to 1 and Y pointing down in clip space like Vulkan expects
+	static Matrix4f Perspective(float fovY, float aspect, float nearZ, float farZ);
+	static Matrix4f Orthographic(float left, float right, float top, float bottom, float nearZ, float farZ);
+	static Matrix4f LookAt(const Vector3f& eye, const Vector3f& target, const Vector3f& up);
+
+	Matrix4f operator*(const Matrix4f& other) const;
+	Vector4f operator*(const Vector4f& vector) const;
+
+	Matrix4f Transposed() const;
+
+	float* Data() { return &columns[0].x; }
+	const float* Data() const { return &columns[0].x; }
+};
+
+struct Quaternion
+{
+	float x, y, z, w;
+
+	static Quaternion Identity() { return { 0.0f, 0.0f, 0.0f, 1.0f }; }
+	static Quaternion FromAxisAngle(const Vector3f& axis, float angle);
+
+	Quaternion operator*(const Quaternion& other) const;
+
+	Quaternion Normalized() const;
+	Quaternion Conjugate() const { return { -x, -y, -z, w }; }
+	Vector3f Rotate(const Vector3f& vector) const;
+
+	static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+};
+
+inline Matrix4f Matrix4f::operator*(const Matrix4f& other) const
+{
+	Matrix4f result;
+
+	SimdFloat4 column0 = columns[0].Load();
+	SimdFloat4 column1 = columns[1].Load();
+	SimdFloat4 column2 = columns[2].Load();
+	SimdFloat4 column3 = columns[3].Load();
+
+	for (uint32 index = 0; index < 4; index++)
+	{
+		const Vector4f& right = other.columns[index];
+
+		SimdFloat4 value = SimdMul(column0, SimdSplat(right.x));
+		value = SimdMulAdd(column1, SimdSplat(right.y), value);
+		value = SimdMulAdd(column2, SimdSplat(right.z), value);
+		value = SimdMulAdd(column3, SimdSplat(right.w), value);
+
+		result.columns[index] = value;
+	}
+
+	return result;
+}
+
+inline Vector4f Matrix4f::operator*(const Vector4f& vector) const
+{
+	SimdFloat4 value = SimdMul(columns[0].Load(), SimdSplat(vector.x));
+	value = SimdMulAdd(columns[1].Load(), SimdSplat(vector.y), value);
+	value = SimdMulAdd(columns[2].Load(), SimdSplat(vector.z), value);
+	value = SimdMulAdd(columns[3].Load(), SimdSplat(vector.w), value);
+
+	return value;
+}
+
+// Batch functions over structure of arrays data. The pointers don't need any alignment,
+// the SIMD versions pick the widest instruction set compiled in
+
+void TransformPointsSoA(const Matrix4f& matrix, 
+						const float* inX, const float* inY, const float* inZ, 
+						float* outX, float* outY, float* outZ, uint32 count);
+void TransformPointsSoAScalar(const Matrix4f& matrix, 
+							  const float* inX, const float* inY, const float* inZ, 
+							  float* outX, float* outY, float* outZ, uint32 count);
+
+// Writes 1 to visible[N] when sphere N intersects all six planes, returns the visible count
+uint32 CullSpheresSoA(const Vector4f planes[6], 
+					  const float* x, const float* y, const float* z, const float* radius, 
+					  uint8* visible, uint32 count);
+uint32 CullSpheresSoAScalar(const Vector4f planes[6], 
+							const float* x, const float* y, const float* z, const float* radius, 
+							uint8* visible, uint32 count);
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "memorybudget.h"
+
+#include "renderer.h"
+#include "file.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <algorithm>
+
+static const char* CategoryNames[MEMORY_CATEGORY_COUNT] = { "buffers", "images", "staging" };
+
+static void AppendFormat(String& out, const char* format, ...)
+{
+	char line[256];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	out += line;
+}
+
+MemoryBudget::MemoryBudget(Renderer* renderer)
+	: m_Renderer(renderer), m_ExtensionBudget(false), m_NextCallbackId(0), m_Evicting(false)
+{
+	const vk::PhysicalDeviceMemoryProperties& memoryProperties = renderer->GetCapabilities().memoryProperties;
+
+	m_Heaps.resize(memoryProperties.memoryHeapCount);
+	m_DriverUsage.resize(memoryProperties.memoryHeapCount, 0);
+	m_AllocatedAtUpdate.resize(memoryProperties.memoryHeapCount, 0);
+
+	for (uint32 index = 0; index < memoryProperties.memoryHeapCount; index++)
+	{
+		MemoryHeapStats& heap = m_Heaps[index];
+		heap = {};
+		heap.flags = memoryProperties.memoryHeaps[index].flags;
+		heap.size = memoryProperties.memoryHeaps[index].size;
+		heap.budget = (vk::DeviceSize)(heap.size * MEMORY_DEFAULT_BUDGET_FRACTION);
+	}
+
+#ifdef VK_EXT_memory_budget
+	m_ExtensionBudget = renderer->IsDeviceExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+#endif
+
+	QueryBudget();
+}
+
+MemoryBudget::~MemoryBudget()
+{
+	// Whatever is left was leaked by its owner, the device going away takes it along
+	assert(m_Allocations.empty());
+}
+
+void MemoryBudget::QueryBudget()
+{
+#ifdef VK_EXT_memory_budget
+	if (m_ExtensionBudget)
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+		memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memoryProperties.pNext = &budgetProperties;
+
+		vkGetPhysicalDeviceMemoryProperties2(m_Renderer->GetGPUDevice(), &memoryProperties);
+
+		for (uint32 index = 0; index < m_Heaps.size(); index++)
+		{
+			m_Heaps[index].budget = budgetProperties.heapBudget[index];
+			m_DriverUsage[index] = budgetProperties.heapUsage[index];
+			m_AllocatedAtUpdate[index] = m_Heaps[index].allocatedBytes;
+		}
+	}
+#endif
+
+	for (uint32 index = 0; index < m_Heaps.size(); index++)
+		UpdateUsage(index);
+}
+
+void MemoryBudget::UpdateUsage(uint32 heapIndex)
+{
+	MemoryHeapStats& heap = m_Heaps[heapIndex];
+
+	if (!m_ExtensionBudget)
+	{
+		heap.usage = heap.allocatedBytes;
+		return;
+	}
+
+	vk::DeviceSize usage = m_DriverUsage[heapIndex] + heap.allocatedBytes;
+	heap.usage = usage > m_AllocatedAtUpdate[heapIndex] ? usage - m_AllocatedAtUpdate[heapIndex] : 0;
+}
+
+void MemoryBudget::Update()
+{
+	QueryBudget();
+
+	for (uint32 index = 0; index < m_Heaps.size(); index++)
+	{
+		const MemoryHeapStats& heap = m_Heaps[index];
+
+		vk::DeviceSize target = (vk::DeviceSize)(heap.budget * MEMORY_EVICTION_TARGET);
+		if (heap.usage > heap.budget * MEMORY_PRESSURE_THRESHOLD)
+			Evict(index, heap.usage - target);
+	}
+}
+
+void MemoryBudget::Evict(uint32 heapIndex, vk::DeviceSize bytes)
+{
+	// Callbacks that allocate while evicting don't get to start another round
+	if (m_Evicting || m_EvictionCallbacks.empty())
+		return;
+
+	m_Evicting = true;
+	m_Heaps[heapIndex].evictionCount++;
+
+	vk::DeviceSize freed = 0;
+	for (uint32 index = 0; index < m_EvictionCallbacks.size() && freed < bytes; index++)
+		freed += m_EvictionCallbacks[index].callback(heapIndex, bytes - freed);
+
+	m_Evicting = false;
+}
+
+vk::DeviceMemory MemoryBudget::Allocate(const vk::MemoryAllocateInfo& allocInfo, MemoryCategory category)
+{
+	vk::Device device = m_Renderer->GetDevice();
+
+	uint32 heapIndex = m_Renderer->GetCapabilities().memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+	MemoryHeapStats& heap = m_Heaps[heapIndex];
+
+	vk::DeviceSize usage = heap.usage + allocInfo.allocationSize;
+	vk::DeviceSize target = (vk::DeviceSize)(heap.budget * MEMORY_EVICTION_TARGET);
+	if (usage > heap.budget * MEMORY_PRESSURE_THRESHOLD)
+		Evict(heapIndex, usage - target);
+
+	vk::DeviceMemory memory;
+	try
+	{
+		memory = device.allocateMemory(allocInfo, GetAllocationCallbacks(vk::ObjectType::eDeviceMemory));
+	}
+	catch (const vk::OutOfDeviceMemoryError&)
+	{
+		// The budget was off, give back at least as much as we want and try again
+		Evict(heapIndex, allocInfo.allocationSize);
+		memory = device.allocateMemory(allocInfo, GetAllocationCallbacks(vk::ObjectType::eDeviceMemory));
+	}
+
+	Allocation allocation;
+	allocation.heapIndex = heapIndex;
+	allocation.size = allocInfo.allocationSize;
+	allocation.category = category;
+	m_Allocations[(VkDeviceMemory)memory] = allocation;
+
+	heap.allocatedBytes += allocation.size;
+	heap.peakBytes = std::max(heap.peakBytes, heap.allocatedBytes);
+	heap.categoryBytes[(uint32)category] += allocation.size;
+	heap.allocationCount++;
+	UpdateUsage(heapIndex);
+
+	return memory;
+}
+
+void MemoryBudget::Free(vk::DeviceMemory memory)
+{
+	if (!memory)
+		return;
+
+	auto it = m_Allocations.find((VkDeviceMemory)memory);
+	assert(it != m_Allocations.end());
+
+	const Allocation& allocation = it->second;
+	MemoryHeapStats& heap = m_Heaps[allocation.heapIndex];
+
+	heap.allocatedBytes -= allocation.size;
+	heap.categoryBytes[(uint32)allocation.category] -= allocation.size;
+	heap.allocationCount--;
+	UpdateUsage(allocation.heapIndex);
+
+	m_Allocations.erase(it);
+
+	m_Renderer->GetDevice().freeMemory(memory, GetAllocationCallbacks(vk::ObjectType::eDeviceMemory));
+}
+
+uint32 MemoryBudget::AddEvictionCallback(const MemoryEvictionCallback& callback)
+{
+	EvictionCallback entry;
+	entry.id = m_NextCallbackId++;
+	entry.callback = callback;
+	m_EvictionCallbacks.push_back(entry);
+
+	return entry.id;
+}
+
+void MemoryBudget::RemoveEvictionCallback(uint32 id)
+{
+	for (auto it = m_EvictionCallbacks.begin(); it != m_EvictionCallbacks.end(); it++)
+	{
+		if (it->id == id)
+		{
+			m_EvictionCallbacks.erase(it);
+			return;
+		}
+	}
+}
+
+String MemoryBudget::ToJson() const
+{
+	String result;
+	AppendFormat(result, "{\n\t\"source\": \"%s\",\n\t\"heaps\": [\n", m_ExtensionBudget ? "VK_EXT_memory_budget" : "internal");
+
+	for (uint32 index = 0; index < m_Heaps.size(); index++)
+	{
+		const MemoryHeapStats& heap = m_Heaps[index];
+
+		AppendFormat(result, "\t\t{\n");
+		AppendFormat(result, "\t\t\t\"index\": %u,\n", index);
+		AppendFormat(result, "\t\t\t\"deviceLocal\": %s,\n", (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) ? "true" : "false");
+		AppendFormat(result, "\t\t\t\"size\": %llu,\n", (unsigned long long)heap.size);
+		AppendFormat(result, "\t\t\t\"budget\": %llu,\n", (unsigned long long)heap.budget);
+		AppendFormat(result, "\t\t\t\"usage\": %llu,\n", (unsigned long long)heap.usage);
+		AppendFormat(result, "\t\t\t\"allocated\": %llu,\n", (unsigned long long)heap.allocatedBytes);
+		AppendFormat(result, "\t\t\t\"peak\": %llu,\n", (unsigned long long)heap.peakBytes);
+		AppendFormat(result, "\t\t\t\"allocations\": %u,\n", heap.allocationCount);
+		AppendFormat(result, "\t\t\t\"evictions\": %u,\n", heap.evictionCount);
+		AppendFormat(result, "\t\t\t\"categories\": {");
+
+		for (uint32 category = 0; category < MEMORY_CATEGORY_COUNT; category++)
+		{
+			AppendFormat(result, "%s \"%s\": %llu", category > 0 ? "," : "", CategoryNames[category], 
+						 (unsigned long long)heap.categoryBytes[category]);
+		}
+
+		AppendFormat(result, " }\n\t\t}%s\n", index + 1 < m_Heaps.size() ? "," : "");
+	}
+
+	AppendFormat(result, "\t]\n}\n");
+	return result;
+}
+
+void MemoryBudget::WriteJson(const String& filename) const
+{
+	String json = ToJson();
+	WriteBufferToFile(filename, json.data(), json.size());
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <functional>
+#include <unordered_map>
+
+#include "types.h"
+
+class Renderer;
+
+enum class MemoryCategory
+{
+	Buffer,
+	Image,
+	Staging,
+	Count
+};
+
+const uint32 MEMORY_CATEGORY_COUNT = (uint32)MemoryCategory::Count;
+
+// Eviction kicks in once a heap goes over the first fraction of its budget, and asks for enough
+// memory back to get under the second
+const float MEMORY_PRESSURE_THRESHOLD = 0.9f;
+const float MEMORY_EVICTION_TARGET = 0.8f;
+
+// Without VK_EXT_memory_budget nobody tells us what other processes use, leave them some room
+const float MEMORY_DEFAULT_BUDGET_FRACTION = 0.8f;
+
+struct MemoryHeapStats
+{
+	vk::MemoryHeapFlags flags;
+	vk::DeviceSize size;
+	vk::DeviceSize budget;
+
+	// Everything on the heap according to the driver, or only our own allocations without the extension
+	vk::DeviceSize usage;
+
+	// Our own allocations
+	vk::DeviceSize allocatedBytes;
+	vk::DeviceSize peakBytes;
+	vk::DeviceSize categoryBytes[MEMORY_CATEGORY_COUNT];
+	uint32 allocationCount;
+	uint32 evictionCount;
+};
+
+// Asked to free at least the given number of bytes on the heap, returns how much it freed. Only
+// memory the frames in flight no longer use may go, anything else has to be deferred
+typedef std::function<vk::DeviceSize(uint32 heapIndex, vk::DeviceSize bytes)> MemoryEvictionCallback;
+
+// Every device memory allocation goes through here so usage is known per heap and per category.
+// The budget comes from VK_EXT_memory_budget when the device has it, otherwise it's a fixed part
+// of the heap size. Owners of memory that can be thrown away (streaming pools, caches) register an
+// eviction callback and get asked to give memory back when a heap gets close to its budget. Render
+// thread only
+class MemoryBudget
+{
+private:
+	struct Allocation
+	{
+		uint32 heapIndex;
+		vk::DeviceSize size;
+		MemoryCategory category;
+	};
+
+	struct EvictionCallback
+	{
+		uint32 id;
+		MemoryEvictionCallback callback;
+	};
+
+	Renderer* m_Renderer;
+	bool m_ExtensionBudget;
+
+	std::vector<MemoryHeapStats> m_Heaps;
+
+	// The driver's numbers are only read in Update, our allocations since then are added on top
+	std::vector<vk::DeviceSize> m_DriverUsage;
+	std::vector<vk::DeviceSize> m_AllocatedAtUpdate;
+
+	std::unordered_map<VkDeviceMemory, Allocation> m_Allocations;
+
+	std::vector<EvictionCallback> m_EvictionCallbacks;
+	uint32 m_NextCallbackId;
+	bool m_Evicting;
+private:
+	void QueryBudget();
+	void UpdateUsage(uint32 heapIndex);
+	void Evict(uint32 heapIndex, vk::DeviceSize bytes);
+public:
+	MemoryBudget(Renderer* renderer);
+	~MemoryBudget();
+
+	// Reads the driver's budget and evicts from heaps under pressure, once per frame
+	void Update();
+
+	// Evicts first when the allocation would put the heap under pressure, and tries once more
+	// after evicting when the driver is out of memory
+	vk::DeviceMemory Allocate(const vk::MemoryAllocateInfo& allocInfo, MemoryCategory category);
+	void Free(vk::DeviceMemory memory);
+
+	uint32 AddEvictionCallback(const MemoryEvictionCallback& callback);
+	void RemoveEvictionCallback(uint32 id);
+
+	bool IsExtensionBudget() const { return m_ExtensionBudget; }
+	uint32 GetHeapCount() const { return (uint32)m_Heaps.size(); }
+	const MemoryHeapStats& GetHeapStats(uint32 heapIndex) const { return m_Heaps[heapIndex]; }
+
+	// For sizing streaming pools from real sessions
+	String ToJson() const;
+	void WriteJson(const String& filename) const;
+};
\ No newline at end of file
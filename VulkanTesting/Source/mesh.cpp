@@ -0,0 +1,64 @@
+#include "mesh.h"
+
+#include "renderer.h"
+
+VertexLayout Vertex::GetLayout()
+{
+	VertexLayout result;
+
+	result.bindings.push_back(vk::VertexInputBindingDescription(0, sizeof(Vertex), vk::VertexInputRate::eVertex));
+
+	result.attributes.push_back(vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, pos)));
+	result.attributes.push_back(vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color)));
+
+	return result;
+}
+
+VertexLayout InstanceData::GetInstancedLayout()
+{
+	VertexLayout result = Vertex::GetLayout();
+
+	result.bindings.push_back(vk::VertexInputBindingDescription(1, sizeof(InstanceData), vk::VertexInputRate::eInstance));
+
+	for (uint32 column = 0; column < 4; column++)
+	{
+		uint32 offset = offsetof(InstanceData, transform) + column * sizeof(Vector4f);
+		result.attributes.push_back(vk::VertexInputAttributeDescription(2 + column, 1, vk::Format::eR32G32B32A32Sfloat, offset));
+	}
+
+	result.attributes.push_back(vk::VertexInputAttributeDescription(6, 1, vk::Format::eR32G32B32Sfloat, offsetof(InstanceData, color)));
+
+	return result;
+}
+
+Mesh CreateMesh(Renderer* renderer, const Vertex* vertices, uint32 vertexCount, const uint32* indices, uint32 indexCount)
+{
+	Mesh result = {};
+	result.vertexCount = vertexCount;
+	result.vertexBuffer = CreateBuffer(renderer, sizeof(Vertex) * vertexCount, 
+									   vk::BufferUsageFlagBits::eVertexBuffer, 
+									   vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	memcpy(result.vertexBuffer.mapped, vertices, sizeof(Vertex) * vertexCount);
+
+	if (indices)
+	{
+		result.indexCount = indexCount;
+		result.indexBuffer = CreateBuffer(renderer, sizeof(uint32) * indexCount, 
+										  vk::BufferUsageFlagBits::eIndexBuffer, 
+										  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+		memcpy(result.indexBuffer.mapped, indices, sizeof(uint32) * indexCount);
+	}
+
+	return result;
+}
+
+void DestroyMesh(Renderer* renderer, Mesh& mesh)
+{
+	DestroyBuffer(renderer, mesh.vertexBuffer);
+
+	if (mesh.indexBuffer.buffer)
+		DestroyBuffer(renderer, mesh.indexBuffer);
+	mesh = {};
+}
\ No newline at end of file
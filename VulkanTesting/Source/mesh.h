@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "buffer.h"
+#include "mathlib.h"
+
+struct VertexLayout
+{
+	std::vector<vk::VertexInputBindingDescription> bindings;
+	std::vector<vk::VertexInputAttributeDescription> attributes;
+};
+
+struct Vertex
+{
+	Vector2f pos;
+	Vector3f color;
+
+	static VertexLayout GetLayout();
+};
+
+// Per-instance data, fed through binding 1 with VertexInputRate::eInstance
+struct InstanceData
+{
+	// One column per attribute, takes up locations 2 to 5
+	Matrix4f transform;
+	Vector3f color;
+
+	// Layout with Vertex at binding 0 and InstanceData at binding 1
+	static VertexLayout GetInstancedLayout();
+};
+
+struct Mesh
+{
+	Buffer vertexBuffer;
+	uint32 vertexCount;
+
+	// Optional, needed for the indexed and indirect draw paths
+	Buffer indexBuffer;
+	uint32 indexCount;
+};
+
+Mesh CreateMesh(Renderer* renderer, const Vertex* vertices, uint32 vertexCount, const uint32* indices = nullptr, uint32 indexCount = 0);
+void DestroyMesh(Renderer* renderer, Mesh& mesh);
\ No newline at end of file
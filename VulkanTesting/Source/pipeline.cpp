@@ -0,0 +1,240 @@
+#include "pipeline.h"
+
+#include "hash.h"
+#include "dispatch.h"
+#include "hostallocator.h"
+
+bool GraphicsPipelineDesc::operator==(const GraphicsPipelineDesc& other) const
+{
+	return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader && 
+		   vertexLayout.bindings == other.vertexLayout.bindings && vertexLayout.attributes == other.vertexLayout.attributes && 
+		   topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace && 
+		   blendEnable == other.blendEnable && 
+		   srcColorBlendFactor == other.srcColorBlendFactor && dstColorBlendFactor == other.dstColorBlendFactor && colorBlendOp == other.colorBlendOp && 
+		   srcAlphaBlendFactor == other.srcAlphaBlendFactor && dstAlphaBlendFactor == other.dstAlphaBlendFactor && alphaBlendOp == other.alphaBlendOp && 
+		   colorAttachmentCount == other.colorAttachmentCount && 
+		   depthTestEnable == other.depthTestEnable && depthWriteEnable == other.depthWriteEnable && depthCompareOp == other.depthCompareOp && 
+		   renderPass == other.renderPass && subpass == other.subpass && specializationConstants == other.specializationConstants && 
+		   specializationConstantMask == other.specializationConstantMask && 
+		   setLayouts == other.setLayouts && pushConstantRanges == other.pushConstantRanges;
+}
+
+uint64 GraphicsPipelineDesc::Hash() const
+{
+	uint64 hash = HASH_SEED;
+	hash = HashValue((VkShaderModule)vertexShader, hash);
+	hash = HashValue((VkShaderModule)fragmentShader, hash);
+
+	for (const vk::VertexInputBindingDescription& binding : vertexLayout.bindings)
+	{
+		hash = HashValue(binding.binding, hash);
+		hash = HashValue(binding.stride, hash);
+		hash = HashValue((uint32)binding.inputRate, hash);
+	}
+
+	for (const vk::VertexInputAttributeDescription& attribute : vertexLayout.attributes)
+	{
+		hash = HashValue(attribute.location, hash);
+		hash = HashValue(attribute.binding, hash);
+		hash = HashValue((uint32)attribute.format, hash);
+		hash = HashValue(attribute.offset, hash);
+	}
+
+	hash = HashValue((uint32)topology, hash);
+	hash = HashValue((uint32)polygonMode, hash);
+	hash = HashValue((uint32)cullMode, hash);
+	hash = HashValue((uint32)frontFace, hash);
+
+	hash = HashValue(blendEnable, hash);
+	hash = HashValue((uint32)srcColorBlendFactor, hash);
+	hash = HashValue((uint32)dstColorBlendFactor, hash);
+	hash = HashValue((uint32)colorBlendOp, hash);
+	hash = HashValue((uint32)srcAlphaBlendFactor, hash);
+	hash = HashValue((uint32)dstAlphaBlendFactor, hash);
+	hash = HashValue((uint32)alphaBlendOp, hash);
+	hash = HashValue(colorAttachmentCount, hash);
+
+	hash = HashValue(depthTestEnable, hash);
+	hash = HashValue(depthWriteEnable, hash);
+	hash = HashValue((uint32)depthCompareOp, hash);
+
+	hash = HashValue((VkRenderPass)renderPass, hash);
+	hash = HashValue(subpass, hash);
+
+	hash = HashValue(specializationConstantMask, hash);
+	for (uint32 constant : specializationConstants)
+		hash = HashValue(constant, hash);
+
+	for (vk::DescriptorSetLayout setLayout : setLayouts)
+		hash = HashValue((VkDescriptorSetLayout)setLayout, hash);
+
+	for (const vk::PushConstantRange& range : pushConstantRanges)
+	{
+		hash = HashValue((uint32)range.stageFlags, hash);
+		hash = HashValue(range.offset, hash);
+		hash = HashValue(range.size, hash);
+	}
+
+	return hash;
+}
+
+vk::PipelineLayout CreatePipelineLayout(vk::Device device, const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+{
+	vk::PipelineLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.setSetLayoutCount((uint32)setLayouts.size());
+	layoutCreateInfo.setPSetLayouts(setLayouts.data());
+	layoutCreateInfo.setPushConstantRangeCount((uint32)pushConstantRanges.size());
+	layoutCreateInfo.setPPushConstantRanges(pushConstantRanges.data());
+
+	return device.createPipelineLayout(layoutCreateInfo, GetAllocationCallbacks(vk::ObjectType::ePipelineLayout));
+}
+
+vk::Pipeline CreateGraphicsPipeline(vk::Device device, const GraphicsPipelineDesc& desc, vk::PipelineLayout layout, vk::PipelineCache pipelineCache)
+{
+	std::vector<vk::SpecializationMapEntry> specializationEntries;
+	for (uint32 index = 0; index < desc.specializationConstants.size(); index++)
+	{
+		if (desc.specializationConstantMask & (1 << index))
+			specializationEntries.push_back(vk::SpecializationMapEntry(index, index * sizeof(uint32), sizeof(uint32)));
+	}
+
+	vk::SpecializationInfo specializationInfo((uint32)specializationEntries.size(), specializationEntries.data(), 
+											  desc.specializationConstants.size() * sizeof(uint32), desc.specializationConstants.data());
+	const vk::SpecializationInfo* specialization = specializationEntries.empty() ? nullptr : &specializationInfo;
+
+	vk::PipelineShaderStageCreateInfo vertexShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
+															vk::ShaderStageFlagBits::eVertex,
+															desc.vertexShader,
+															"main",
+															specialization);
+
+	vk::PipelineShaderStageCreateInfo fragmentShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
+															  vk::ShaderStageFlagBits::eFragment,
+															  desc.fragmentShader,
+															  "main",
+															  specialization);
+	vk::PipelineShaderStageCreateInfo  shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
+	uint32 shaderStageCount = desc.fragmentShader ? 2 : 1;
+
+	vk::PipelineVertexInputStateCreateInfo vertexInputStateInfo = {};
+	vertexInputStateInfo.setVertexBindingDescriptionCount((uint32)desc.vertexLayout.bindings.size());
+	vertexInputStateInfo.setPVertexBindingDescriptions(desc.vertexLayout.bindings.data());
+
+	vertexInputStateInfo.setVertexAttributeDescriptionCount((uint32)desc.vertexLayout.attributes.size());
+	vertexInputStateInfo.setPVertexAttributeDescriptions(desc.vertexLayout.attributes.data());
+
+	vk::PipelineInputAssemblyStateCreateInfo assemblyInputStateInfo(vk::PipelineInputAssemblyStateCreateFlags(), desc.topology, false);
+
+	// Viewport and scissor are dynamic so pipelines survive a swapchain resize
+	vk::PipelineViewportStateCreateInfo viewportStateInfo(vk::PipelineViewportStateCreateFlags(), 1, nullptr, 1, nullptr);
+
+	vk::PipelineRasterizationStateCreateInfo rasterizationStateInfo = {};
+	rasterizationStateInfo.setDepthClampEnable(false);
+
+	rasterizationStateInfo.setRasterizerDiscardEnable(false);
+	rasterizationStateInfo.setPolygonMode(desc.polygonMode);
+	rasterizationStateInfo.setLineWidth(1.0f);
+	rasterizationStateInfo.setCullMode(desc.cullMode);
+	rasterizationStateInfo.setFrontFace(desc.frontFace);
+	rasterizationStateInfo.setDepthBiasEnable(false);
+
+	vk::PipelineMultisampleStateCreateInfo multisampleStateInfo = {};
+	multisampleStateInfo.setSampleShadingEnable(false);
+	multisampleStateInfo.setRasterizationSamples(vk::SampleCountFlagBits::e1);
+	multisampleStateInfo.setMinSampleShading(1.0f);
+
+	vk::PipelineDepthStencilStateCreateInfo depthStencilStateInfo = {};
+	depthStencilStateInfo.setDepthTestEnable(desc.depthTestEnable);
+	depthStencilStateInfo.setDepthWriteEnable(desc.depthWriteEnable);
+	depthStencilStateInfo.setDepthCompareOp(desc.depthCompareOp);
+	depthStencilStateInfo.setDepthBoundsTestEnable(false);
+	depthStencilStateInfo.setStencilTestEnable(false);
+
+	vk::PipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
+	colorBlendAttachment.setBlendEnable(desc.blendEnable);
+	
+	colorBlendAttachment.setSrcColorBlendFactor(desc.srcColorBlendFactor);
+	colorBlendAttachment.setDstColorBlendFactor(desc.dstColorBlendFactor);
+	colorBlendAttachment.setColorBlendOp(desc.colorBlendOp);
+
+	colorBlendAttachment.setSrcAlphaBlendFactor(desc.srcAlphaBlendFactor);
+	colorBlendAttachment.setDstAlphaBlendFactor(desc.dstAlphaBlendFactor);
+	colorBlendAttachment.setAlphaBlendOp(desc.alphaBlendOp);
+
+	std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments(desc.colorAttachmentCount, colorBlendAttachment);
+	
+	vk::PipelineColorBlendStateCreateInfo colorBlendingStateInfo = {};
+	colorBlendingStateInfo.setLogicOpEnable(VK_FALSE);
+	colorBlendingStateInfo.setLogicOp(vk::LogicOp::eCopy);
+	colorBlendingStateInfo.setAttachmentCount((uint32)colorBlendAttachments.size());
+	colorBlendingStateInfo.setPAttachments(colorBlendAttachments.data());
+
+	colorBlendingStateInfo.setBlendConstants(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 0.0f });
+	
+	vk::DynamicState dynamicStates[] = {
+		vk::DynamicState::eViewport,
+		vk::DynamicState::eScissor
+	};
+
+	vk::PipelineDynamicStateCreateInfo dynamicStateInfo(vk::PipelineDynamicStateCreateFlags(), 2, dynamicStates);
+	
+	vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo = {};
+	graphicsPipelineCreateInfo.setStageCount(shaderStageCount);
+	graphicsPipelineCreateInfo.setPStages(shaderStages);
+	
+	graphicsPipelineCreateInfo.setPVertexInputState(&vertexInputStateInfo);
+	graphicsPipelineCreateInfo.setPInputAssemblyState(&assemblyInputStateInfo);
+	graphicsPipelineCreateInfo.setPViewportState(&viewportStateInfo);
+	graphicsPipelineCreateInfo.setPRasterizationState(&rasterizationStateInfo);
+	graphicsPipelineCreateInfo.setPMultisampleState(&multisampleStateInfo);
+	graphicsPipelineCreateInfo.setPDepthStencilState(&depthStencilStateInfo);
+	graphicsPipelineCreateInfo.setPColorBlendState(&colorBlendingStateInfo);
+	graphicsPipelineCreateInfo.setPDynamicState(&dynamicStateInfo);
+
+	graphicsPipelineCreateInfo.setLayout(layout);
+	graphicsPipelineCreateInfo.setRenderPass(desc.renderPass);
+	graphicsPipelineCreateInfo.setSubpass(desc.subpass);
+
+	graphicsPipelineCreateInfo.setBasePipelineHandle(nullptr);
+	graphicsPipelineCreateInfo.setBasePipelineIndex(-1);
+
+	vk::Pipeline pipeline = device.createGraphicsPipeline(pipelineCache, graphicsPipelineCreateInfo, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+
+	return pipeline;
+}
+
+Pipeline CreateComputePipeline(vk::Device device, vk::ShaderModule computeShader, const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+{
+	vk::PipelineShaderStageCreateInfo computeShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
+															 vk::ShaderStageFlagBits::eCompute,
+															 computeShader,
+															 "main",
+															 nullptr);
+
+	vk::PipelineLayout layout = CreatePipelineLayout(device, setLayouts, pushConstantRanges);
+
+	vk::ComputePipelineCreateInfo computePipelineCreateInfo = {};
+	computePipelineCreateInfo.setStage(computeShaderStageInfo);
+	computePipelineCreateInfo.setLayout(layout);
+
+	computePipelineCreateInfo.setBasePipelineHandle(nullptr);
+	computePipelineCreateInfo.setBasePipelineIndex(-1);
+
+	vk::Pipeline pipeline = device.createComputePipeline(nullptr, computePipelineCreateInfo, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+
+	Pipeline result = {};
+	result.pipeline = pipeline;
+	result.layout = layout;
+
+	return result;
+}
+
+void SetViewport(vk::CommandBuffer commandBuffer, vk::Extent2D extent)
+{
+	vk::Viewport viewport(0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f);
+	vk::Rect2D scissor({ 0, 0 }, extent);
+
+	commandBuffer.setViewport(0, { viewport }, GetDispatch());
+	commandBuffer.setScissor(0, { scissor }, GetDispatch());
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "mesh.h"
+
+struct Pipeline
+{
+	vk::Pipeline pipeline;
+	vk::PipelineLayout layout;
+};
+
+// Everything that goes into a graphics pipeline, viewport and scissor are always dynamic
+struct GraphicsPipelineDesc
+{
+	vk::ShaderModule vertexShader;
+
+	// Left null for depth only pipelines, together with a colorAttachmentCount of 0
+	vk::ShaderModule fragmentShader;
+	VertexLayout vertexLayout;
+
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+	vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+	vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+	vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+
+	// Applied to every color attachment
+	bool blendEnable = false;
+	vk::BlendFactor srcColorBlendFactor = vk::BlendFactor::eOne;
+	vk::BlendFactor dstColorBlendFactor = vk::BlendFactor::eZero;
+	vk::BlendOp colorBlendOp = vk::BlendOp::eAdd;
+	vk::BlendFactor srcAlphaBlendFactor = vk::BlendFactor::eOne;
+	vk::BlendFactor dstAlphaBlendFactor = vk::BlendFactor::eZero;
+	vk::BlendOp alphaBlendOp = vk::BlendOp::eAdd;
+	uint32 colorAttachmentCount = 1;
+
+	bool depthTestEnable = false;
+	bool depthWriteEnable = false;
+	vk::CompareOp depthCompareOp = vk::CompareOp::eLess;
+
+	vk::RenderPass renderPass;
+	uint32 subpass = 0;
+
+	// Value of specialization constant N in both stages, 32 bits each, only for the ids whose bit is
+	// set in the mask. Ids a shader doesn't declare are ignored, unset ones keep the default from the shader
+	std::vector<uint32> specializationConstants;
+	uint32 specializationConstantMask = 0;
+
+	std::vector<vk::DescriptorSetLayout> setLayouts;
+	std::vector<vk::PushConstantRange> pushConstantRanges;
+
+	bool operator==(const GraphicsPipelineDesc& other) const;
+
+	// Hashes each field on its own so padding never ends up in the key
+	uint64 Hash() const;
+};
+
+struct GraphicsPipelineDescHasher
+{
+	size_t operator()(const GraphicsPipelineDesc& desc) const { return (size_t)desc.Hash(); }
+};
+
+vk::PipelineLayout CreatePipelineLayout(vk::Device device, const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges);
+
+// Builds a fresh pipeline every call, go through the PipelineStateCache to share identical ones
+vk::Pipeline CreateGraphicsPipeline(vk::Device device, const GraphicsPipelineDesc& desc, vk::PipelineLayout layout, vk::PipelineCache pipelineCache = nullptr);
+Pipeline CreateComputePipeline(vk::Device device, vk::ShaderModule computeShader, const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges);
+
+// Graphics pipelines use dynamic viewport and scissor, this covers the whole extent with both
+void SetViewport(vk::CommandBuffer commandBuffer, vk::Extent2D extent);
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "pipelinecache.h"
+
+#include "hash.h"
+#include "hostallocator.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <stdio.h>
+
+bool PipelineLayoutKey::operator==(const PipelineLayoutKey& other) const
+{
+	return setLayouts == other.setLayouts && pushConstantRanges == other.pushConstantRanges;
+}
+
+uint64 PipelineLayoutKey::Hash() const
+{
+	uint64 hash = HASH_SEED;
+	for (vk::DescriptorSetLayout setLayout : setLayouts)
+		hash = HashValue((VkDescriptorSetLayout)setLayout, hash);
+
+	for (const vk::PushConstantRange& range : pushConstantRanges)
+	{
+		hash = HashValue((uint32)range.stageFlags, hash);
+		hash = HashValue(range.offset, hash);
+		hash = HashValue(range.size, hash);
+	}
+
+	return hash;
+}
+
+PipelineStateCache::PipelineStateCache(vk::Device device, JobSystem* jobSystem)
+	: m_Device(device), m_JobSystem(jobSystem), m_Stats()
+{
+	m_DriverCache = m_Device.createPipelineCache(vk::PipelineCacheCreateInfo(), GetAllocationCallbacks(vk::ObjectType::ePipelineCache));
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+	for (auto& entry : m_PendingPipelines)
+	{
+		m_JobSystem->Wait(&entry.second->counter);
+		m_Device.destroyPipeline(entry.second->pipeline.pipeline, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+	}
+
+	for (auto& entry : m_Pipelines)
+		m_Device.destroyPipeline(entry.second.pipeline, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+
+	for (auto& entry : m_Layouts)
+		m_Device.destroyPipelineLayout(entry.second, GetAllocationCallbacks(vk::ObjectType::ePipelineLayout));
+
+	m_Device.destroyPipelineCache(m_DriverCache, GetAllocationCallbacks(vk::ObjectType::ePipelineCache));
+}
+
+bool PipelineStateCache::TryFinishPending(const GraphicsPipelineDesc& desc, bool wait)
+{
+	auto it = m_PendingPipelines.find(desc);
+	if (it == m_PendingPipelines.end())
+		return false;
+
+	PendingPipeline* pending = it->second.get();
+	if (wait)
+		m_JobSystem->Wait(&pending->counter);
+	else if (!pending->counter.IsDone())
+		return false;
+
+	// Failed compiles stay pending so they aren't retried every frame, the destructor cleans them up
+	if (pending->failed)
+		return false;
+
+	m_Stats.creationMilliseconds += pending->creationMilliseconds;
+	m_Pipelines[desc] = pending->pipeline;
+	m_PendingPipelines.erase(it);
+
+	return true;
+}
+
+Pipeline PipelineStateCache::GetGraphicsPipeline(const GraphicsPipelineDesc& desc)
+{
+	auto it = m_Pipelines.find(desc);
+	if (it != m_Pipelines.end())
+	{
+		m_Stats.hits++;
+		return it->second;
+	}
+
+	// Already compiling in the background, finishing that is cheaper than starting over
+	if (TryFinishPending(desc, true))
+		return m_Pipelines[desc];
+
+	if (m_PendingPipelines.find(desc) != m_PendingPipelines.end())
+		throw std::runtime_error("failed to create graphics pipeline!");
+
+	Pipeline pipeline = {};
+	pipeline.layout = GetPipelineLayout(desc.setLayouts, desc.pushConstantRanges);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	pipeline.pipeline = CreateGraphicsPipeline(m_Device, desc, pipeline.layout, m_DriverCache);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	m_Stats.misses++;
+	m_Stats.creationMilliseconds += elapsed.count();
+
+	m_Pipelines[desc] = pipeline;
+	return pipeline;
+}
+
+Pipeline PipelineStateCache::GetGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, const Pipeline& fallback)
+{
+	auto it = m_Pipelines.find(desc);
+	if (it != m_Pipelines.end())
+	{
+		m_Stats.hits++;
+		return it->second;
+	}
+
+	if (TryFinishPending(desc, false))
+		return m_Pipelines[desc];
+
+	if (m_PendingPipelines.find(desc) == m_PendingPipelines.end())
+	{
+		PendingPipeline* pending = new PendingPipeline();
+		pending->pipeline.layout = GetPipelineLayout(desc.setLayouts, desc.pushConstantRanges);
+		pending->creationMilliseconds = 0.0;
+		pending->failed = false;
+
+		m_PendingPipelines[desc] = std::unique_ptr<PendingPipeline>(pending);
+		m_Stats.misses++;
+
+		// The pipeline cache is internally synchronized, the job only touches its own entry
+		vk::Device device = m_Device;
+		vk::PipelineCache driverCache = m_DriverCache;
+		m_JobSystem->Submit([pending, desc, device, driverCache]()
+		{
+			// Nothing catches on the workers, an escaping exception would take the process down
+			try
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				pending->pipeline.pipeline = CreateGraphicsPipeline(device, desc, pending->pipeline.layout, driverCache);
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+				pending->creationMilliseconds = elapsed.count();
+			}
+			catch (const std::exception& error)
+			{
+				printf("Failed to create graphics pipeline: %s\n", error.what());
+				pending->failed = true;
+			}
+		}, &pending->counter);
+	}
+
+	m_Stats.fallbacks++;
+	return fallback;
+}
+
+bool PipelineStateCache::IsPipelineReady(const GraphicsPipelineDesc& desc)
+{
+	TryFinishPending(desc, false);
+	return m_Pipelines.find(desc) != m_Pipelines.end();
+}
+
+vk::PipelineLayout PipelineStateCache::GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+{
+	PipelineLayoutKey key;
+	key.setLayouts = setLayouts;
+	key.pushConstantRanges = pushConstantRanges;
+
+	auto it = m_Layouts.find(key);
+	if (it != m_Layouts.end())
+		return it->second;
+
+	vk::PipelineLayout layout = CreatePipelineLayout(m_Device, setLayouts, pushConstantRanges);
+
+	m_Layouts[key] = layout;
+	return layout;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <unordered_map>
+
+#include "types.h"
+#include "pipeline.h"
+#include "jobsystem.h"
+
+struct PipelineLayoutKey
+{
+	std::vector<vk::DescriptorSetLayout> setLayouts;
+	std::vector<vk::PushConstantRange> pushConstantRanges;
+
+	bool operator==(const PipelineLayoutKey& other) const;
+	uint64 Hash() const;
+};
+
+struct PipelineLayoutKeyHasher
+{
+	size_t operator()(const PipelineLayoutKey& key) const { return (size_t)key.Hash(); }
+};
+
+struct PipelineCacheStats
+{
+	uint32 hits;
+	uint32 misses;
+
+	// Time spent inside vkCreateGraphicsPipelines for the misses, on any thread
+	double creationMilliseconds;
+
+	// Draws that got the fallback (or nothing) because their pipeline was still compiling
+	uint32 fallbacks;
+};
+
+// Owns graphics pipelines and their layouts, a description identical to an earlier one returns the
+// same pipeline. Misses go through a shared VkPipelineCache so the driver can reuse compiled state.
+// Only meant to be used from the render thread, the compiles themselves can run on the job system
+class PipelineStateCache
+{
+private:
+	struct PendingPipeline
+	{
+		Pipeline pipeline;
+		double creationMilliseconds;
+		bool failed;
+		JobCounter counter;
+	};
+
+	vk::Device m_Device;
+	vk::PipelineCache m_DriverCache;
+	JobSystem* m_JobSystem;
+
+	std::unordered_map<GraphicsPipelineDesc, Pipeline, GraphicsPipelineDescHasher> m_Pipelines;
+	std::unordered_map<GraphicsPipelineDesc, std::unique_ptr<PendingPipeline>, GraphicsPipelineDescHasher> m_PendingPipelines;
+	std::unordered_map<PipelineLayoutKey, vk::PipelineLayout, PipelineLayoutKeyHasher> m_Layouts;
+
+	PipelineCacheStats m_Stats;
+private:
+	bool TryFinishPending(const GraphicsPipelineDesc& desc, bool wait);
+public:
+	PipelineStateCache(vk::Device device, JobSystem* jobSystem);
+	~PipelineStateCache();
+
+	// Compiles on the calling thread if the pipeline doesn't exist yet
+	Pipeline GetGraphicsPipeline(const GraphicsPipelineDesc& desc);
+
+	// Never blocks: kicks off a background compile the first time and hands out the fallback until
+	// it is done, after which the real pipeline is returned. A null fallback means skip the draw, and
+	// a compile that failed keeps getting the fallback.
+	// The shader modules and render pass in the description have to outlive the compile
+	Pipeline GetGraphicsPipelineAsync(const GraphicsPipelineDesc& desc, const Pipeline& fallback = Pipeline());
+	bool IsPipelineReady(const GraphicsPipelineDesc& desc);
+	vk::PipelineLayout GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges);
+
+	vk::PipelineCache GetDriverCache() const { return m_DriverCache; }
+
+	const PipelineCacheStats& GetStats() const { return m_Stats; }
+	uint32 GetPipelineCount() const { return (uint32)m_Pipelines.size(); }
+};
\ No newline at end of file
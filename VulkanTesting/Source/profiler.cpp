@@ -0,0 +1,165 @@
+#include "profiler.h"
+
+#include "renderer.h"
+
+#include <stdio.h>
+
+Profiler::Profiler(Renderer* renderer, uint32 frameCount)
+	: m_Renderer(renderer), m_Frames(frameCount), m_FrameIndex(0)
+{
+	const vk::PhysicalDeviceLimits& limits = renderer->GetCapabilities().properties.limits;
+
+	m_TimestampsSupported = limits.timestampComputeAndGraphics == VK_TRUE;
+	m_TimestampPeriod = limits.timestampPeriod;
+
+	for (Frame& frame : m_Frames)
+	{
+		frame.queryCount = 0;
+		frame.reset = false;
+
+		if (m_TimestampsSupported)
+		{
+			vk::QueryPoolCreateInfo queryPoolCreateInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp, PROFILER_MAX_SCOPES * 2);
+			frame.queryPool = renderer->GetDevice().createQueryPool(queryPoolCreateInfo, GetAllocationCallbacks(vk::ObjectType::eQueryPool));
+			SetObjectName(renderer->GetDevice(), frame.queryPool, "Profiler timestamps");
+		}
+	}
+}
+
+Profiler::~Profiler()
+{
+	for (Frame& frame : m_Frames)
+	{
+		if (frame.queryPool)
+			m_Renderer->GetDevice().destroyQueryPool(frame.queryPool, GetAllocationCallbacks(vk::ObjectType::eQueryPool));
+	}
+}
+
+void Profiler::BeginFrame(uint32 frameIndex)
+{
+	assert(m_OpenScopes.empty());
+
+	m_FrameIndex = frameIndex;
+	Frame& frame = m_Frames[frameIndex];
+
+	if (frame.scopes.empty())
+	{
+		frame.reset = false;
+		return;
+	}
+
+	uint64 timestamps[PROFILER_MAX_SCOPES * 2];
+	bool haveTimestamps = false;
+	if (frame.queryCount > 0)
+	{
+		vk::Result result = m_Renderer->GetDevice().getQueryPoolResults(frame.queryPool, 0, frame.queryCount, 
+																		 frame.queryCount * sizeof(uint64), timestamps, 
+																		 sizeof(uint64), vk::QueryResultFlagBits::e64);
+		haveTimestamps = result == vk::Result::eSuccess;
+	}
+
+	m_Results.clear();
+	for (const Scope& scope : frame.scopes)
+	{
+		ProfileTiming timing;
+		timing.name = scope.name;
+		timing.depth = scope.depth;
+		timing.cpuMilliseconds = scope.cpuMilliseconds;
+		timing.gpuMilliseconds = -1.0;
+
+		if (haveTimestamps && scope.query != UINT32_MAX)
+		{
+			uint64 ticks = timestamps[scope.query + 1] - timestamps[scope.query];
+			timing.gpuMilliseconds = ticks * m_TimestampPeriod / 1000000.0;
+		}
+
+		m_Results.push_back(timing);
+	}
+
+	frame.scopes.clear();
+	frame.queryCount = 0;
+	frame.reset = false;
+}
+
+void Profiler::ResetQueries(vk::CommandBuffer commandBuffer)
+{
+	Frame& frame = m_Frames[m_FrameIndex];
+
+	if (m_TimestampsSupported)
+		commandBuffer.resetQueryPool(frame.queryPool, 0, PROFILER_MAX_SCOPES * 2, GetDispatch());
+
+	frame.reset = true;
+}
+
+void Profiler::BeginScope(vk::CommandBuffer commandBuffer, const char* name)
+{
+	Frame& frame = m_Frames[m_FrameIndex];
+	assert(frame.reset);
+
+	BeginLabel(commandBuffer, name);
+
+	Scope scope;
+	scope.name = name;
+	scope.depth = (uint32)m_OpenScopes.size();
+	scope.query = UINT32_MAX;
+	scope.cpuMilliseconds = 0.0;
+
+	// Scopes past the pool size still get CPU times and labels
+	if (m_TimestampsSupported && frame.queryCount + 2 <= PROFILER_MAX_SCOPES * 2)
+	{
+		scope.query = frame.queryCount;
+		frame.queryCount += 2;
+
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.queryPool, scope.query, GetDispatch());
+	}
+
+	m_OpenScopes.push_back((uint32)frame.scopes.size());
+	frame.scopes.push_back(scope);
+
+	frame.scopes.back().cpuStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::EndScope(vk::CommandBuffer commandBuffer)
+{
+	assert(!m_OpenScopes.empty());
+
+	Frame& frame = m_Frames[m_FrameIndex];
+	Scope& scope = frame.scopes[m_OpenScopes.back()];
+	m_OpenScopes.pop_back();
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - scope.cpuStart;
+	scope.cpuMilliseconds = elapsed.count();
+
+	if (scope.query != UINT32_MAX)
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.queryPool, scope.query + 1, GetDispatch());
+
+	EndLabel(commandBuffer);
+}
+
+void Profiler::PrintResults() const
+{
+	for (const ProfileTiming& timing : m_Results)
+	{
+		if (timing.gpuMilliseconds >= 0.0)
+			printf("%*s%s: cpu %.3f ms, gpu %.3f ms\n", timing.depth * 2, "", timing.name.c_str(), timing.cpuMilliseconds, timing.gpuMilliseconds);
+		else
+			printf("%*s%s: cpu %.3f ms\n", timing.depth * 2, "", timing.name.c_str(), timing.cpuMilliseconds);
+	}
+}
+
+ProfileScope::ProfileScope(Profiler* profiler, vk::CommandBuffer commandBuffer, const char* name)
+	: m_Profiler(profiler), m_CommandBuffer(commandBuffer)
+{
+	if (m_Profiler)
+		m_Profiler->BeginScope(commandBuffer, name);
+	else
+		BeginLabel(commandBuffer, name);
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (m_Profiler)
+		m_Profiler->EndScope(m_CommandBuffer);
+	else
+		EndLabel(m_CommandBuffer);
+}
\ No newline at end of file
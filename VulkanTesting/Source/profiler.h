@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <chrono>
+
+#include "types.h"
+
+class Renderer;
+
+const uint32 PROFILER_MAX_SCOPES = 64;
+
+struct ProfileTiming
+{
+	String name;
+	uint32 depth;
+
+	// Time spent recording the scope
+	double cpuMilliseconds;
+
+	// Negative when the device has no timestamps or the scope didn't get queries
+	double gpuMilliseconds;
+};
+
+// Named CPU and GPU scopes. A scope times its recording on the CPU, brackets its commands with
+// timestamp queries and labels them, so captures and validation output use the same names as the
+// timings. A frame slot's results are read back when the slot comes around again, after its fence
+class Profiler
+{
+private:
+	struct Scope
+	{
+		String name;
+		uint32 depth;
+		uint32 query;
+
+		std::chrono::steady_clock::time_point cpuStart;
+		double cpuMilliseconds;
+	};
+
+	struct Frame
+	{
+		vk::QueryPool queryPool;
+		std::vector<Scope> scopes;
+		uint32 queryCount;
+		bool reset;
+	};
+
+	Renderer* m_Renderer;
+
+	bool m_TimestampsSupported;
+	double m_TimestampPeriod;
+
+	std::vector<Frame> m_Frames;
+	uint32 m_FrameIndex;
+
+	std::vector<uint32> m_OpenScopes;
+	std::vector<ProfileTiming> m_Results;
+public:
+	Profiler(Renderer* renderer, uint32 frameCount);
+	~Profiler();
+
+	// The frame's fence has to be signaled, collects what was recorded the last time the slot was used
+	void BeginFrame(uint32 frameIndex);
+
+	// Record before the first scope of the frame, outside of a render pass
+	void ResetQueries(vk::CommandBuffer commandBuffer);
+
+	void BeginScope(vk::CommandBuffer commandBuffer, const char* name);
+	void EndScope(vk::CommandBuffer commandBuffer);
+
+	// Timings of the last frame that was read back, in recording order
+	const std::vector<ProfileTiming>& GetResults() const { return m_Results; }
+	void PrintResults() const;
+};
+
+// Profiles everything recorded while it is alive. Without a profiler it only labels the commands
+class ProfileScope
+{
+private:
+	Profiler* m_Profiler;
+	vk::CommandBuffer m_CommandBuffer;
+public:
+	ProfileScope(Profiler* profiler, vk::CommandBuffer commandBuffer, const char* name);
+	~ProfileScope();
+};
\ No newline at end of file
@@ -1,14 +1,48 @@
 #include "renderer.h"
 
 #include <algorithm>
-#include <iostream>
+#include <stdio.h>
 #include <set>
+#include <stdlib.h>
+#include <string.h>
 
 #include <SDL/SDL_vulkan.h>
 
 PFN_vkCreateDebugReportCallbackEXT CreateDebugReportCallback;
 PFN_vkDestroyDebugReportCallbackEXT DestroyDebugReportCallback;
 
+PFN_vkCreateDebugUtilsMessengerEXT CreateDebugUtilsMessenger;
+PFN_vkDestroyDebugUtilsMessengerEXT DestroyDebugUtilsMessenger;
+
+VKAPI_ATTR VkBool32 VKAPI_CALL MyDebugMessengerCallback(
+	VkDebugUtilsMessageSeverityFlagBitsEXT      messageSeverity,
+	VkDebugUtilsMessageTypeFlagsEXT             messageTypes,
+	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+	void*                                       pUserData)
+{
+	DebugSeverity severity = DebugSeverity::Info;
+	if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+		severity = DebugSeverity::Error;
+	else if (messageTypes & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
+		severity = DebugSeverity::Performance;
+	else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+		severity = DebugSeverity::Warning;
+
+	// Prefix the labels that were open on the command buffer, with the render graph that is the pass
+	char text[DEBUG_MESSAGE_MAX_LENGTH];
+	uint32 length = 0;
+	for (uint32 index = 0; index < pCallbackData->cmdBufLabelCount && length < sizeof(text); index++)
+		length += snprintf(text + length, sizeof(text) - length, "[%s] ", pCallbackData->pCmdBufLabels[index].pLabelName);
+
+	if (length < sizeof(text))
+		snprintf(text + length, sizeof(text) - length, "%s", pCallbackData->pMessage);
+
+	DebugLogger* logger = (DebugLogger*)pUserData;
+	logger->Post(severity, pCallbackData->messageIdNumber, text);
+
+	return VK_FALSE;
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL MyDebugReportCallback(
 	VkDebugReportFlagsEXT       flags,
 	VkDebugReportObjectTypeEXT  objectType,
@@ -19,40 +53,166 @@ VKAPI_ATTR VkBool32 VKAPI_CALL MyDebugReportCallback(
 	const char*                 pMessage,
 	void*                       pUserData)
 {
-	if (flags == VK_DEBUG_REPORT_ERROR_BIT_EXT)
-	{
-		std::cerr << "Error: " << pMessage << std::endl;
- 		__debugbreak();
-	}
-	else
-	{
-		std::cout << pMessage << std::endl;
-	}
+	// Called from whatever thread made the Vulkan call, only hand the message to the logger thread
+	DebugSeverity severity = DebugSeverity::Info;
+	if (flags & VK_DEBUG_REPORT_ERROR_BIT_EXT)
+		severity = DebugSeverity::Error;
+	else if (flags & VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT)
+		severity = DebugSeverity::Performance;
+	else if (flags & VK_DEBUG_REPORT_WARNING_BIT_EXT)
+		severity = DebugSeverity::Warning;
+
+	DebugLogger* logger = (DebugLogger*)pUserData;
+	logger->Post(severity, messageCode, pMessage);
 
 	return VK_FALSE;
 }
 
+bool RendererSettings::DefaultValidation()
+{
+	const char* environment = getenv("VULKAN_VALIDATION");
+	if (environment && *environment)
+		return strcmp(environment, "0") != 0;
+
+#ifdef NDEBUG
+	return false;
+#else
+	return true;
+#endif
+}
 
-Renderer::Renderer(SDL_Window* window)
-	: m_Window(window)
+Renderer::Renderer(SDL_Window* window, const RendererSettings& settings)
+	: m_Window(window), m_Settings(settings), m_ValidationEnabled(false), m_DebugUtilsEnabled(false), m_DebugLogger(nullptr), m_HostAllocator(nullptr), m_BindlessEnabled(false), m_DepthFormat(vk::Format::eUndefined), m_BindlessHeap(nullptr), m_FrameIndex(0)
 {
+	// Has to outlive everything created with its callbacks, the instance included
+	if (m_Settings.hostAllocator)
+	{
+		m_HostAllocator = new HostAllocator();
+		InstallHostAllocator(m_HostAllocator);
+	}
+
 	Init();
 	CreateInstance();
-	SetupDebugReport();
+	SetupDebugMessenger();
 	CreateSurface();
 	CreateDevice();
 
 	m_Swapchain = new Swapchain(window, this);
+
+	m_MemoryBudget = new MemoryBudget(this);
+	m_BufferAllocator = new BufferAllocator(this, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | 
+											vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eUniformBuffer | 
+											vk::BufferUsageFlagBits::eIndirectBuffer, 
+											vk::MemoryPropertyFlagBits::eDeviceLocal, NUM_FRAMES);
+	m_StagingRing = new StagingRing(this, STAGING_BUFFER_SIZE_PER_FRAME, NUM_FRAMES);
+
+	// Before anything that keeps frame memory in its members
+	for (uint32 index = 0; index < NUM_FRAMES; index++)
+		m_FrameAllocators[index] = new FrameAllocator();
+	FrameAllocator::SetCurrent(m_FrameAllocators[0]);
+
+	m_JobSystem = new JobSystem();
+
+	m_RenderPassCache = new RenderPassCache(m_Device);
+	m_FramebufferCache = new FramebufferCache(m_Device);
+	m_PipelineStateCache = new PipelineStateCache(m_Device, m_JobSystem);
+	m_SamplerCache = new SamplerCache(this);
+
+	m_DescriptorLayoutCache = new DescriptorLayoutCache(m_Device);
+	m_DescriptorAllocator = new DescriptorAllocator(m_Device, NUM_FRAMES);
+
+	if (m_BindlessEnabled)
+		m_BindlessHeap = new BindlessHeap(this);
+
+	m_UniformAllocator = new UniformAllocator(this, UNIFORM_BUFFER_SIZE_PER_FRAME, NUM_FRAMES);
+
+	m_Profiler = new Profiler(this, NUM_FRAMES);
+
+	// Per-frame resources are usable right away, before the first frame loop iteration
+	BeginFrame(0);
 }
 
 Renderer::~Renderer()
 {
+	delete m_Profiler;
+	delete m_UniformAllocator;
+	delete m_BindlessHeap;
+	delete m_DescriptorAllocator;
+	delete m_DescriptorLayoutCache;
+
+	delete m_SamplerCache;
+	delete m_PipelineStateCache;
+	delete m_FramebufferCache;
+	delete m_RenderPassCache;
+
+	// After everything that may still have jobs in flight
+	delete m_JobSystem;
+
+	FrameAllocator::SetCurrent(nullptr);
+	for (uint32 index = 0; index < NUM_FRAMES; index++)
+		delete m_FrameAllocators[index];
+
 	delete m_Swapchain;
 
-	m_Device.destroy();
+	delete m_StagingRing;
+	delete m_BufferAllocator;
+
+	// Last, everything above may still free memory
+	delete m_MemoryBudget;
+
+	m_Device.destroy(GetAllocationCallbacks(vk::ObjectType::eDevice));
 
-	DestroyDebugReportCallback(m_Instance, m_DebugReportCallback, NULL);
-	m_Instance.destroy();
+	if (m_ValidationEnabled && m_DebugUtilsEnabled)
+		DestroyDebugUtilsMessenger(m_Instance, m_DebugMessenger, NULL);
+	else if (m_ValidationEnabled)
+		DestroyDebugReportCallback(m_Instance, m_DebugReportCallback, NULL);
+	m_Instance.destroy(GetAllocationCallbacks(vk::ObjectType::eInstance));
+
+	InstallHostAllocator(nullptr);
+	delete m_HostAllocator;
+
+	// After the instance, the layers can report until it is gone
+	delete m_DebugLogger;
+}
+
+bool Renderer::RecreateSwapchain()
+{
+	// The window size is part of the surface capabilities, the rest of the snapshot can't change
+	m_Capabilities.RefreshSurface(m_GPUDevice, m_Surface);
+
+	// Minimized windows report a 0x0 extent, which no swapchain can be created with
+	if (!m_Swapchain->HasDrawableExtent())
+		return false;
+
+	m_Device.waitIdle();
+
+	// Render passes only depend on formats and stay valid, framebuffers point at the old views
+	m_FramebufferCache->EvictImageViews(m_Swapchain->GetImageViews());
+	m_Swapchain->Recreate();
+
+	return true;
+}
+
+void Renderer::BeginFrame(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+
+	// Everything allocated from it was for the frame that last used this slot, which is done now
+	m_FrameAllocators[frameIndex]->Reset();
+	FrameAllocator::SetCurrent(m_FrameAllocators[frameIndex]);
+
+	m_MemoryBudget->Update();
+	m_BufferAllocator->BeginFrame(frameIndex);
+	m_StagingRing->BeginFrame(frameIndex);
+
+	m_DescriptorAllocator->BeginFrame(frameIndex);
+
+	if (m_BindlessHeap)
+		m_BindlessHeap->BeginFrame(frameIndex);
+
+	m_UniformAllocator->BeginFrame(frameIndex);
+
+	m_Profiler->BeginFrame(frameIndex);
 }
 
 void Renderer::Init()
@@ -63,13 +223,71 @@ void Renderer::Init()
 	m_InstanceExtentions.resize(SDLInstanceExtenstionsCount);
 	SDL_Vulkan_GetInstanceExtensions(m_Window, &SDLInstanceExtenstionsCount, m_InstanceExtentions.data());
 
-	m_InstanceExtentions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
-	m_InstanceLayers.push_back("VK_LAYER_LUNARG_standard_validation");
-
 	m_DeviceExtenstions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
-	//TODO: Check instance layers and extentions for validations i.e vk::enumareateInstanceExtenstions(); and vk::enumareateInstanceLayers();
-	
+	// Only enabled when the device supports them, check with IsDeviceExtensionEnabled
+	m_OptionalDeviceExtenstions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+#ifdef VK_EXT_memory_budget
+	m_OptionalDeviceExtenstions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+#endif
+
+	if (m_Settings.bindless)
+		m_OptionalDeviceExtenstions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+
+	// Labels and names go to captures even without validation, the messenger needs the same extension
+#ifdef DEBUG_UTILS_ENABLED
+	bool wantDebugUtils = true;
+#else
+	bool wantDebugUtils = m_Settings.validation;
+#endif
+
+	if (wantDebugUtils && IsInstanceExtensionAvailable(VK_EXT_DEBUG_UTILS_EXTENSION_NAME))
+	{
+		m_InstanceExtentions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		m_DebugUtilsEnabled = true;
+	}
+
+	const char* validationLayer = nullptr;
+	if (m_Settings.validation)
+	{
+		// Older SDKs only ship the meta layer that was replaced by the Khronos one
+		if (IsInstanceLayerAvailable(VALIDATION_LAYER_NAME))
+			validationLayer = VALIDATION_LAYER_NAME;
+		else if (IsInstanceLayerAvailable(LEGACY_VALIDATION_LAYER_NAME))
+			validationLayer = LEGACY_VALIDATION_LAYER_NAME;
+		else
+			printf("%s not installed, running without validation\n", VALIDATION_LAYER_NAME);
+	}
+
+	if (!validationLayer)
+		return;
+
+	m_ValidationEnabled = true;
+	m_InstanceLayers.push_back(validationLayer);
+
+	m_DebugLogger = new DebugLogger();
+
+	if (m_DebugUtilsEnabled)
+	{
+		m_DebugMessengerCreateInfo = {};
+		m_DebugMessengerCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+
+		m_DebugMessengerCreateInfo.messageSeverity =
+			VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+			VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+		m_DebugMessengerCreateInfo.messageType =
+			VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+			VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+			VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+		m_DebugMessengerCreateInfo.pfnUserCallback = MyDebugMessengerCallback;
+		m_DebugMessengerCreateInfo.pUserData = m_DebugLogger;
+		return;
+	}
+
+	// Fallback for loaders without VK_EXT_debug_utils
+	m_InstanceExtentions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+
 	m_DebugReportCallbackCreateInfo = {};
 	m_DebugReportCallbackCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CREATE_INFO_EXT;
 
@@ -79,6 +297,31 @@ void Renderer::Init()
 		VK_DEBUG_REPORT_ERROR_BIT_EXT |
 		VK_DEBUG_REPORT_DEBUG_BIT_EXT;
 	m_DebugReportCallbackCreateInfo.pfnCallback = (PFN_vkDebugReportCallbackEXT)MyDebugReportCallback;
+	m_DebugReportCallbackCreateInfo.pUserData = m_DebugLogger;
+}
+
+bool Renderer::IsInstanceExtensionAvailable(const char* name)
+{
+	std::vector<vk::ExtensionProperties> extensionProperties = vk::enumerateInstanceExtensionProperties();
+	for (const vk::ExtensionProperties& properties : extensionProperties)
+	{
+		if (strcmp(properties.extensionName, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool Renderer::IsInstanceLayerAvailable(const char* name)
+{
+	std::vector<vk::LayerProperties> layerProperties = vk::enumerateInstanceLayerProperties();
+	for (const vk::LayerProperties& properties : layerProperties)
+	{
+		if (strcmp(properties.layerName, name) == 0)
+			return true;
+	}
+
+	return false;
 }
 
 void Renderer::CreateInstance()
@@ -91,9 +334,16 @@ void Renderer::CreateInstance()
 											(uint32)m_InstanceLayers.size(), m_InstanceLayers.data(),
 											(uint32)m_InstanceExtentions.size(), m_InstanceExtentions.data());
 
-	instanceCreateInfo.pNext = &m_DebugReportCallbackCreateInfo;
+	// Also reports problems with instance creation itself
+	if (m_ValidationEnabled && m_DebugUtilsEnabled)
+		instanceCreateInfo.pNext = &m_DebugMessengerCreateInfo;
+	else if (m_ValidationEnabled)
+		instanceCreateInfo.pNext = &m_DebugReportCallbackCreateInfo;
+
+	m_Instance = vk::createInstance(instanceCreateInfo, GetAllocationCallbacks(vk::ObjectType::eInstance));
 
-	m_Instance = vk::createInstance(instanceCreateInfo);
+	if (m_DebugUtilsEnabled)
+		LoadDebugUtils(m_Instance);
 }
 
 void Renderer::CreateSurface()
@@ -105,8 +355,24 @@ void Renderer::CreateSurface()
 	m_Surface = vk::SurfaceKHR(SDLSurface);
 }
 
-void Renderer::SetupDebugReport()
+void Renderer::SetupDebugMessenger()
 {
+	if (!m_ValidationEnabled)
+		return;
+
+	if (m_DebugUtilsEnabled)
+	{
+		CreateDebugUtilsMessenger = (PFN_vkCreateDebugUtilsMessengerEXT)m_Instance.getProcAddr("vkCreateDebugUtilsMessengerEXT");
+		DestroyDebugUtilsMessenger = (PFN_vkDestroyDebugUtilsMessengerEXT)m_Instance.getProcAddr("vkDestroyDebugUtilsMessengerEXT");
+
+		VkDebugUtilsMessengerEXT debugMessenger;
+		VkResult vulkanResult = CreateDebugUtilsMessenger(m_Instance, &m_DebugMessengerCreateInfo, NULL, &debugMessenger);
+		assert(vulkanResult == VK_SUCCESS);
+
+		m_DebugMessenger = vk::DebugUtilsMessengerEXT(debugMessenger);
+		return;
+	}
+
 	CreateDebugReportCallback = (PFN_vkCreateDebugReportCallbackEXT)m_Instance.getProcAddr("vkCreateDebugReportCallbackEXT");
 	DestroyDebugReportCallback = (PFN_vkDestroyDebugReportCallbackEXT)m_Instance.getProcAddr("vkDestroyDebugReportCallbackEXT");
 
@@ -117,42 +383,32 @@ void Renderer::SetupDebugReport()
 	m_DebugReportCallback = vk::DebugReportCallbackEXT(debugReportCallback);
 }
 
-QueueFamilyIndicies Renderer::GetQueueFamilyIndicies(vk::PhysicalDevice gpuDevice)
+bool Renderer::IsDeviceExtensionEnabled(const char* name) const
 {
-	QueueFamilyIndicies result;
-	std::vector<vk::QueueFamilyProperties> queueFamilyProperties = gpuDevice.getQueueFamilyProperties();
-
-	for (int32 index = 0; index < queueFamilyProperties.size(); index++)
+	for (const char* extension : m_DeviceExtenstions)
 	{
-		if (queueFamilyProperties[index].queueCount > 0 && queueFamilyProperties[index].queueFlags & vk::QueueFlagBits::eGraphics)
-		{
-			result.graphicsIndex = index;
-		}
-
-		uint32 presentSupport = gpuDevice.getSurfaceSupportKHR(index, m_Surface);
-		if (queueFamilyProperties[index].queueCount > 0 && presentSupport)
-		{
-			result.presentIndex = index;
-		}
-
-		if (result.IsComplete())
-			break;
+		if (strcmp(extension, name) == 0)
+			return true;
 	}
 
-	assert(result.IsComplete());
-	return result;
+	return false;
 }
 
-
-bool Renderer::IsGPUDeviceSuitable(vk::PhysicalDevice gpuDevice)
+uint32 Renderer::FindMemoryType(uint32 typeFilter, vk::MemoryPropertyFlags properties) const
 {
-	QueueFamilyIndicies familyIndices = GetQueueFamilyIndicies(gpuDevice);
+	uint32 memoryType = m_Capabilities.FindMemoryType(typeFilter, properties);
+	if (memoryType == UINT32_MAX)
+		throw std::runtime_error("failed to find suitable memory type!");
+
+	return memoryType;
+}
 
+bool Renderer::IsGPUDeviceSuitable(const DeviceCapabilities& capabilities) const
+{
 	//TODO: Check for swapchain extentions is present 
-	SwapchainSupportInfo swapChainInfo = SwapchainSupportInfo::GetSwapchainSupportInfo(m_Surface, gpuDevice);
-	bool swapChainComplete = !swapChainInfo.formats.empty() && !swapChainInfo.presentModes.empty();
+	bool swapChainComplete = !capabilities.surface.formats.empty() && !capabilities.surface.presentModes.empty();
 
-	return familyIndices.IsComplete() && swapChainComplete;
+	return capabilities.queueFamilyIndicies.IsComplete() && swapChainComplete;
 }
 
 void Renderer::CreateDevice()
@@ -161,15 +417,74 @@ void Renderer::CreateDevice()
 	std::vector<vk::PhysicalDevice> physicalDevices = m_Instance.enumeratePhysicalDevices();
 	m_GPUDevice = physicalDevices[0];
 
+	// Everything else asks the snapshot rather than the driver
+	m_Capabilities.Query(m_GPUDevice, m_Surface);
+
 	//TODO: Check all the physical devices
-	assert(IsGPUDeviceSuitable(m_GPUDevice));
+	assert(IsGPUDeviceSuitable(m_Capabilities));
+
+	// D16 is always there, which of the more precise ones depends on the device
+	vk::Format depthFormats[] = { vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint, vk::Format::eD16Unorm };
+	m_DepthFormat = m_Capabilities.FindSupportedFormat(depthFormats, vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+	if (m_DepthFormat == vk::Format::eUndefined)
+		throw std::runtime_error("failed to find a supported depth format!");
+
+	const vk::PhysicalDeviceFeatures& supportedFeatures = m_Capabilities.features;
+
+	// Needed by the GPU driven draws. Without multi draw GpuCuller issues one indirect draw per object
+	// slot, culled ones included as zero instance draws, but it can't work without the first instance
+	m_EnabledFeatures = {};
+	m_EnabledFeatures.setMultiDrawIndirect(supportedFeatures.multiDrawIndirect);
+	m_EnabledFeatures.setDrawIndirectFirstInstance(supportedFeatures.drawIndirectFirstInstance);
+
+	// SamplerCache turns anisotropic filtering off without it
+	m_EnabledFeatures.setSamplerAnisotropy(supportedFeatures.samplerAnisotropy);
+
+	// Block compressed formats only report as sampleable when the matching feature is supported
+	m_EnabledFeatures.setTextureCompressionBC(supportedFeatures.textureCompressionBC);
+	m_EnabledFeatures.setTextureCompressionETC2(supportedFeatures.textureCompressionETC2);
+	m_EnabledFeatures.setTextureCompressionASTC_LDR(supportedFeatures.textureCompressionASTC_LDR);
+
+	for (const char* extension : m_OptionalDeviceExtenstions)
+	{
+		if (m_Capabilities.IsExtensionSupported(extension))
+			m_DeviceExtenstions.push_back(extension);
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+	if (IsDeviceExtensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexingFeatures = {};
+		supportedIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &supportedIndexingFeatures;
 
-	m_QueueFamilyIndicies = GetQueueFamilyIndicies(m_GPUDevice);
+		vkGetPhysicalDeviceFeatures2(m_GPUDevice, &features2);
 
-	vk::PhysicalDeviceFeatures features = {};
+		m_BindlessEnabled = 
+			supportedIndexingFeatures.runtimeDescriptorArray &&
+			supportedIndexingFeatures.descriptorBindingPartiallyBound &&
+			supportedIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+			supportedIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+			supportedIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind;
+
+		if (m_BindlessEnabled)
+		{
+			descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+			descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+			descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing = supportedIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing;
+			descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		}
+	}
 
 	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
-	std::set<int> uniqueQueueFamilies = { m_QueueFamilyIndicies.graphicsIndex, m_QueueFamilyIndicies.presentIndex };
+	std::set<int> uniqueQueueFamilies = { m_Capabilities.queueFamilyIndicies.graphicsIndex, m_Capabilities.queueFamilyIndicies.presentIndex };
 
 	float queuePriority = 1.0f;
 	for (int queueFamily : uniqueQueueFamilies) {
@@ -186,15 +501,14 @@ void Renderer::CreateDevice()
 										  (uint32)queueCreateInfos.size(), queueCreateInfos.data(),
 										  (uint32)m_InstanceLayers.size(), m_InstanceLayers.data(), 
 										  (uint32)m_DeviceExtenstions.size(), m_DeviceExtenstions.data(), 
-										  &features);
-
-	m_Device = m_GPUDevice.createDevice(deviceCreateInfo);
-
-	m_GraphicsQueue = m_Device.getQueue(m_QueueFamilyIndicies.graphicsIndex, 0);
-	m_PresentQueue = m_Device.getQueue(m_QueueFamilyIndicies.presentIndex, 0);
-}
-
-
+										  &m_EnabledFeatures);
 
+	if (m_BindlessEnabled)
+		deviceCreateInfo.setPNext(&descriptorIndexingFeatures);
 
+	m_Device = m_GPUDevice.createDevice(deviceCreateInfo, GetAllocationCallbacks(vk::ObjectType::eDevice));
+	LoadDeviceDispatch(m_Instance, m_Device);
 
+	m_GraphicsQueue = m_Device.getQueue(m_Capabilities.queueFamilyIndicies.graphicsIndex, 0);
+	m_PresentQueue = m_Device.getQueue(m_Capabilities.queueFamilyIndicies.presentIndex, 0);
+}
\ No newline at end of file
@@ -5,64 +5,174 @@
 
 #include "types.h"
 #include "swapchain.h"
-
-struct QueueFamilyIndicies
+#include "devicecaps.h"
+#include "descriptor.h"
+#include "renderpass.h"
+#include "pipelinecache.h"
+#include "jobsystem.h"
+#include "bindless.h"
+#include "uniformallocator.h"
+#include "debuglog.h"
+#include "debugutils.h"
+#include "profiler.h"
+#include "dispatch.h"
+#include "hostallocator.h"
+#include "framealloc.h"
+#include "memorybudget.h"
+#include "bufferallocator.h"
+#include "stagingring.h"
+#include "texture.h"
+
+const uint32 NUM_FRAMES = 2;
+const vk::DeviceSize UNIFORM_BUFFER_SIZE_PER_FRAME = 1024 * 1024;
+const vk::DeviceSize STAGING_BUFFER_SIZE_PER_FRAME = 8 * 1024 * 1024;
+
+const char* const VALIDATION_LAYER_NAME = "VK_LAYER_KHRONOS_validation";
+const char* const LEGACY_VALIDATION_LAYER_NAME = "VK_LAYER_LUNARG_standard_validation";
+
+struct RendererSettings
 {
-	int32 graphicsIndex = -1;
-	int32 presentIndex = -1;
+	// Uses the bindless heap when the device supports descriptor indexing
+	bool bindless = true;
+
+	// Driver host allocations go through a HostAllocator that counts them
+	bool hostAllocator = true;
+
+	// Validation layers and the debug messenger, see DefaultValidation
+	bool validation = DefaultValidation();
 
-	bool IsComplete() const
-	{
-		return graphicsIndex >= 0 && presentIndex >= 0;
-	}
+	// Off in release builds. VULKAN_VALIDATION=1 or 0 in the environment overrides the build default
+	static bool DefaultValidation();
 };
 
 class Renderer
 {
 private:
 	SDL_Window* m_Window;
+	RendererSettings m_Settings;
 
+	VkDebugUtilsMessengerCreateInfoEXT m_DebugMessengerCreateInfo;
 	VkDebugReportCallbackCreateInfoEXT m_DebugReportCallbackCreateInfo;
 	vk::Instance m_Instance;
 	vk::SurfaceKHR m_Surface;
+	vk::DebugUtilsMessengerEXT m_DebugMessenger;
 	vk::DebugReportCallbackEXT m_DebugReportCallback;
 
-	QueueFamilyIndicies m_QueueFamilyIndicies;
+	bool m_ValidationEnabled;
+	bool m_DebugUtilsEnabled;
+	DebugLogger* m_DebugLogger;
+
+	HostAllocator* m_HostAllocator;
+
 	vk::PhysicalDevice m_GPUDevice;
+	DeviceCapabilities m_Capabilities;
 	vk::Device m_Device;
 
+	vk::PhysicalDeviceFeatures m_EnabledFeatures;
+	bool m_BindlessEnabled;
+	vk::Format m_DepthFormat;
+
 	vk::Queue m_GraphicsQueue;
 	vk::Queue m_PresentQueue;
 
 	Swapchain* m_Swapchain;
 
+	MemoryBudget* m_MemoryBudget;
+	BufferAllocator* m_BufferAllocator;
+	StagingRing* m_StagingRing;
+
+	JobSystem* m_JobSystem;
+
+	RenderPassCache* m_RenderPassCache;
+	FramebufferCache* m_FramebufferCache;
+	PipelineStateCache* m_PipelineStateCache;
+	SamplerCache* m_SamplerCache;
+
+	DescriptorLayoutCache* m_DescriptorLayoutCache;
+	DescriptorAllocator* m_DescriptorAllocator;
+	BindlessHeap* m_BindlessHeap;
+	UniformAllocator* m_UniformAllocator;
+
+	Profiler* m_Profiler;
+
+	// One per frame in flight, the current one is reset and made current in BeginFrame
+	FrameAllocator* m_FrameAllocators[NUM_FRAMES];
+	uint32 m_FrameIndex;
+
 	std::vector<const char*> m_InstanceExtentions;
 	std::vector<const char*> m_InstanceLayers;
 
 	std::vector<const char*> m_DeviceExtenstions;
+	std::vector<const char*> m_OptionalDeviceExtenstions;
 public:
-	Renderer(SDL_Window* window);
+	Renderer(SDL_Window* window, const RendererSettings& settings = RendererSettings());
 	~Renderer();
 
 	vk::Instance GetInstance() const { return m_Instance; }
+	bool IsValidationEnabled() const { return m_ValidationEnabled; }
 	vk::SurfaceKHR GetSurface() const { return m_Surface; }
 
 	vk::PhysicalDevice GetGPUDevice() const { return m_GPUDevice; }
+	const DeviceCapabilities& GetCapabilities() const { return m_Capabilities; }
 	vk::Device GetDevice() const { return m_Device; }
+	const vk::PhysicalDeviceFeatures& GetEnabledFeatures() const { return m_EnabledFeatures; }
+
+	bool IsDeviceExtensionEnabled(const char* name) const;
+
+	// The most precise depth format the device can render to, with a stencil component only if that's all it has
+	vk::Format GetDepthFormat() const { return m_DepthFormat; }
 
 	vk::Queue GetGraphicsQueue() const { return m_GraphicsQueue; }
 	vk::Queue GetPresentQueue() const { return m_PresentQueue; }
 
 	Swapchain* GetSwapchain() const { return m_Swapchain; }
 
-	QueueFamilyIndicies GetQueueFamilyIndicies(vk::PhysicalDevice gpuDevice);
+	// Device memory is allocated and freed through it
+	MemoryBudget* GetMemoryBudget() const { return m_MemoryBudget; }
+
+	// Device local sub-allocated buffers, defragmented a step at a time by the frame loop
+	BufferAllocator* GetBufferAllocator() const { return m_BufferAllocator; }
+
+	// Source memory for uploads recorded in the current frame
+	StagingRing* GetStagingRing() const { return m_StagingRing; }
+
+	// Waits for the device to go idle, call when presenting reports the swapchain out of date. Returns
+	// false and keeps the old swapchain while the surface is 0x0, nothing can be drawn until it isn't
+	bool RecreateSwapchain();
+
+	JobSystem* GetJobSystem() const { return m_JobSystem; }
+
+	RenderPassCache* GetRenderPassCache() const { return m_RenderPassCache; }
+	FramebufferCache* GetFramebufferCache() const { return m_FramebufferCache; }
+	PipelineStateCache* GetPipelineStateCache() const { return m_PipelineStateCache; }
+	SamplerCache* GetSamplerCache() const { return m_SamplerCache; }
+
+	DescriptorLayoutCache* GetDescriptorLayoutCache() const { return m_DescriptorLayoutCache; }
+	DescriptorAllocator* GetDescriptorAllocator() const { return m_DescriptorAllocator; }
+
+	// Null when bindless is turned off or not supported by the device
+	BindlessHeap* GetBindlessHeap() const { return m_BindlessHeap; }
+	bool IsBindlessEnabled() const { return m_BindlessEnabled; }
+
+	UniformAllocator* GetUniformAllocator() const { return m_UniformAllocator; }
+	Profiler* GetProfiler() const { return m_Profiler; }
+	FrameAllocator* GetFrameAllocator() const { return m_FrameAllocators[m_FrameIndex]; }
+
+	// Recycles the per-frame resources of frameIndex, call after waiting on that frame's fence
+	void BeginFrame(uint32 frameIndex);
+	uint32 GetFrameIndex() const { return m_FrameIndex; }
+
+	const QueueFamilyIndicies& GetQueueFamilyIndicies() const { return m_Capabilities.queueFamilyIndicies; }
+	uint32 FindMemoryType(uint32 typeFilter, vk::MemoryPropertyFlags properties) const;
 private:
 	void Init();
+	bool IsInstanceLayerAvailable(const char* name);
+	bool IsInstanceExtensionAvailable(const char* name);
 
 	void CreateInstance();
 	void CreateSurface();
-	void SetupDebugReport();
+	void SetupDebugMessenger();
 
-	bool IsGPUDeviceSuitable(vk::PhysicalDevice gpuDevice);
+	bool IsGPUDeviceSuitable(const DeviceCapabilities& capabilities) const;
 	void CreateDevice();
 };
\ No newline at end of file
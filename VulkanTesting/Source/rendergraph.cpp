@@ -0,0 +1,759 @@
+#include "rendergraph.h"
+
+#include "renderer.h"
+#include "hash.h"
+
+#include <assert.h>
+#include <algorithm>
+
+ResourceState GetUsageState(ResourceUsage usage)
+{
+	typedef vk::PipelineStageFlagBits Stage;
+	typedef vk::AccessFlagBits Access;
+	typedef vk::ImageLayout Layout;
+
+	ResourceState state;
+	switch (usage)
+	{
+	case ResourceUsage::ColorAttachment:
+		state.stages = Stage::eColorAttachmentOutput;
+		state.access = Access::eColorAttachmentRead | Access::eColorAttachmentWrite;
+		state.layout = Layout::eColorAttachmentOptimal;
+		break;
+	case ResourceUsage::DepthAttachment:
+		state.stages = Stage::eEarlyFragmentTests | Stage::eLateFragmentTests;
+		state.access = Access::eDepthStencilAttachmentRead | Access::eDepthStencilAttachmentWrite;
+		state.layout = Layout::eDepthStencilAttachmentOptimal;
+		break;
+	case ResourceUsage::DepthAttachmentRead:
+		state.stages = Stage::eEarlyFragmentTests | Stage::eLateFragmentTests;
+		state.access = Access::eDepthStencilAttachmentRead;
+		state.layout = Layout::eDepthStencilAttachmentOptimal;
+		break;
+	case ResourceUsage::FragmentShaderRead:
+		state.stages = Stage::eFragmentShader;
+		state.access = Access::eShaderRead;
+		state.layout = Layout::eShaderReadOnlyOptimal;
+		break;
+	case ResourceUsage::ComputeShaderRead:
+		state.stages = Stage::eComputeShader;
+		state.access = Access::eShaderRead;
+		state.layout = Layout::eShaderReadOnlyOptimal;
+		break;
+	case ResourceUsage::ComputeShaderWrite:
+		state.stages = Stage::eComputeShader;
+		state.access = Access::eShaderRead | Access::eShaderWrite;
+		state.layout = Layout::eGeneral;
+		break;
+	case ResourceUsage::Present:
+		state.stages = Stage::eBottomOfPipe;
+		state.layout = Layout::ePresentSrcKHR;
+		break;
+	case ResourceUsage::IndirectRead:
+		state.stages = Stage::eDrawIndirect;
+		state.access = Access::eIndirectCommandRead;
+		break;
+	case ResourceUsage::VertexRead:
+		state.stages = Stage::eVertexInput;
+		state.access = Access::eVertexAttributeRead;
+		break;
+	case ResourceUsage::IndexRead:
+		state.stages = Stage::eVertexInput;
+		state.access = Access::eIndexRead;
+		break;
+	case ResourceUsage::UniformRead:
+		state.stages = Stage::eVertexShader | Stage::eFragmentShader;
+		state.access = Access::eUniformRead;
+		break;
+	case ResourceUsage::ComputeBufferRead:
+		state.stages = Stage::eComputeShader;
+		state.access = Access::eShaderRead;
+		break;
+	case ResourceUsage::ComputeBufferWrite:
+		state.stages = Stage::eComputeShader;
+		state.access = Access::eShaderRead | Access::eShaderWrite;
+		break;
+	case ResourceUsage::HostRead:
+		state.stages = Stage::eHost;
+		state.access = Access::eHostRead;
+		break;
+	case ResourceUsage::TransferRead:
+		state.stages = Stage::eTransfer;
+		state.access = Access::eTransferRead;
+		state.layout = Layout::eTransferSrcOptimal;
+		break;
+	case ResourceUsage::TransferWrite:
+		state.stages = Stage::eTransfer;
+		state.access = Access::eTransferWrite;
+		state.layout = Layout::eTransferDstOptimal;
+		break;
+	default:
+		assert(false);
+	}
+
+	return state;
+}
+
+bool IsWriteUsage(ResourceUsage usage)
+{
+	switch (usage)
+	{
+	case ResourceUsage::ColorAttachment:
+	case ResourceUsage::DepthAttachment:
+	case ResourceUsage::ComputeShaderWrite:
+	case ResourceUsage::ComputeBufferWrite:
+	case ResourceUsage::TransferWrite:
+		return true;
+	default:
+		return false;
+	}
+}
+
+RenderPassBuilder::RenderPassBuilder(RenderGraph* graph, uint32 passIndex)
+	: m_Graph(graph), m_PassIndex(passIndex)
+{
+}
+
+RenderPassBuilder& RenderPassBuilder::Read(RenderGraphResource resource, ResourceUsage usage)
+{
+	assert(resource < m_Graph->m_Resources.size());
+	m_Graph->m_Passes[m_PassIndex].accesses.push_back({ resource, usage, false });
+
+	return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::Write(RenderGraphResource resource, ResourceUsage usage)
+{
+	assert(resource < m_Graph->m_Resources.size());
+	m_Graph->m_Passes[m_PassIndex].accesses.push_back({ resource, usage, true });
+
+	return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::SetSideEffects()
+{
+	m_Graph->m_Passes[m_PassIndex].sideEffects = true;
+
+	return *this;
+}
+
+RenderGraph::RenderGraph(Renderer* renderer)
+	: m_Renderer(renderer), m_FinalQueueFamily(VK_QUEUE_FAMILY_IGNORED), m_Compiled(false), m_AliasingEnabled(true), m_Transients()
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+	DestroyTransientSet(m_Transients);
+
+	for (TransientSet& set : m_RetiredTransients)
+		DestroyTransientSet(set);
+}
+
+void RenderGraph::Reset()
+{
+	// Replaced transient images may still be used by the frames in flight
+	for (uint32 index = 0; index < m_RetiredTransients.size();)
+	{
+		TransientSet& set = m_RetiredTransients[index];
+		if (set.framesUntilDestroy-- == 0)
+		{
+			DestroyTransientSet(set);
+			m_RetiredTransients.erase(m_RetiredTransients.begin() + index);
+		}
+		else
+		{
+			index++;
+		}
+	}
+
+	m_Resources.clear();
+	m_Passes.clear();
+
+	// The old barriers were in an earlier frame's memory, take the current frame allocator instead
+	m_FinalBarriers = FrameVector<Barrier>();
+	m_FinalQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+	m_Compiled = false;
+}
+
+RenderGraphResource RenderGraph::AddResource(const String& name, const ResourceState& initialState)
+{
+	Resource resource = {};
+	resource.name = name;
+	resource.initialState = initialState;
+	resource.isImage = false;
+	resource.transient = false;
+	resource.isOutput = false;
+
+	m_Resources.push_back(resource);
+	return (RenderGraphResource)m_Resources.size() - 1;
+}
+
+RenderGraphResource RenderGraph::ImportImage(const String& name, vk::Image image, vk::ImageAspectFlags aspect, const ResourceState& initialState)
+{
+	RenderGraphResource handle = AddResource(name, initialState);
+	m_Resources[handle].isImage = true;
+	m_Resources[handle].image = image;
+	m_Resources[handle].aspect = aspect;
+
+	return handle;
+}
+
+RenderGraphResource RenderGraph::CreateImage(const String& name, const TransientImageDesc& desc)
+{
+	// Whatever used the memory before, earlier in this frame or in the previous one, is done with it
+	// by the time the first pass writes. That earlier user wrote the memory too, so its writes have to
+	// be made available before this one. Transient contents never survive so the layout is undefined
+	ResourceState initialState;
+	initialState.stages = vk::PipelineStageFlagBits::eAllCommands;
+	initialState.access = vk::AccessFlagBits::eMemoryWrite;
+
+	RenderGraphResource handle = AddResource(name, initialState);
+	m_Resources[handle].isImage = true;
+	m_Resources[handle].aspect = desc.aspect;
+	m_Resources[handle].transient = true;
+	m_Resources[handle].desc = desc;
+
+	return handle;
+}
+
+vk::Image RenderGraph::GetImage(RenderGraphResource resource) const
+{
+	assert(resource < m_Resources.size() && m_Resources[resource].isImage);
+	return m_Resources[resource].image;
+}
+
+vk::ImageView RenderGraph::GetImageView(RenderGraphResource resource) const
+{
+	assert(resource < m_Resources.size() && m_Resources[resource].isImage);
+	return m_Resources[resource].view;
+}
+
+RenderGraphResource RenderGraph::ImportBuffer(const String& name, vk::Buffer buffer, const ResourceState& initialState)
+{
+	RenderGraphResource handle = AddResource(name, initialState);
+	m_Resources[handle].buffer = buffer;
+
+	return handle;
+}
+
+void RenderGraph::MarkOutput(RenderGraphResource resource, ResourceUsage finalUsage)
+{
+	assert(resource < m_Resources.size());
+
+	m_Resources[resource].isOutput = true;
+	m_Resources[resource].outputUsage = finalUsage;
+}
+
+uint32 RenderGraph::PushPass(const String& name, uint32 queueFamily, const FrameFunction<void(vk::CommandBuffer)>& execute)
+{
+	assert(!m_Compiled);
+
+	Pass pass = {};
+	pass.name = name;
+	pass.queueFamily = queueFamily;
+	pass.sideEffects = false;
+	pass.culled = false;
+	pass.execute = execute;
+
+	m_Passes.push_back(pass);
+	return (uint32)m_Passes.size() - 1;
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk backwards keeping track of which resources still have a reader waiting for them. A pass
+	// survives when it writes one of those, and then its own reads become needed in turn
+	FrameVector<bool> needed(m_Resources.size(), false);
+	for (uint32 index = 0; index < m_Resources.size(); index++)
+		needed[index] = m_Resources[index].isOutput;
+
+	for (uint32 passIndex = (uint32)m_Passes.size(); passIndex-- > 0;)
+	{
+		Pass& pass = m_Passes[passIndex];
+
+		bool alive = pass.sideEffects;
+		for (const Access& access : pass.accesses)
+		{
+			if (access.write && needed[access.resource])
+				alive = true;
+		}
+
+		pass.culled = !alive;
+		if (!alive)
+			continue;
+
+		// A pure write replaces the contents, earlier writers of it are only needed if we read it too
+		for (const Access& access : pass.accesses)
+		{
+			if (access.write)
+				needed[access.resource] = false;
+		}
+
+		for (const Access& access : pass.accesses)
+		{
+			if (!access.write)
+				needed[access.resource] = true;
+		}
+	}
+}
+
+void RenderGraph::AllocateTransients()
+{
+	FrameVector<RenderGraphResource> transients;
+	FrameVector<std::pair<uint32, uint32>> lifetimes;
+
+	for (uint32 resourceIndex = 0; resourceIndex < m_Resources.size(); resourceIndex++)
+	{
+		if (!m_Resources[resourceIndex].transient)
+			continue;
+
+		uint32 first = UINT32_MAX;
+		uint32 last = 0;
+		for (uint32 passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+		{
+			if (m_Passes[passIndex].culled)
+				continue;
+
+			for (const Access& access : m_Passes[passIndex].accesses)
+			{
+				if (access.resource == resourceIndex)
+				{
+					first = std::min(first, passIndex);
+					last = std::max(last, passIndex);
+				}
+			}
+		}
+
+		// Only used by culled passes
+		if (first == UINT32_MAX)
+			continue;
+
+		transients.push_back(resourceIndex);
+		lifetimes.push_back({ first, last });
+	}
+
+	uint64 key = HashValue(m_AliasingEnabled, HASH_SEED);
+	for (uint32 index = 0; index < transients.size(); index++)
+	{
+		const TransientImageDesc& desc = m_Resources[transients[index]].desc;
+		key = HashValue((uint32)desc.format, key);
+		key = HashValue(desc.extent, key);
+		key = HashValue((uint32)desc.usage, key);
+		key = HashValue((uint32)desc.aspect, key);
+		key = HashValue(lifetimes[index], key);
+	}
+
+	if (key != m_Transients.key)
+	{
+		if (!m_Transients.images.empty())
+		{
+			m_Transients.framesUntilDestroy = NUM_FRAMES;
+			m_RetiredTransients.push_back(m_Transients);
+		}
+
+		m_Transients = TransientSet();
+		m_Transients.key = key;
+		CreateTransientSet(transients, lifetimes);
+	}
+
+	for (uint32 index = 0; index < transients.size(); index++)
+	{
+		m_Resources[transients[index]].image = m_Transients.images[index];
+		m_Resources[transients[index]].view = m_Transients.views[index];
+	}
+}
+
+void RenderGraph::CreateTransientSet(const FrameVector<RenderGraphResource>& transients, const FrameVector<std::pair<uint32, uint32>>& lifetimes)
+{
+	vk::Device device = m_Renderer->GetDevice();
+	const DeviceCapabilities& capabilities = m_Renderer->GetCapabilities();
+
+	const vk::ImageUsageFlags attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | 
+												vk::ImageUsageFlagBits::eDepthStencilAttachment | 
+												vk::ImageUsageFlagBits::eInputAttachment;
+
+	std::vector<vk::MemoryRequirements> requirements(transients.size());
+	std::vector<uint32> memoryTypes(transients.size());
+
+	for (uint32 index = 0; index < transients.size(); index++)
+	{
+		const TransientImageDesc& desc = m_Resources[transients[index]].desc;
+
+		// Targets that are only ever attachments can live in tile memory on GPUs that have it
+		vk::ImageUsageFlags usage = desc.usage;
+		bool attachmentOnly = !(usage & ~attachmentUsage);
+		if (attachmentOnly)
+			usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+
+		vk::ImageCreateInfo imageCreateInfo = {};
+		imageCreateInfo.setImageType(vk::ImageType::e2D);
+		imageCreateInfo.setFormat(desc.format);
+		imageCreateInfo.setExtent(vk::Extent3D(desc.extent.width, desc.extent.height, 1));
+		imageCreateInfo.setMipLevels(1);
+		imageCreateInfo.setArrayLayers(1);
+		imageCreateInfo.setSamples(vk::SampleCountFlagBits::e1);
+		imageCreateInfo.setTiling(vk::ImageTiling::eOptimal);
+		imageCreateInfo.setUsage(usage);
+		imageCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+		imageCreateInfo.setInitialLayout(vk::ImageLayout::eUndefined);
+
+		vk::Image image = device.createImage(imageCreateInfo, GetAllocationCallbacks(vk::ObjectType::eImage));
+		SetObjectName(device, image, m_Resources[transients[index]].name.c_str());
+		m_Transients.images.push_back(image);
+
+		requirements[index] = device.getImageMemoryRequirements(image);
+
+		memoryTypes[index] = UINT32_MAX;
+		if (attachmentOnly)
+		{
+			memoryTypes[index] = capabilities.FindMemoryType(requirements[index].memoryTypeBits, 
+															 vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated);
+		}
+
+		if (memoryTypes[index] == UINT32_MAX)
+			memoryTypes[index] = m_Renderer->FindMemoryType(requirements[index].memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+		else
+			m_Transients.stats.lazilyAllocatedCount++;
+
+		m_Transients.stats.unaliasedBytes += requirements[index].size;
+	}
+
+	// Biggest images first, each goes into the first block of the same memory type that none of the
+	// images already in it overlaps with. Everything is bound at offset 0 of its block
+	struct MemoryBlock
+	{
+		uint32 memoryType;
+		vk::DeviceSize size;
+		std::vector<uint32> images;
+	};
+
+	std::vector<uint32> order(transients.size());
+	for (uint32 index = 0; index < order.size(); index++)
+		order[index] = index;
+
+	std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return requirements[a].size > requirements[b].size; });
+
+	std::vector<MemoryBlock> blocks;
+	for (uint32 image : order)
+	{
+		MemoryBlock* target = nullptr;
+		for (MemoryBlock& block : blocks)
+		{
+			if (!m_AliasingEnabled || block.memoryType != memoryTypes[image])
+				continue;
+
+			bool overlaps = false;
+			for (uint32 other : block.images)
+			{
+				if (lifetimes[image].first <= lifetimes[other].second && lifetimes[other].first <= lifetimes[image].second)
+					overlaps = true;
+			}
+
+			if (!overlaps)
+			{
+				target = &block;
+				break;
+			}
+		}
+
+		if (!target)
+		{
+			blocks.push_back({ memoryTypes[image], 0, {} });
+			target = &blocks.back();
+		}
+
+		target->size = std::max(target->size, requirements[image].size);
+		target->images.push_back(image);
+	}
+
+	for (const MemoryBlock& block : blocks)
+	{
+		vk::DeviceMemory memory = m_Renderer->GetMemoryBudget()->Allocate(vk::MemoryAllocateInfo(block.size, block.memoryType), MemoryCategory::Image);
+		m_Transients.memory.push_back(memory);
+		m_Transients.stats.aliasedBytes += block.size;
+
+		for (uint32 image : block.images)
+			device.bindImageMemory(m_Transients.images[image], memory, 0);
+	}
+
+	for (uint32 index = 0; index < transients.size(); index++)
+	{
+		const TransientImageDesc& desc = m_Resources[transients[index]].desc;
+
+		vk::ImageViewCreateInfo viewCreateInfo = {};
+		viewCreateInfo.setImage(m_Transients.images[index]);
+		viewCreateInfo.setViewType(vk::ImageViewType::e2D);
+		viewCreateInfo.setFormat(desc.format);
+		viewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange(desc.aspect, 0, 1, 0, 1));
+
+		vk::ImageView view = device.createImageView(viewCreateInfo, GetAllocationCallbacks(vk::ObjectType::eImageView));
+		SetObjectName(device, view, m_Resources[transients[index]].name.c_str());
+		m_Transients.views.push_back(view);
+	}
+
+	m_Transients.stats.imageCount = (uint32)transients.size();
+	m_Transients.stats.allocationCount = (uint32)blocks.size();
+}
+
+void RenderGraph::DestroyTransientSet(TransientSet& set)
+{
+	vk::Device device = m_Renderer->GetDevice();
+
+	// Passes build their framebuffers from the transient views
+	m_Renderer->GetFramebufferCache()->EvictImageViews(set.views);
+
+	for (vk::ImageView view : set.views)
+		device.destroyImageView(view, GetAllocationCallbacks(vk::ObjectType::eImageView));
+
+	for (vk::Image image : set.images)
+		device.destroyImage(image, GetAllocationCallbacks(vk::ObjectType::eImage));
+
+	for (vk::DeviceMemory memory : set.memory)
+		m_Renderer->GetMemoryBudget()->Free(memory);
+
+	set.views.clear();
+	set.images.clear();
+	set.memory.clear();
+}
+
+void RenderGraph::BuildBarriers()
+{
+	FrameVector<ResourceState> states(m_Resources.size());
+	FrameVector<bool> lastWasWrite(m_Resources.size(), false);
+	FrameVector<int32> lastPass(m_Resources.size(), -1);
+
+	for (uint32 index = 0; index < m_Resources.size(); index++)
+		states[index] = m_Resources[index].initialState;
+
+	// One barrier in front of each pass per resource, waiting for everything the pass does with it
+	auto transition = [&](RenderGraphResource resource, const ResourceState& next, bool write, uint32 queueFamily, FrameVector<Barrier>& barriers) -> void
+	{
+		ResourceState& current = states[resource];
+
+		ResourceState target = next;
+		if (current.queueFamily != VK_QUEUE_FAMILY_IGNORED)
+			target.queueFamily = queueFamily;
+
+		bool layoutChange = m_Resources[resource].isImage && current.layout != target.layout;
+		bool ownershipChange = current.queueFamily != target.queueFamily;
+
+		if (ownershipChange && lastPass[resource] >= 0)
+		{
+			// Released by the queue that used it last, acquired again in front of this pass
+			m_Passes[lastPass[resource]].releaseBarriers.push_back({ resource, current, target });
+			barriers.push_back({ resource, current, target });
+		}
+		else if (lastWasWrite[resource] || write || layoutChange || ownershipChange)
+		{
+			barriers.push_back({ resource, current, target });
+		}
+		else
+		{
+			// Read after read, merge so the next writer waits for all of the readers
+			current.stages |= target.stages;
+			current.access |= target.access;
+			return;
+		}
+
+		current = target;
+		lastWasWrite[resource] = write;
+	};
+
+	auto getState = [&](RenderGraphResource resource, ResourceUsage usage) -> ResourceState
+	{
+		ResourceState state = GetUsageState(usage);
+		if (!m_Resources[resource].isImage)
+			state.layout = vk::ImageLayout::eUndefined;
+
+		return state;
+	};
+
+	// What each pass does with a resource, all of its usages together. Cleared again by each pass for
+	// the resources it touched
+	FrameVector<ResourceState> passStates(m_Resources.size());
+	FrameVector<vk::ImageLayout> passLastLayouts(m_Resources.size(), vk::ImageLayout::eUndefined);
+	FrameVector<bool> passWrites(m_Resources.size(), false);
+	FrameVector<bool> seen(m_Resources.size(), false);
+
+	for (uint32 passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+	{
+		Pass& pass = m_Passes[passIndex];
+		if (pass.culled)
+			continue;
+
+		// The first usage decides the layout in front of the pass, the last one the layout it's left in
+		for (const Access& access : pass.accesses)
+		{
+			ResourceState state = getState(access.resource, access.usage);
+			if (!seen[access.resource])
+			{
+				seen[access.resource] = true;
+				passStates[access.resource] = state;
+				passWrites[access.resource] = access.write;
+			}
+			else
+			{
+				passStates[access.resource].stages |= state.stages;
+				passStates[access.resource].access |= state.access;
+				passWrites[access.resource] = passWrites[access.resource] || access.write;
+			}
+
+			passLastLayouts[access.resource] = state.layout;
+		}
+
+		for (const Access& access : pass.accesses)
+		{
+			if (!seen[access.resource])
+				continue;
+
+			seen[access.resource] = false;
+			transition(access.resource, passStates[access.resource], passWrites[access.resource], pass.queueFamily, pass.barriers);
+			lastPass[access.resource] = passIndex;
+
+			states[access.resource].layout = passLastLayouts[access.resource];
+		}
+
+		m_FinalQueueFamily = pass.queueFamily;
+	}
+
+	for (uint32 index = 0; index < m_Resources.size(); index++)
+	{
+		if (m_Resources[index].isOutput && lastPass[index] >= 0)
+			transition(index, getState(index, m_Resources[index].outputUsage), false, m_FinalQueueFamily, m_FinalBarriers);
+	}
+}
+
+void RenderGraph::Compile()
+{
+	assert(!m_Compiled);
+
+	CullPasses();
+	AllocateTransients();
+	BuildBarriers();
+
+	m_Compiled = true;
+}
+
+void RenderGraph::RecordBarriers(vk::CommandBuffer commandBuffer, uint32 queueFamily, const FrameVector<Barrier>& barriers)
+{
+	if (barriers.empty())
+		return;
+
+	vk::PipelineStageFlags srcStages;
+	vk::PipelineStageFlags dstStages;
+
+	FrameVector<vk::ImageMemoryBarrier> imageBarriers;
+	FrameVector<vk::BufferMemoryBarrier> bufferBarriers;
+
+	for (const Barrier& barrier : barriers)
+	{
+		const Resource& resource = m_Resources[barrier.resource];
+
+		ResourceState srcState = barrier.srcState;
+		ResourceState dstState = barrier.dstState;
+
+		uint32 srcQueue = VK_QUEUE_FAMILY_IGNORED;
+		uint32 dstQueue = VK_QUEUE_FAMILY_IGNORED;
+		if (srcState.queueFamily != dstState.queueFamily)
+		{
+			srcQueue = srcState.queueFamily;
+			dstQueue = dstState.queueFamily;
+
+			// The same barrier is recorded on both queues, the release half flushes the writes and
+			// the acquire half only makes them visible once the semaphore has been waited on
+			if (queueFamily == dstQueue)
+			{
+				srcState.stages = vk::PipelineStageFlags();
+				srcState.access = vk::AccessFlags();
+			}
+			else
+			{
+				dstState.stages = vk::PipelineStageFlags();
+				dstState.access = vk::AccessFlags();
+			}
+		}
+
+		srcStages |= srcState.stages;
+		dstStages |= dstState.stages;
+
+		if (resource.isImage)
+		{
+			vk::ImageSubresourceRange range(resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS);
+			imageBarriers.push_back(vk::ImageMemoryBarrier(srcState.access, dstState.access, srcState.layout, dstState.layout, 
+														   srcQueue, dstQueue, resource.image, range));
+		}
+		else
+		{
+			bufferBarriers.push_back(vk::BufferMemoryBarrier(srcState.access, dstState.access, srcQueue, dstQueue, 
+															 resource.buffer, 0, VK_WHOLE_SIZE));
+		}
+	}
+
+	// Empty stage masks aren't allowed, nothing to wait for on one side means top or bottom of pipe
+	if (!srcStages)
+		srcStages = vk::PipelineStageFlagBits::eTopOfPipe;
+	if (!dstStages)
+		dstStages = vk::PipelineStageFlagBits::eBottomOfPipe;
+
+	commandBuffer.pipelineBarrier(srcStages, dstStages, vk::DependencyFlags(), nullptr, bufferBarriers, imageBarriers, GetDispatch());
+}
+
+void RenderGraph::Execute(vk::CommandBuffer commandBuffer, uint32 queueFamily)
+{
+	assert(m_Compiled);
+
+	for (const Pass& pass : m_Passes)
+	{
+		if (pass.culled || pass.queueFamily != queueFamily)
+			continue;
+
+		// The pass's own transitions count towards its time
+		ProfileScope scope(m_Renderer->GetProfiler(), commandBuffer, pass.name.c_str());
+
+		RecordBarriers(commandBuffer, queueFamily, pass.barriers);
+		pass.execute(commandBuffer);
+		RecordBarriers(commandBuffer, queueFamily, pass.releaseBarriers);
+	}
+
+	if (queueFamily == m_FinalQueueFamily)
+		RecordBarriers(commandBuffer, queueFamily, m_FinalBarriers);
+}
+
+uint32 RenderGraph::GetCulledPassCount() const
+{
+	uint32 count = 0;
+	for (const Pass& pass : m_Passes)
+	{
+		if (pass.culled)
+			count++;
+	}
+
+	return count;
+}
+
+bool RenderGraph::GetPassBarrier(uint32 passIndex, RenderGraphResource resource, ResourceState& srcState, ResourceState& dstState) const
+{
+	assert(m_Compiled && passIndex < m_Passes.size());
+
+	for (const Barrier& barrier : m_Passes[passIndex].barriers)
+	{
+		if (barrier.resource == resource)
+		{
+			srcState = barrier.srcState;
+			dstState = barrier.dstState;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint32 RenderGraph::GetBarrierCount() const
+{
+	uint32 count = (uint32)m_FinalBarriers.size();
+	for (const Pass& pass : m_Passes)
+		count += (uint32)(pass.barriers.size() + pass.releaseBarriers.size());
+
+	return count;
+}
\ No newline at end of file
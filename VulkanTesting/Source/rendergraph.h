@@ -0,0 +1,237 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <utility>
+
+#include "types.h"
+#include "framealloc.h"
+
+class Renderer;
+
+typedef uint32 RenderGraphResource;
+
+enum class ResourceUsage
+{
+	// Images
+	ColorAttachment,
+	DepthAttachment,
+	DepthAttachmentRead,
+	FragmentShaderRead,
+	ComputeShaderRead,
+	ComputeShaderWrite,
+	Present,
+
+	// Buffers
+	IndirectRead,
+	VertexRead,
+	IndexRead,
+	UniformRead,
+	ComputeBufferRead,
+	ComputeBufferWrite,
+	HostRead,
+
+	// Both
+	TransferRead,
+	TransferWrite,
+};
+
+// Where in the pipeline and how a resource was last touched
+struct ResourceState
+{
+	vk::PipelineStageFlags stages;
+	vk::AccessFlags access;
+	vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+
+	// VK_QUEUE_FAMILY_IGNORED for resources that don't need ownership transfers (concurrent sharing)
+	uint32 queueFamily = VK_QUEUE_FAMILY_IGNORED;
+};
+
+// Render targets owned by the graph, they only live between the first and last pass using them
+struct TransientImageDesc
+{
+	vk::Format format;
+	vk::Extent2D extent;
+	vk::ImageUsageFlags usage;
+	vk::ImageAspectFlags aspect;
+};
+
+struct TransientMemoryStats
+{
+	uint32 imageCount;
+	uint32 allocationCount;
+	uint32 lazilyAllocatedCount;
+
+	// What the transient images would take with their own allocations, and what they take now
+	vk::DeviceSize unaliasedBytes;
+	vk::DeviceSize aliasedBytes;
+};
+
+ResourceState GetUsageState(ResourceUsage usage);
+bool IsWriteUsage(ResourceUsage usage);
+
+class RenderGraph;
+
+class RenderPassBuilder
+{
+private:
+	RenderGraph* m_Graph;
+	uint32 m_PassIndex;
+public:
+	RenderPassBuilder(RenderGraph* graph, uint32 passIndex);
+
+	// Declaring the same resource more than once is fine, the barrier in front of the pass covers all
+	// of the usages together. The first usage decides the layout the pass gets the resource in and the
+	// last one the layout it is left in, transitions between them are up to the pass
+	RenderPassBuilder& Read(RenderGraphResource resource, ResourceUsage usage);
+	RenderPassBuilder& Write(RenderGraphResource resource, ResourceUsage usage);
+
+	// Keeps the pass alive even when nothing reads what it writes
+	RenderPassBuilder& SetSideEffects();
+};
+
+// A frame graph, passes declare what they read and write and the graph works out the pipeline
+// barriers, image layout transitions and queue family ownership transfers between them. Passes that
+// don't contribute to an output are culled. The graph is rebuilt every frame: Reset, import the
+// resources, add passes, Compile, then Execute once per queue family that has passes. Everything
+// the passes declare lives in the renderer's frame allocator, so it's only valid for that frame
+class RenderGraph
+{
+private:
+	friend class RenderPassBuilder;
+
+	struct Resource
+	{
+		String name;
+
+		bool isImage;
+		vk::Image image;
+		vk::ImageView view;
+		vk::ImageAspectFlags aspect;
+		vk::Buffer buffer;
+
+		bool transient;
+		TransientImageDesc desc;
+
+		ResourceState initialState;
+
+		bool isOutput;
+		ResourceUsage outputUsage;
+	};
+
+	struct Access
+	{
+		RenderGraphResource resource;
+		ResourceUsage usage;
+		bool write;
+	};
+
+	struct Barrier
+	{
+		RenderGraphResource resource;
+		ResourceState srcState;
+		ResourceState dstState;
+	};
+
+	struct Pass
+	{
+		String name;
+		uint32 queueFamily;
+		bool sideEffects;
+		bool culled;
+
+		FrameVector<Access> accesses;
+		FrameFunction<void(vk::CommandBuffer)> execute;
+
+		// Recorded before the pass runs, and after it for ownership releases to another queue
+		FrameVector<Barrier> barriers;
+		FrameVector<Barrier> releaseBarriers;
+	};
+
+	// Images and memory backing the transient resources, kept as long as the graph layout stays the same
+	struct TransientSet
+	{
+		uint64 key;
+		std::vector<vk::Image> images;
+		std::vector<vk::ImageView> views;
+		std::vector<vk::DeviceMemory> memory;
+
+		TransientMemoryStats stats;
+		uint32 framesUntilDestroy;
+	};
+
+	Renderer* m_Renderer;
+
+	std::vector<Resource> m_Resources;
+	std::vector<Pass> m_Passes;
+
+	// Transitions of the outputs into their final usage, recorded after the last pass
+	FrameVector<Barrier> m_FinalBarriers;
+	uint32 m_FinalQueueFamily;
+
+	bool m_Compiled;
+
+	bool m_AliasingEnabled;
+	TransientSet m_Transients;
+	std::vector<TransientSet> m_RetiredTransients;
+private:
+	RenderGraphResource AddResource(const String& name, const ResourceState& initialState);
+
+	void CullPasses();
+	void AllocateTransients();
+	void CreateTransientSet(const FrameVector<RenderGraphResource>& transients, const FrameVector<std::pair<uint32, uint32>>& lifetimes);
+	void DestroyTransientSet(TransientSet& set);
+	void BuildBarriers();
+
+	void RecordBarriers(vk::CommandBuffer commandBuffer, uint32 queueFamily, const FrameVector<Barrier>& barriers);
+
+	uint32 PushPass(const String& name, uint32 queueFamily, const FrameFunction<void(vk::CommandBuffer)>& execute);
+public:
+	RenderGraph(Renderer* renderer);
+	~RenderGraph();
+
+	void Reset();
+
+	// Resources start out in the given state. Set its queue family to have ownership transfers tracked,
+	// leave it ignored for concurrent resources
+	RenderGraphResource ImportImage(const String& name, vk::Image image, vk::ImageAspectFlags aspect, const ResourceState& initialState);
+	RenderGraphResource ImportBuffer(const String& name, vk::Buffer buffer, const ResourceState& initialState);
+
+	// Allocated on Compile, transient images whose passes don't overlap share memory. The image and
+	// view can be queried from the pass execute callbacks
+	RenderGraphResource CreateImage(const String& name, const TransientImageDesc& desc);
+
+	vk::Image GetImage(RenderGraphResource resource) const;
+	vk::ImageView GetImageView(RenderGraphResource resource) const;
+
+	// Outputs are what keeps passes alive, the image or buffer is transitioned to the usage at the end
+	void MarkOutput(RenderGraphResource resource, ResourceUsage finalUsage);
+
+	// Setup is called right away with a RenderPassBuilder. Execute is copied into frame memory and
+	// called from Execute, so it must only capture references or trivially destructible values
+	template<typename Setup, typename Execute>
+	void AddPass(const String& name, uint32 queueFamily, Setup&& setup, Execute&& execute)
+	{
+		uint32 passIndex = PushPass(name, queueFamily, FrameFunction<void(vk::CommandBuffer)>(std::forward<Execute>(execute)));
+
+		RenderPassBuilder builder(this, passIndex);
+		setup(builder);
+	}
+
+	void Compile();
+
+	// Records the alive passes of one queue family in order. Passes on different queues need to be
+	// submitted with semaphores between them, the graph only records the ownership barriers
+	void Execute(vk::CommandBuffer commandBuffer, uint32 queueFamily);
+
+	uint32 GetPassCount() const { return (uint32)m_Passes.size(); }
+	uint32 GetCulledPassCount() const;
+	uint32 GetBarrierCount() const;
+
+	// The barrier recorded in front of a pass for a resource, false when the pass doesn't wait on it
+	bool GetPassBarrier(uint32 passIndex, RenderGraphResource resource, ResourceState& srcState, ResourceState& dstState) const;
+
+	// Changing this reallocates the transient images on the next Compile
+	void SetAliasingEnabled(bool enabled) { m_AliasingEnabled = enabled; }
+	const TransientMemoryStats& GetTransientMemoryStats() const { return m_Transients.stats; }
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "renderpass.h"
+
+#include "hash.h"
+#include "hostallocator.h"
+
+#include <algorithm>
+#include <assert.h>
+
+bool AttachmentDesc::operator==(const AttachmentDesc& other) const
+{
+	return format == other.format && loadOp == other.loadOp && storeOp == other.storeOp && 
+		   initialLayout == other.initialLayout && finalLayout == other.finalLayout;
+}
+
+static uint64 HashAttachment(const AttachmentDesc& attachment, uint64 hash)
+{
+	hash = HashValue((uint32)attachment.format, hash);
+	hash = HashValue((uint32)attachment.loadOp, hash);
+	hash = HashValue((uint32)attachment.storeOp, hash);
+	hash = HashValue((uint32)attachment.initialLayout, hash);
+	hash = HashValue((uint32)attachment.finalLayout, hash);
+
+	return hash;
+}
+
+static vk::AttachmentDescription GetAttachmentDescription(const AttachmentDesc& attachment)
+{
+	vk::AttachmentDescription result = {};
+	result.setFormat(attachment.format);
+	result.setSamples(vk::SampleCountFlagBits::e1);
+
+	result.setLoadOp(attachment.loadOp);
+	result.setStoreOp(attachment.storeOp);
+
+	result.setStencilLoadOp(vk::AttachmentLoadOp::eDontCare);
+	result.setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
+
+	result.setInitialLayout(attachment.initialLayout);
+	result.setFinalLayout(attachment.finalLayout);
+
+	return result;
+}
+
+bool RenderPassKey::operator==(const RenderPassKey& other) const
+{
+	return colorAttachments == other.colorAttachments && depthAttachment == other.depthAttachment;
+}
+
+uint64 RenderPassKey::Hash() const
+{
+	uint64 hash = HASH_SEED;
+	for (const AttachmentDesc& attachment : colorAttachments)
+		hash = HashAttachment(attachment, hash);
+
+	return HashAttachment(depthAttachment, hash);
+}
+
+bool FramebufferKey::operator==(const FramebufferKey& other) const
+{
+	return renderPass == other.renderPass && attachmentCount == other.attachmentCount && extent == other.extent &&
+		   std::equal(attachments, attachments + attachmentCount, other.attachments);
+}
+
+uint64 FramebufferKey::Hash() const
+{
+	uint64 hash = HashValue((VkRenderPass)renderPass);
+	for (uint32 index = 0; index < attachmentCount; index++)
+		hash = HashValue((VkImageView)attachments[index], hash);
+
+	hash = HashValue(extent.width, hash);
+	return HashValue(extent.height, hash);
+}
+
+vk::RenderPass CreateRenderPass(vk::Device device, const RenderPassKey& key)
+{
+	std::vector<vk::AttachmentDescription> attachments;
+	std::vector<vk::AttachmentReference> colorAttachmentRefs;
+
+	for (const AttachmentDesc& attachment : key.colorAttachments)
+	{
+		colorAttachmentRefs.push_back(vk::AttachmentReference((uint32)attachments.size(), vk::ImageLayout::eColorAttachmentOptimal));
+		attachments.push_back(GetAttachmentDescription(attachment));
+	}
+
+	vk::AttachmentReference depthAttachmentRef((uint32)attachments.size(), vk::ImageLayout::eDepthStencilAttachmentOptimal);
+	bool hasDepth = key.depthAttachment.format != vk::Format::eUndefined;
+	if (hasDepth)
+		attachments.push_back(GetAttachmentDescription(key.depthAttachment));
+
+	vk::SubpassDescription subpass = {};
+	subpass.setPipelineBindPoint(vk::PipelineBindPoint::eGraphics);
+	subpass.setColorAttachmentCount((uint32)colorAttachmentRefs.size());
+	subpass.setPColorAttachments(colorAttachmentRefs.data());
+	subpass.setPDepthStencilAttachment(hasDepth ? &depthAttachmentRef : nullptr);
+
+	vk::RenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.setAttachmentCount((uint32)attachments.size());
+	renderPassCreateInfo.setPAttachments(attachments.data());
+	renderPassCreateInfo.setSubpassCount(1);
+	renderPassCreateInfo.setPSubpasses(&subpass);
+
+	vk::RenderPass result = device.createRenderPass(renderPassCreateInfo, GetAllocationCallbacks(vk::ObjectType::eRenderPass));
+
+	return result;
+}
+
+RenderPassCache::RenderPassCache(vk::Device device)
+	: m_Device(device)
+{
+}
+
+RenderPassCache::~RenderPassCache()
+{
+	for (auto& entry : m_RenderPasses)
+		m_Device.destroyRenderPass(entry.second, GetAllocationCallbacks(vk::ObjectType::eRenderPass));
+}
+
+vk::RenderPass RenderPassCache::GetRenderPass(const RenderPassKey& key)
+{
+	auto it = m_RenderPasses.find(key);
+	if (it != m_RenderPasses.end())
+		return it->second;
+
+	vk::RenderPass renderPass = CreateRenderPass(m_Device, key);
+
+	m_RenderPasses[key] = renderPass;
+	return renderPass;
+}
+
+vk::RenderPass RenderPassCache::GetRenderPass(vk::Format colorFormat, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout)
+{
+	AttachmentDesc colorAttachment;
+	colorAttachment.format = colorFormat;
+	colorAttachment.initialLayout = initialLayout;
+	colorAttachment.finalLayout = finalLayout;
+
+	RenderPassKey key;
+	key.colorAttachments.push_back(colorAttachment);
+
+	return GetRenderPass(key);
+}
+
+FramebufferCache::FramebufferCache(vk::Device device)
+	: m_Device(device)
+{
+}
+
+FramebufferCache::~FramebufferCache()
+{
+	for (auto& entry : m_Framebuffers)
+		m_Device.destroyFramebuffer(entry.second, GetAllocationCallbacks(vk::ObjectType::eFramebuffer));
+}
+
+vk::Framebuffer FramebufferCache::GetFramebuffer(const FramebufferKey& key)
+{
+	auto it = m_Framebuffers.find(key);
+	if (it != m_Framebuffers.end())
+		return it->second;
+
+	vk::FramebufferCreateInfo framebufferCreateInfo = {};
+	framebufferCreateInfo.setRenderPass(key.renderPass);
+	framebufferCreateInfo.setAttachmentCount(key.attachmentCount);
+	framebufferCreateInfo.setPAttachments(key.attachments);
+	framebufferCreateInfo.setWidth(key.extent.width);
+	framebufferCreateInfo.setHeight(key.extent.height);
+	framebufferCreateInfo.setLayers(1);
+
+	vk::Framebuffer framebuffer = m_Device.createFramebuffer(framebufferCreateInfo, GetAllocationCallbacks(vk::ObjectType::eFramebuffer));
+
+	m_Framebuffers[key] = framebuffer;
+	return framebuffer;
+}
+
+vk::Framebuffer FramebufferCache::GetFramebuffer(vk::RenderPass renderPass, vk::ArrayProxy<const vk::ImageView> attachments, vk::Extent2D extent)
+{
+	assert(attachments.size() <= MAX_FRAMEBUFFER_ATTACHMENTS);
+
+	FramebufferKey key = {};
+	key.renderPass = renderPass;
+	key.attachmentCount = attachments.size();
+	std::copy(attachments.begin(), attachments.end(), key.attachments);
+	key.extent = extent;
+
+	return GetFramebuffer(key);
+}
+
+void FramebufferCache::EvictImageViews(const std::vector<vk::ImageView>& imageViews)
+{
+	for (auto it = m_Framebuffers.begin(); it != m_Framebuffers.end();)
+	{
+		const FramebufferKey& key = it->first;
+
+		const vk::ImageView* attachmentsEnd = key.attachments + key.attachmentCount;
+		bool stale = std::find_first_of(key.attachments, attachmentsEnd, imageViews.begin(), imageViews.end()) != attachmentsEnd;
+		if (stale)
+		{
+			m_Device.destroyFramebuffer(it->second, GetAllocationCallbacks(vk::ObjectType::eFramebuffer));
+			it = m_Framebuffers.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
\ No newline at end of file
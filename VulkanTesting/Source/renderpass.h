@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <unordered_map>
+
+#include "types.h"
+
+struct AttachmentDesc
+{
+	vk::Format format = vk::Format::eUndefined;
+	vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eClear;
+	vk::AttachmentStoreOp storeOp = vk::AttachmentStoreOp::eStore;
+
+	vk::ImageLayout initialLayout = vk::ImageLayout::eUndefined;
+	vk::ImageLayout finalLayout = vk::ImageLayout::ePresentSrcKHR;
+
+	bool operator==(const AttachmentDesc& other) const;
+};
+
+// Describes a render pass with a single subpass writing every attachment
+struct RenderPassKey
+{
+	std::vector<AttachmentDesc> colorAttachments;
+
+	// Left at eUndefined format for passes without depth
+	AttachmentDesc depthAttachment;
+
+	bool operator==(const RenderPassKey& other) const;
+	uint64 Hash() const;
+};
+
+struct RenderPassKeyHasher
+{
+	size_t operator()(const RenderPassKey& key) const { return (size_t)key.Hash(); }
+};
+
+const uint32 MAX_FRAMEBUFFER_ATTACHMENTS = 8;
+
+struct FramebufferKey
+{
+	vk::RenderPass renderPass;
+	vk::ImageView attachments[MAX_FRAMEBUFFER_ATTACHMENTS];
+	uint32 attachmentCount;
+	vk::Extent2D extent;
+
+	bool operator==(const FramebufferKey& other) const;
+	uint64 Hash() const;
+};
+
+struct FramebufferKeyHasher
+{
+	size_t operator()(const FramebufferKey& key) const { return (size_t)key.Hash(); }
+};
+
+vk::RenderPass CreateRenderPass(vk::Device device, const RenderPassKey& key);
+
+// Owns every render pass, identical attachment descriptions return the same pass
+class RenderPassCache
+{
+private:
+	vk::Device m_Device;
+	std::unordered_map<RenderPassKey, vk::RenderPass, RenderPassKeyHasher> m_RenderPasses;
+public:
+	RenderPassCache(vk::Device device);
+	~RenderPassCache();
+
+	vk::RenderPass GetRenderPass(const RenderPassKey& key);
+
+	// Shorthand for the common single color attachment pass
+	vk::RenderPass GetRenderPass(vk::Format colorFormat, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout);
+
+	uint32 GetRenderPassCount() const { return (uint32)m_RenderPasses.size(); }
+};
+
+// Owns every framebuffer. Entries hold on to the image views they were made from, so whoever
+// destroys views (the swapchain on recreate) has to evict them first
+class FramebufferCache
+{
+private:
+	vk::Device m_Device;
+	std::unordered_map<FramebufferKey, vk::Framebuffer, FramebufferKeyHasher> m_Framebuffers;
+public:
+	FramebufferCache(vk::Device device);
+	~FramebufferCache();
+
+	vk::Framebuffer GetFramebuffer(const FramebufferKey& key);
+	vk::Framebuffer GetFramebuffer(vk::RenderPass renderPass, vk::ArrayProxy<const vk::ImageView> attachments, vk::Extent2D extent);
+
+	// Destroys every framebuffer using one of the views, the GPU must be done with them
+	void EvictImageViews(const std::vector<vk::ImageView>& imageViews);
+
+	uint32 GetFramebufferCount() const { return (uint32)m_Framebuffers.size(); }
+};
\ No newline at end of file
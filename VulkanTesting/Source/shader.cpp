@@ -0,0 +1,139 @@
+#include "shader.h"
+
+#include "hostallocator.h"
+
+#include <assert.h>
+#include <iostream>
+
+vk::ShaderModule CreateShader(vk::Device device, BufferInfo buffer)
+{
+	vk::ShaderModule result = device.createShaderModule(vk::ShaderModuleCreateInfo(vk::ShaderModuleCreateFlags(), buffer.size, (uint32*)buffer.buffer), GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+
+	return result;
+}
+
+vk::ShaderModule CreateShader(vk::Device device, const std::vector<uint32>& code)
+{
+	vk::ShaderModule result = device.createShaderModule(vk::ShaderModuleCreateInfo(vk::ShaderModuleCreateFlags(), code.size() * sizeof(uint32), code.data()), GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+
+	return result;
+}
+
+ShaderCompileOptions ShaderCompileOptions::Debug()
+{
+	ShaderCompileOptions result;
+	result.optimization = ShaderOptimization::None;
+	result.stripDebugInfo = false;
+
+	return result;
+}
+
+ShaderCompileOptions ShaderCompileOptions::Release(ShaderOptimization optimization)
+{
+	ShaderCompileOptions result;
+	result.optimization = optimization;
+	result.stripDebugInfo = true;
+
+	return result;
+}
+
+ShaderCompileOptions ShaderCompileOptions::Default()
+{
+#ifdef NDEBUG
+	return Release();
+#else
+	return Debug();
+#endif
+}
+
+std::vector<uint32> CompileShaderToSpirv(const String& filename, shaderc_shader_kind kind, const ShaderCompileOptions& compileOptions)
+{
+	shaderc::Compiler compiler;
+	shaderc::CompileOptions options;
+
+	for (const std::pair<String, String>& define : compileOptions.defines)
+		options.AddMacroDefinition(define.first, define.second);
+
+	switch (compileOptions.optimization)
+	{
+	case ShaderOptimization::None:
+		options.SetOptimizationLevel(shaderc_optimization_level_zero);
+		break;
+	case ShaderOptimization::Performance:
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		break;
+	case ShaderOptimization::Size:
+		options.SetOptimizationLevel(shaderc_optimization_level_size);
+		break;
+	}
+
+	if (!compileOptions.stripDebugInfo)
+		options.SetGenerateDebugInfo();
+
+	String source = ReadFileToString(filename);
+
+	shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, kind, filename.c_str(), options);
+	if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+	{
+		std::cerr << "Error: " << result.GetErrorMessage() << std::endl;
+		throw std::runtime_error("failed to compile shader!");
+	}
+
+	std::vector<uint32> code(result.cbegin(), result.cend());
+
+	// glslang emits names even without debug info, and the optimizer doesn't always remove them
+	if (compileOptions.stripDebugInfo)
+		StripSpirvDebugInfo(code);
+
+	return code;
+}
+
+void StripSpirvDebugInfo(std::vector<uint32>& code)
+{
+	const uint32 SPIRV_HEADER_WORDS = 5;
+
+	const uint16 OP_SOURCE_CONTINUED = 2;
+	const uint16 OP_SOURCE = 3;
+	const uint16 OP_SOURCE_EXTENSION = 4;
+	const uint16 OP_NAME = 5;
+	const uint16 OP_MEMBER_NAME = 6;
+	const uint16 OP_STRING = 7;
+	const uint16 OP_LINE = 8;
+	const uint16 OP_NO_LINE = 317;
+	const uint16 OP_MODULE_PROCESSED = 330;
+
+	assert(code.size() >= SPIRV_HEADER_WORDS);
+
+	uint32 writeIndex = SPIRV_HEADER_WORDS;
+	uint32 readIndex = SPIRV_HEADER_WORDS;
+	while (readIndex < code.size())
+	{
+		uint16 opcode = (uint16)(code[readIndex] & 0xFFFF);
+		uint16 wordCount = (uint16)(code[readIndex] >> 16);
+		assert(wordCount > 0 && readIndex + wordCount <= code.size());
+
+		bool debug = opcode == OP_SOURCE_CONTINUED || opcode == OP_SOURCE || opcode == OP_SOURCE_EXTENSION || 
+					 opcode == OP_NAME || opcode == OP_MEMBER_NAME || opcode == OP_STRING || 
+					 opcode == OP_LINE || opcode == OP_NO_LINE || opcode == OP_MODULE_PROCESSED;
+
+		if (!debug)
+		{
+			for (uint32 word = 0; word < wordCount; word++)
+				code[writeIndex + word] = code[readIndex + word];
+
+			writeIndex += wordCount;
+		}
+
+		readIndex += wordCount;
+	}
+
+	code.resize(writeIndex);
+}
+
+vk::ShaderModule CompileShader(vk::Device device, const String& filename, shaderc_shader_kind kind, const ShaderDefines& defines)
+{
+	ShaderCompileOptions options = ShaderCompileOptions::Default();
+	options.defines = defines;
+
+	return CreateShader(device, CompileShaderToSpirv(filename, kind, options));
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <shaderc/shaderc.hpp>
+
+#include "types.h"
+#include "file.h"
+
+// Macro name and value pairs, passed to the preprocessor as if #defined at the top of the file
+typedef std::vector<std::pair<String, String>> ShaderDefines;
+
+enum class ShaderOptimization
+{
+	None,
+	Performance,
+	Size,
+};
+
+struct ShaderCompileOptions
+{
+	ShaderOptimization optimization = ShaderOptimization::None;
+
+	// Drops names, source text and line info, nothing the driver needs
+	bool stripDebugInfo = false;
+
+	ShaderDefines defines;
+
+	// Debug keeps everything for RenderDoc and validation messages, release is optimized and stripped
+	static ShaderCompileOptions Debug();
+	static ShaderCompileOptions Release(ShaderOptimization optimization = ShaderOptimization::Performance);
+
+	// Release when NDEBUG is defined
+	static ShaderCompileOptions Default();
+};
+
+vk::ShaderModule CreateShader(vk::Device device, BufferInfo buffer);
+vk::ShaderModule CreateShader(vk::Device device, const std::vector<uint32>& code);
+
+std::vector<uint32> CompileShaderToSpirv(const String& filename, shaderc_shader_kind kind, const ShaderCompileOptions& options);
+
+// Removes the debug instructions (OpSource, OpName, OpLine and friends) from a SPIR-V module
+void StripSpirvDebugInfo(std::vector<uint32>& code);
+
+// Compiles a GLSL file from disk straight to a SPIR-V shader module with the default options
+vk::ShaderModule CompileShader(vk::Device device, const String& filename, shaderc_shader_kind kind, const ShaderDefines& defines = ShaderDefines());
\ No newline at end of file
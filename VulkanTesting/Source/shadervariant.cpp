@@ -0,0 +1,223 @@
+#include "shadervariant.h"
+
+#include "renderer.h"
+#include "shader.h"
+#include "hash.h"
+
+#include <string.h>
+#include <stdexcept>
+
+void ShaderVariantKey::SetConstant(uint32 constantId, uint32 value)
+{
+	assert(constantId < 32);
+
+	// The gaps stay 0 but out of the mask, so those constants keep the shader default
+	if (constants.size() <= constantId)
+		constants.resize(constantId + 1, 0);
+
+	constants[constantId] = value;
+	constantMask |= 1 << constantId;
+}
+
+void ShaderVariantKey::SetConstant(uint32 constantId, float value)
+{
+	uint32 bits;
+	memcpy(&bits, &value, sizeof(uint32));
+
+	SetConstant(constantId, bits);
+}
+
+bool ShaderVariantKey::operator==(const ShaderVariantKey& other) const
+{
+	return featureMask == other.featureMask && constantMask == other.constantMask && constants == other.constants;
+}
+
+uint64 ShaderVariantKey::Hash() const
+{
+	uint64 hash = HashValue(featureMask);
+	hash = HashValue(constantMask, hash);
+	for (uint32 constant : constants)
+		hash = HashValue(constant, hash);
+
+	return hash;
+}
+
+ShaderVariants::ShaderVariants(Renderer* renderer, const String& vertexFile, const String& fragmentFile, 
+							   const std::vector<String>& features, const GraphicsPipelineDesc& baseDesc)
+	: m_Renderer(renderer), m_VertexFile(vertexFile), m_FragmentFile(fragmentFile), m_Features(features), m_BaseDesc(baseDesc)
+{
+	assert(features.size() <= 32);
+}
+
+ShaderVariants::~ShaderVariants()
+{
+	// The pipelines belong to the pipeline state cache, only the modules are ours
+	vk::Device device = m_Renderer->GetDevice();
+
+	for (auto& entry : m_PendingModules)
+	{
+		m_Renderer->GetJobSystem()->Wait(&entry.second->counter);
+
+		device.destroyShaderModule(entry.second->modules.vertexShader, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+		device.destroyShaderModule(entry.second->modules.fragmentShader, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+	}
+
+	for (auto& entry : m_Modules)
+	{
+		device.destroyShaderModule(entry.second.vertexShader, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+		device.destroyShaderModule(entry.second.fragmentShader, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+	}
+}
+
+static ShaderDefines GetFeatureDefines(const std::vector<String>& features, uint32 featureMask)
+{
+	ShaderDefines defines;
+	for (uint32 index = 0; index < features.size(); index++)
+	{
+		if (featureMask & (1 << index))
+			defines.push_back({ features[index], "1" });
+	}
+
+	return defines;
+}
+
+bool ShaderVariants::TryFinishPending(uint32 featureMask, bool wait)
+{
+	auto it = m_PendingModules.find(featureMask);
+	if (it == m_PendingModules.end())
+		return false;
+
+	PendingModules* pending = it->second.get();
+	if (wait)
+		m_Renderer->GetJobSystem()->Wait(&pending->counter);
+	else if (!pending->counter.IsDone())
+		return false;
+
+	// Failed compiles stay pending so they aren't retried every frame, the destructor cleans them up
+	if (pending->failed)
+		return false;
+
+	m_Modules[featureMask] = pending->modules;
+	m_PendingModules.erase(it);
+
+	return true;
+}
+
+const ShaderVariants::ModulePair& ShaderVariants::GetModules(uint32 featureMask)
+{
+	auto it = m_Modules.find(featureMask);
+	if (it != m_Modules.end())
+		return it->second;
+
+	// Already compiling in the background, finishing that is cheaper than starting over
+	if (TryFinishPending(featureMask, true))
+		return m_Modules[featureMask];
+
+	if (m_PendingModules.find(featureMask) != m_PendingModules.end())
+		throw std::runtime_error("failed to compile shader variant!");
+
+	ShaderDefines defines = GetFeatureDefines(m_Features, featureMask);
+	vk::Device device = m_Renderer->GetDevice();
+
+	ModulePair modules = {};
+	modules.vertexShader = CompileShader(device, m_VertexFile, shaderc_shader_kind::shaderc_vertex_shader, defines);
+	modules.fragmentShader = CompileShader(device, m_FragmentFile, shaderc_shader_kind::shaderc_fragment_shader, defines);
+
+	m_Modules[featureMask] = modules;
+	return m_Modules[featureMask];
+}
+
+const ShaderVariants::ModulePair* ShaderVariants::GetModulesAsync(uint32 featureMask)
+{
+	auto it = m_Modules.find(featureMask);
+	if (it != m_Modules.end())
+		return &it->second;
+
+	if (TryFinishPending(featureMask, false))
+		return &m_Modules[featureMask];
+
+	if (m_PendingModules.find(featureMask) == m_PendingModules.end())
+	{
+		PendingModules* pending = new PendingModules();
+		pending->modules = {};
+		pending->failed = false;
+
+		m_PendingModules[featureMask] = std::unique_ptr<PendingModules>(pending);
+
+		// Every compile uses its own shaderc compiler, and creating shader modules is thread safe
+		ShaderDefines defines = GetFeatureDefines(m_Features, featureMask);
+		vk::Device device = m_Renderer->GetDevice();
+		String vertexFile = m_VertexFile;
+		String fragmentFile = m_FragmentFile;
+
+		m_Renderer->GetJobSystem()->Submit([pending, defines, device, vertexFile, fragmentFile]()
+		{
+			try
+			{
+				pending->modules.vertexShader = CompileShader(device, vertexFile, shaderc_shader_kind::shaderc_vertex_shader, defines);
+				pending->modules.fragmentShader = CompileShader(device, fragmentFile, shaderc_shader_kind::shaderc_fragment_shader, defines);
+			}
+			catch (const std::exception&)
+			{
+				// The compiler error has been printed already
+				pending->failed = true;
+			}
+		}, &pending->counter);
+	}
+
+	return nullptr;
+}
+
+GraphicsPipelineDesc ShaderVariants::GetPipelineDesc(const ShaderVariantKey& key, const ModulePair& modules) const
+{
+	GraphicsPipelineDesc desc = m_BaseDesc;
+	desc.vertexShader = modules.vertexShader;
+	desc.fragmentShader = modules.fragmentShader;
+	desc.specializationConstants = key.constants;
+	desc.specializationConstantMask = key.constantMask;
+
+	return desc;
+}
+
+GraphicsPipelineDesc ShaderVariants::GetPipelineDesc(const ShaderVariantKey& key)
+{
+	return GetPipelineDesc(key, GetModules(key.featureMask));
+}
+
+Pipeline ShaderVariants::GetPipeline(const ShaderVariantKey& key)
+{
+	auto it = m_Pipelines.find(key);
+	if (it != m_Pipelines.end())
+		return it->second;
+
+	Pipeline pipeline = m_Renderer->GetPipelineStateCache()->GetGraphicsPipeline(GetPipelineDesc(key));
+
+	m_Pipelines[key] = pipeline;
+	return pipeline;
+}
+
+Pipeline ShaderVariants::GetPipelineAsync(const ShaderVariantKey& key, const Pipeline& fallback)
+{
+	auto it = m_Pipelines.find(key);
+	if (it != m_Pipelines.end())
+		return it->second;
+
+	const ModulePair* modules = GetModulesAsync(key.featureMask);
+	if (!modules)
+		return fallback;
+
+	PipelineStateCache* pipelineCache = m_Renderer->GetPipelineStateCache();
+	GraphicsPipelineDesc desc = GetPipelineDesc(key, *modules);
+
+	// Only remember the real thing, and ask for it once it's known to be there. The compile can finish
+	// at any point, so whatever the async call returns might still be the fallback
+	if (pipelineCache->IsPipelineReady(desc))
+	{
+		Pipeline pipeline = pipelineCache->GetGraphicsPipeline(desc);
+
+		m_Pipelines[key] = pipeline;
+		return pipeline;
+	}
+
+	return pipelineCache->GetGraphicsPipelineAsync(desc, fallback);
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <unordered_map>
+
+#include "types.h"
+#include "pipeline.h"
+#include "jobsystem.h"
+
+class Renderer;
+
+// Picks one permutation of a shader pair. Feature bits change the code and each distinct mask is a
+// separate SPIR-V compile, constants only change values and are fed in as specialization constants
+struct ShaderVariantKey
+{
+	uint32 featureMask = 0;
+
+	// Indexed by constant id, a bit in the mask for each one that was set
+	std::vector<uint32> constants;
+	uint32 constantMask = 0;
+
+	void SetConstant(uint32 constantId, uint32 value);
+	void SetConstant(uint32 constantId, float value);
+
+	bool operator==(const ShaderVariantKey& other) const;
+	uint64 Hash() const;
+};
+
+struct ShaderVariantKeyHasher
+{
+	size_t operator()(const ShaderVariantKey& key) const { return (size_t)key.Hash(); }
+};
+
+// All variants of one vertex and fragment shader pair drawn with the same fixed function state.
+// Feature N is compiled in by defining features[N] to 1, modules are compiled once per mask and
+// pipelines come from the renderer's pipeline state cache
+class ShaderVariants
+{
+private:
+	struct ModulePair
+	{
+		vk::ShaderModule vertexShader;
+		vk::ShaderModule fragmentShader;
+	};
+
+	// Compiled on the job system, only touched by the job until the counter is done
+	struct PendingModules
+	{
+		ModulePair modules;
+		bool failed;
+		JobCounter counter;
+	};
+
+	Renderer* m_Renderer;
+
+	String m_VertexFile;
+	String m_FragmentFile;
+	std::vector<String> m_Features;
+
+	GraphicsPipelineDesc m_BaseDesc;
+
+	std::unordered_map<uint32, ModulePair> m_Modules;
+	std::unordered_map<uint32, std::unique_ptr<PendingModules>> m_PendingModules;
+	std::unordered_map<ShaderVariantKey, Pipeline, ShaderVariantKeyHasher> m_Pipelines;
+private:
+	const ModulePair& GetModules(uint32 featureMask);
+
+	// Null until the background compile of the mask is done, or when it failed
+	const ModulePair* GetModulesAsync(uint32 featureMask);
+	bool TryFinishPending(uint32 featureMask, bool wait);
+
+	GraphicsPipelineDesc GetPipelineDesc(const ShaderVariantKey& key, const ModulePair& modules) const;
+public:
+	// The shaders in baseDesc are ignored, everything else is shared by every variant
+	ShaderVariants(Renderer* renderer, const String& vertexFile, const String& fragmentFile, 
+				   const std::vector<String>& features, const GraphicsPipelineDesc& baseDesc);
+	~ShaderVariants();
+
+	GraphicsPipelineDesc GetPipelineDesc(const ShaderVariantKey& key);
+
+	Pipeline GetPipeline(const ShaderVariantKey& key);
+
+	// See PipelineStateCache::GetGraphicsPipelineAsync, the SPIR-V compile of a new feature mask
+	// runs on the job system too and the fallback is handed out until both are done
+	Pipeline GetPipelineAsync(const ShaderVariantKey& key, const Pipeline& fallback = Pipeline());
+
+	uint32 GetModuleCount() const { return (uint32)m_Modules.size() * 2; }
+	uint32 GetPipelineCount() const { return (uint32)m_Pipelines.size(); }
+};
\ No newline at end of file
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "types.h"
+
+// Thin 4-wide float abstraction, picks SSE on x86, NEON on ARM and plain floats everywhere else.
+// AVX2 is only used by the batch functions in mathlib.cpp where 8 lanes pay off
+#if defined(__ARM_NEON) || defined(_M_ARM) || defined(_M_ARM64)
+	#define SIMD_NEON 1
+	#include <arm_neon.h>
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_SSE 1
+	#include <xmmintrin.h>
+	#include <emmintrin.h>
+#else
+	#define SIMD_SCALAR 1
+#endif
+
+#if defined(SIMD_SSE) && defined(__AVX2__)
+	#define SIMD_AVX2 1
+	#include <immintrin.h>
+#endif
+
+#if defined(SIMD_SSE)
+typedef __m128 SimdFloat4;
+#elif defined(SIMD_NEON)
+typedef float32x4_t SimdFloat4;
+#else
+struct SimdFloat4
+{
+	float v[4];
+};
+#endif
+
+inline SimdFloat4 SimdLoad(const float* data)
+{
+#if defined(SIMD_SSE)
+	return _mm_load_ps(data);
+#elif defined(SIMD_NEON)
+	return vld1q_f32(data);
+#else
+	return { { data[0], data[1], data[2], data[3] } };
+#endif
+}
+
+inline SimdFloat4 SimdLoadUnaligned(const float* data)
+{
+#if defined(SIMD_SSE)
+	return _mm_loadu_ps(data);
+#else
+	return SimdLoad(data);
+#endif
+}
+
+inline void SimdStore(float* data, SimdFloat4 value)
+{
+#if defined(SIMD_SSE)
+	_mm_store_ps(data, value);
+#elif defined(SIMD_NEON)
+	vst1q_f32(data, value);
+#else
+	data[0] = value.v[0]; data[1] = value.v[1]; data[2] = value.v[2]; data[3] = value.v[3];
+#endif
+}
+
+inline void SimdStoreUnaligned(float* data, SimdFloat4 value)
+{
+#if defined(SIMD_SSE)
+	_mm_storeu_ps(data, value);
+#else
+	SimdStore(data, value);
+#endif
+}
+
+inline SimdFloat4 SimdSet(float x, float y, float z, float w)
+{
+#if defined(SIMD_SSE)
+	return _mm_set_ps(w, z, y, x);
+#elif defined(SIMD_NEON)
+	float data[4] = { x, y, z, w };
+	return vld1q_f32(data);
+#else
+	return { { x, y, z, w } };
+#endif
+}
+
+inline SimdFloat4 SimdSplat(float value)
+{
+#if defined(SIMD_SSE)
+	return _mm_set1_ps(value);
+#elif defined(SIMD_NEON)
+	return vdupq_n_f32(value);
+#else
+	return { { value, value, value, value } };
+#endif
+}
+
+inline SimdFloat4 SimdAdd(SimdFloat4 a, SimdFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_add_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vaddq_f32(a, b);
+#else
+	return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+}
+
+inline SimdFloat4 SimdSub(SimdFloat4 a, SimdFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_sub_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vsubq_f32(a, b);
+#else
+	return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+}
+
+inline SimdFloat4 SimdMul(SimdFloat4 a, SimdFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_mul_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vmulq_f32(a, b);
+#else
+	return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+}
+
+// a * b + c
+inline SimdFloat4 SimdMulAdd(SimdFloat4 a, SimdFloat4 b, SimdFloat4 c)
+{
+#if defined(SIMD_NEON)
+	return vmlaq_f32(c, a, b);
+#else
+	return SimdAdd(SimdMul(a, b), c);
+#endif
+}
+
+inline SimdFloat4 SimdMin(SimdFloat4 a, SimdFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return _mm_min_ps(a, b);
+#elif defined(SIMD_NEON)
+	return vminq_f32(a, b);
+#else
+	return { { a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], 
+			   a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3] } };
+#endif
+}
+
+// Returns a 4 bit mask with bit N set when lane N of a is greater or equal to b
+inline uint32 SimdGreaterEqualMask(SimdFloat4 a, SimdFloat4 b)
+{
+#if defined(SIMD_SSE)
+	return (uint32)_mm_movemask_ps(_mm_cmpge_ps(a, b));
+#elif defined(SIMD_NEON)
+	uint32x4_t compare = vcgeq_f32(a, b);
+	return (vgetq_lane_u32(compare, 0) & 1) | (vgetq_lane_u32(compare, 1) & 2) | 
+		   (vgetq_lane_u32(compare, 2) & 4) | (vgetq_lane_u32(compare, 3) & 8);
+#else
+	return (a.v[0] >= b.v[0] ? 1 : 0) | (a.v[1] >= b.v[1] ? 2 : 0) | 
+		   (a.v[2] >= b.v[2] ? 4 : 0) | (a.v[3] >= b.v[3] ? 8 : 0);
+#endif
+}
+
+inline float SimdGetX(SimdFloat4 value)
+{
+#if defined(SIMD_SSE)
+	return _mm_cvtss_f32(value);
+#elif defined(SIMD_NEON)
+	return vgetq_lane_f32(value, 0);
+#else
+	return value.v[0];
+#endif
+}
+
+// Sum of all four lanes broadcast to every lane
+inline SimdFloat4 SimdHorizontalAdd(SimdFloat4 value)
+{
+#if defined(SIMD_SSE)
+	__m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(value, shuffled);
+	shuffled = _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 0, 3, 2));
+	return _mm_add_ps(sums, shuffled);
+#elif defined(SIMD_NEON)
+	float32x2_t pairs = vadd_f32(vget_low_f32(value), vget_high_f32(value));
+	float32x2_t sum = vpadd_f32(pairs, pairs);
+	return vcombine_f32(sum, sum);
+#else
+	float sum = value.v[0] + value.v[1] + value.v[2] + value.v[3];
+	return { { sum, sum, sum, sum } };
+#endif
+}
\ No newline at end of file
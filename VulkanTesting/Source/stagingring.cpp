@@ -0,0 +1,79 @@
+#include "stagingring.h"
+
+#include "renderer.h"
+
+#include <string.h>
+
+StagingRing::StagingRing(Renderer* renderer, vk::DeviceSize bufferSize, uint32 framesInFlight)
+	: m_Renderer(renderer), m_BufferSize(bufferSize), m_FrameIndex(0), m_Offset(0)
+{
+	m_Buffers.resize(framesInFlight);
+	m_Dedicated.resize(framesInFlight);
+
+	for (Buffer& buffer : m_Buffers)
+	{
+		buffer = CreateBuffer(renderer, bufferSize, 
+							  vk::BufferUsageFlagBits::eTransferSrc, 
+							  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, 
+							  MemoryCategory::Staging);
+		SetObjectName(renderer->GetDevice(), buffer.buffer, "Staging ring");
+	}
+}
+
+StagingRing::~StagingRing()
+{
+	for (Buffer& buffer : m_Buffers)
+		DestroyBuffer(m_Renderer, buffer);
+
+	for (std::vector<Buffer>& buffers : m_Dedicated)
+	{
+		for (Buffer& buffer : buffers)
+			DestroyBuffer(m_Renderer, buffer);
+	}
+}
+
+void StagingRing::BeginFrame(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	m_Offset = 0;
+
+	for (Buffer& buffer : m_Dedicated[frameIndex])
+		DestroyBuffer(m_Renderer, buffer);
+	m_Dedicated[frameIndex].clear();
+}
+
+StagingAllocation StagingRing::Allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	StagingAllocation result = {};
+
+	vk::DeviceSize offset = (m_Offset + alignment - 1) / alignment * alignment;
+	if (offset + size <= m_BufferSize)
+	{
+		m_Offset = offset + size;
+
+		const Buffer& buffer = m_Buffers[m_FrameIndex];
+		result.buffer = buffer.buffer;
+		result.offset = offset;
+		result.mapped = (byte*)buffer.mapped + offset;
+		return result;
+	}
+
+	Buffer buffer = CreateBuffer(m_Renderer, size, 
+								 vk::BufferUsageFlagBits::eTransferSrc, 
+								 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, 
+								 MemoryCategory::Staging);
+	m_Dedicated[m_FrameIndex].push_back(buffer);
+
+	result.buffer = buffer.buffer;
+	result.offset = 0;
+	result.mapped = buffer.mapped;
+	return result;
+}
+
+StagingAllocation StagingRing::Upload(const void* data, vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	StagingAllocation result = Allocate(size, alignment);
+	memcpy(result.mapped, data, (size_t)size);
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "buffer.h"
+
+class Renderer;
+
+struct StagingAllocation
+{
+	vk::Buffer buffer;
+	vk::DeviceSize offset;
+	void* mapped;
+};
+
+// Upload memory for copies recorded in the current frame. Works like the UniformAllocator: one
+// persistently mapped buffer per frame in flight with a bumped offset, reused once the frame comes
+// around again. Uploads that don't fit get a buffer of their own that lives until then as well
+class StagingRing
+{
+private:
+	Renderer* m_Renderer;
+
+	std::vector<Buffer> m_Buffers;
+	vk::DeviceSize m_BufferSize;
+
+	// Oversized uploads, per frame in flight
+	std::vector<std::vector<Buffer>> m_Dedicated;
+
+	uint32 m_FrameIndex;
+	vk::DeviceSize m_Offset;
+public:
+	StagingRing(Renderer* renderer, vk::DeviceSize bufferSize, uint32 framesInFlight);
+	~StagingRing();
+
+	void BeginFrame(uint32 frameIndex);
+
+	// The alignment doesn't have to be a power of two. The default suits buffer to image copies of
+	// formats with power of two texel blocks, including block compressed ones, but not 3, 6 or 12 byte texels
+	StagingAllocation Allocate(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+
+	// Allocates and copies the data in
+	StagingAllocation Upload(const void* data, vk::DeviceSize size, vk::DeviceSize alignment = 16);
+
+	vk::DeviceSize GetUsedBytes() const { return m_Offset; }
+	vk::DeviceSize GetCapacity() const { return m_BufferSize; }
+};
\ No newline at end of file
@@ -14,14 +14,36 @@ Swapchain::Swapchain(SDL_Window* window, Renderer* renderer)
 Swapchain::~Swapchain()
 {
 	for (vk::ImageView& imageView : m_ImageViews)
-		m_Renderer->GetDevice().destroyImageView(imageView);
+		m_Renderer->GetDevice().destroyImageView(imageView, GetAllocationCallbacks(vk::ObjectType::eImageView));
 
-	m_Renderer->GetDevice().destroySwapchainKHR(m_Swapchain);
+	m_Renderer->GetDevice().destroySwapchainKHR(m_Swapchain, GetAllocationCallbacks(vk::ObjectType::eSwapchainKHR));
 }
 
-void Swapchain::CreateSwapchain()
+bool Swapchain::HasDrawableExtent()
 {
-	SwapchainSupportInfo supportInfo = SwapchainSupportInfo::GetSwapchainSupportInfo(m_Renderer->GetSurface(), m_Renderer->GetGPUDevice());
+	vk::Extent2D extent = GetBestSwapExtent(m_Renderer->GetCapabilities().surface.capabilities);
+	return extent.width > 0 && extent.height > 0;
+}
+
+void Swapchain::Recreate()
+{
+	assert(HasDrawableExtent());
+
+	for (vk::ImageView& imageView : m_ImageViews)
+		m_Renderer->GetDevice().destroyImageView(imageView, GetAllocationCallbacks(vk::ObjectType::eImageView));
+
+	vk::SwapchainKHR oldSwapchain = m_Swapchain;
+
+	CreateSwapchain(oldSwapchain);
+	CreateImageViews();
+
+	m_Renderer->GetDevice().destroySwapchainKHR(oldSwapchain, GetAllocationCallbacks(vk::ObjectType::eSwapchainKHR));
+}
+
+void Swapchain::CreateSwapchain(vk::SwapchainKHR oldSwapchain)
+{
+	// Refreshed by the renderer before a recreate
+	const SwapchainSupportInfo& supportInfo = m_Renderer->GetCapabilities().surface;
 
 	vk::SurfaceFormatKHR surfaceFormat = GetBestSwapSurfaceFormat(supportInfo.formats);
 	vk::PresentModeKHR presentMode = GetBestSwapPresentMode(supportInfo.presentModes);
@@ -41,7 +63,7 @@ void Swapchain::CreateSwapchain()
 	swapchainCreateInfo.setImageArrayLayers(1);
 	swapchainCreateInfo.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst);
 
-	QueueFamilyIndicies indices = m_Renderer->GetQueueFamilyIndicies(m_Renderer->GetGPUDevice());
+	const QueueFamilyIndicies& indices = m_Renderer->GetQueueFamilyIndicies();
 	uint32 queueFamilyIndices[] = { (uint32)indices.graphicsIndex, (uint32)indices.presentIndex };
 
 	if (indices.graphicsIndex != indices.presentIndex)
@@ -60,8 +82,9 @@ void Swapchain::CreateSwapchain()
 	swapchainCreateInfo.setPreTransform(supportInfo.capabilities.currentTransform);
 	swapchainCreateInfo.setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque);
 	swapchainCreateInfo.setPresentMode(presentMode);
+	swapchainCreateInfo.setOldSwapchain(oldSwapchain);
 
-	m_Swapchain = m_Renderer->GetDevice().createSwapchainKHR(swapchainCreateInfo);
+	m_Swapchain = m_Renderer->GetDevice().createSwapchainKHR(swapchainCreateInfo, GetAllocationCallbacks(vk::ObjectType::eSwapchainKHR));
 
 	m_Images = m_Renderer->GetDevice().getSwapchainImagesKHR(m_Swapchain);
 	assert(m_Images.size() > 0);
@@ -86,7 +109,10 @@ void Swapchain::CreateImageViews()
 			vk::ComponentSwizzle::eIdentity));
 		imageViewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
 
-		m_ImageViews[index] = m_Renderer->GetDevice().createImageView(imageViewCreateInfo);
+		m_ImageViews[index] = m_Renderer->GetDevice().createImageView(imageViewCreateInfo, GetAllocationCallbacks(vk::ObjectType::eImageView));
+
+		SetObjectName(m_Renderer->GetDevice(), m_Images[index], "Swapchain image");
+		SetObjectName(m_Renderer->GetDevice(), m_ImageViews[index], "Swapchain image view");
 	}
 }
 
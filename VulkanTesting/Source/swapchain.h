@@ -39,8 +39,14 @@ public:
 
 	const std::vector<vk::ImageView>& GetImageViews() const { return m_ImageViews; }
 	const std::vector<vk::Image>& GetImages() const { return m_Images;  }
+
+	// False while the surface is 0x0, as it is for a minimized window
+	bool HasDrawableExtent();
+
+	// Rebuilds the swapchain for the current surface size, the old images must no longer be in use
+	void Recreate();
 private:
-	void CreateSwapchain();
+	void CreateSwapchain(vk::SwapchainKHR oldSwapchain = nullptr);
 	void CreateImageViews();
 
 	//TODO: Maybe put in a Swapchain Class or orginize this a bit
@@ -0,0 +1,384 @@
+#include "texture.h"
+
+#include "renderer.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+
+uint32 GetMipLevelCount(vk::Extent2D extent)
+{
+	uint32 size = std::max(extent.width, extent.height);
+
+	uint32 result = 1;
+	while (size > 1)
+	{
+		size >>= 1;
+		result++;
+	}
+
+	return result;
+}
+
+vk::Extent2D GetMipExtent(vk::Extent2D extent, uint32 mip)
+{
+	return vk::Extent2D(std::max(extent.width >> mip, 1u), std::max(extent.height >> mip, 1u));
+}
+
+bool GetFormatBlockInfo(vk::Format format, FormatBlockInfo& info)
+{
+	typedef vk::Format F;
+
+	// Every ASTC size comes as a unorm and srgb pair, in this order
+	static const uint32 ASTC_BLOCK_SIZES[][2] = {
+		{ 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 }, 
+		{ 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 },
+	};
+
+	uint32 value = (uint32)format;
+	if (value >= (uint32)F::eAstc4x4UnormBlock && value <= (uint32)F::eAstc12x12SrgbBlock)
+	{
+		const uint32* size = ASTC_BLOCK_SIZES[(value - (uint32)F::eAstc4x4UnormBlock) / 2];
+		info = { size[0], size[1], 16 };
+		return true;
+	}
+
+	switch (format)
+	{
+	case F::eR8Unorm: case F::eR8Snorm: case F::eR8Uint: case F::eR8Sint: case F::eR8Srgb:
+		info = { 1, 1, 1 };
+		return true;
+	case F::eR8G8Unorm: case F::eR8G8Snorm: case F::eR8G8Uint: case F::eR8G8Sint: case F::eR8G8Srgb:
+	case F::eR16Unorm: case F::eR16Snorm: case F::eR16Uint: case F::eR16Sint: case F::eR16Sfloat:
+	case F::eR5G6B5UnormPack16: case F::eB5G6R5UnormPack16: case F::eR4G4B4A4UnormPack16: case F::eB4G4R4A4UnormPack16:
+	case F::eR5G5B5A1UnormPack16: case F::eB5G5R5A1UnormPack16: case F::eA1R5G5B5UnormPack16:
+		info = { 1, 1, 2 };
+		return true;
+	case F::eR8G8B8Unorm: case F::eR8G8B8Snorm: case F::eR8G8B8Uint: case F::eR8G8B8Sint: case F::eR8G8B8Srgb:
+	case F::eB8G8R8Unorm: case F::eB8G8R8Snorm: case F::eB8G8R8Uint: case F::eB8G8R8Sint: case F::eB8G8R8Srgb:
+		info = { 1, 1, 3 };
+		return true;
+	case F::eR8G8B8A8Unorm: case F::eR8G8B8A8Snorm: case F::eR8G8B8A8Uint: case F::eR8G8B8A8Sint: case F::eR8G8B8A8Srgb:
+	case F::eB8G8R8A8Unorm: case F::eB8G8R8A8Snorm: case F::eB8G8R8A8Uint: case F::eB8G8R8A8Sint: case F::eB8G8R8A8Srgb:
+	case F::eA2R10G10B10UnormPack32: case F::eA2B10G10R10UnormPack32: case F::eB10G11R11UfloatPack32: case F::eE5B9G9R9UfloatPack32:
+	case F::eR16G16Unorm: case F::eR16G16Snorm: case F::eR16G16Uint: case F::eR16G16Sint: case F::eR16G16Sfloat:
+	case F::eR32Uint: case F::eR32Sint: case F::eR32Sfloat:
+		info = { 1, 1, 4 };
+		return true;
+	case F::eR16G16B16Unorm: case F::eR16G16B16Snorm: case F::eR16G16B16Uint: case F::eR16G16B16Sint: case F::eR16G16B16Sfloat:
+		info = { 1, 1, 6 };
+		return true;
+	case F::eR16G16B16A16Unorm: case F::eR16G16B16A16Snorm: case F::eR16G16B16A16Uint: case F::eR16G16B16A16Sint: case F::eR16G16B16A16Sfloat:
+	case F::eR32G32Uint: case F::eR32G32Sint: case F::eR32G32Sfloat:
+		info = { 1, 1, 8 };
+		return true;
+	case F::eR32G32B32Uint: case F::eR32G32B32Sint: case F::eR32G32B32Sfloat:
+		info = { 1, 1, 12 };
+		return true;
+	case F::eR32G32B32A32Uint: case F::eR32G32B32A32Sint: case F::eR32G32B32A32Sfloat:
+		info = { 1, 1, 16 };
+		return true;
+	case F::eBc1RgbUnormBlock: case F::eBc1RgbSrgbBlock: case F::eBc1RgbaUnormBlock: case F::eBc1RgbaSrgbBlock:
+	case F::eBc4UnormBlock: case F::eBc4SnormBlock:
+	case F::eEtc2R8G8B8UnormBlock: case F::eEtc2R8G8B8SrgbBlock: case F::eEtc2R8G8B8A1UnormBlock: case F::eEtc2R8G8B8A1SrgbBlock:
+	case F::eEacR11UnormBlock: case F::eEacR11SnormBlock:
+		info = { 4, 4, 8 };
+		return true;
+	case F::eBc2UnormBlock: case F::eBc2SrgbBlock: case F::eBc3UnormBlock: case F::eBc3SrgbBlock:
+	case F::eBc5UnormBlock: case F::eBc5SnormBlock: case F::eBc6HUfloatBlock: case F::eBc6HSfloatBlock:
+	case F::eBc7UnormBlock: case F::eBc7SrgbBlock:
+	case F::eEtc2R8G8B8A8UnormBlock: case F::eEtc2R8G8B8A8SrgbBlock: case F::eEacR11G11UnormBlock: case F::eEacR11G11SnormBlock:
+		info = { 4, 4, 16 };
+		return true;
+	default:
+		return false;
+	}
+}
+
+vk::DeviceSize GetTextureLevelSize(vk::Format format, vk::Extent2D extent)
+{
+	FormatBlockInfo block;
+	if (!GetFormatBlockInfo(format, block))
+		return 0;
+
+	vk::DeviceSize blocksX = (extent.width + block.width - 1) / block.width;
+	vk::DeviceSize blocksY = (extent.height + block.height - 1) / block.height;
+
+	return blocksX * blocksY * block.bytes;
+}
+
+static bool CanGenerateMips(const DeviceCapabilities& capabilities, vk::Format format)
+{
+	vk::FormatFeatureFlags features = capabilities.GetFormatProperties(format).optimalTilingFeatures;
+	vk::FormatFeatureFlags blit = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst;
+
+	return (features & blit) == blit;
+}
+
+Texture CreateTexture(Renderer* renderer, vk::Format format, vk::Extent2D extent, uint32 mipLevels)
+{
+	vk::Device device = renderer->GetDevice();
+	const DeviceCapabilities& capabilities = renderer->GetCapabilities();
+
+	if (!(capabilities.GetFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
+		throw std::runtime_error("texture format can't be sampled with optimal tiling!");
+
+	if (mipLevels == TEXTURE_FULL_MIP_CHAIN)
+	{
+		mipLevels = GetMipLevelCount(extent);
+
+		if (!CanGenerateMips(capabilities, format))
+		{
+			printf("Format %s can't be blitted, texture gets a single mip level\n", vk::to_string(format).c_str());
+			mipLevels = 1;
+		}
+	}
+
+	Texture result = {};
+	result.format = format;
+	result.extent = extent;
+	result.mipLevels = mipLevels;
+
+	vk::ImageCreateInfo imageCreateInfo = {};
+	imageCreateInfo.setImageType(vk::ImageType::e2D);
+	imageCreateInfo.setFormat(format);
+	imageCreateInfo.setExtent(vk::Extent3D(extent.width, extent.height, 1));
+	imageCreateInfo.setMipLevels(mipLevels);
+	imageCreateInfo.setArrayLayers(1);
+	imageCreateInfo.setSamples(vk::SampleCountFlagBits::e1);
+	imageCreateInfo.setTiling(vk::ImageTiling::eOptimal);
+	imageCreateInfo.setUsage(vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc);
+	imageCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+	imageCreateInfo.setInitialLayout(vk::ImageLayout::eUndefined);
+
+	result.image = device.createImage(imageCreateInfo, GetAllocationCallbacks(vk::ObjectType::eImage));
+
+	vk::MemoryRequirements memRequirements = device.getImageMemoryRequirements(result.image);
+
+	vk::MemoryAllocateInfo allocInfo = {};
+	allocInfo.setAllocationSize(memRequirements.size);
+	allocInfo.setMemoryTypeIndex(renderer->FindMemoryType(memRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+	result.memory = renderer->GetMemoryBudget()->Allocate(allocInfo, MemoryCategory::Image);
+	device.bindImageMemory(result.image, result.memory, 0);
+
+	vk::ImageViewCreateInfo viewCreateInfo = {};
+	viewCreateInfo.setImage(result.image);
+	viewCreateInfo.setViewType(vk::ImageViewType::e2D);
+	viewCreateInfo.setFormat(format);
+	viewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1));
+
+	result.view = device.createImageView(viewCreateInfo, GetAllocationCallbacks(vk::ObjectType::eImageView));
+
+	return result;
+}
+
+void DestroyTexture(Renderer* renderer, Texture& texture)
+{
+	vk::Device device = renderer->GetDevice();
+
+	device.destroyImageView(texture.view, GetAllocationCallbacks(vk::ObjectType::eImageView));
+	device.destroyImage(texture.image, GetAllocationCallbacks(vk::ObjectType::eImage));
+	renderer->GetMemoryBudget()->Free(texture.memory);
+
+	texture = {};
+}
+
+static vk::ImageMemoryBarrier GetMipBarrier(vk::Image image, uint32 baseMip, uint32 mipCount, 
+											vk::AccessFlags srcAccess, vk::AccessFlags dstAccess, 
+											vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
+{
+	vk::ImageMemoryBarrier result = {};
+	result.setSrcAccessMask(srcAccess);
+	result.setDstAccessMask(dstAccess);
+	result.setOldLayout(oldLayout);
+	result.setNewLayout(newLayout);
+	result.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+	result.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+	result.setImage(image);
+	result.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, baseMip, mipCount, 0, 1));
+
+	return result;
+}
+
+void CopyToTextureLevel(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, uint32 mip, const TextureLevelData& level)
+{
+	// The buffer offset has to be a multiple of the texel block size, which is 3, 6 or 12 bytes for some formats
+	vk::DeviceSize alignment = 16;
+	FormatBlockInfo blockInfo;
+	if (GetFormatBlockInfo(texture.format, blockInfo))
+	{
+		while (alignment % blockInfo.bytes != 0)
+			alignment += 16;
+	}
+
+	StagingAllocation staging = renderer->GetStagingRing()->Upload(level.data, level.size, alignment);
+
+	vk::BufferImageCopy region = {};
+	region.setBufferOffset(staging.offset);
+	region.setImageSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip, 0, 1));
+	vk::Extent2D extent = GetMipExtent(texture.extent, mip);
+	region.setImageExtent(vk::Extent3D(extent.width, extent.height, 1));
+
+	commandBuffer.copyBufferToImage(staging.buffer, texture.image, vk::ImageLayout::eTransferDstOptimal, region, GetDispatch());
+}
+
+void UploadTexture(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, const void* pixels, vk::DeviceSize size)
+{
+	const DeviceCapabilities& capabilities = renderer->GetCapabilities();
+	assert(texture.mipLevels == 1 || CanGenerateMips(capabilities, texture.format));
+
+	DebugLabelScope label(commandBuffer, "Texture upload");
+
+	vk::ImageMemoryBarrier barrier = GetMipBarrier(texture.image, 0, texture.mipLevels, 
+												   vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, 
+												   vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 
+								  vk::DependencyFlags(), nullptr, nullptr, barrier, GetDispatch());
+
+	CopyToTextureLevel(renderer, commandBuffer, texture, 0, { pixels, size });
+
+	// Every level is blitted from the one above it, which has to be finished and readable first
+	vk::Filter filter = vk::Filter::eNearest;
+	if (capabilities.GetFormatProperties(texture.format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear)
+		filter = vk::Filter::eLinear;
+
+	int32 width = (int32)texture.extent.width;
+	int32 height = (int32)texture.extent.height;
+
+	for (uint32 mip = 1; mip < texture.mipLevels; mip++)
+	{
+		barrier = GetMipBarrier(texture.image, mip - 1, 1, 
+								vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead, 
+								vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, 
+									  vk::DependencyFlags(), nullptr, nullptr, barrier, GetDispatch());
+
+		int32 mipWidth = std::max(width / 2, 1);
+		int32 mipHeight = std::max(height / 2, 1);
+
+		vk::ImageBlit blit = {};
+		blit.setSrcSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip - 1, 0, 1));
+		blit.setSrcOffsets({ vk::Offset3D(0, 0, 0), vk::Offset3D(width, height, 1) });
+		blit.setDstSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip, 0, 1));
+		blit.setDstOffsets({ vk::Offset3D(0, 0, 0), vk::Offset3D(mipWidth, mipHeight, 1) });
+
+		commandBuffer.blitImage(texture.image, vk::ImageLayout::eTransferSrcOptimal, 
+								texture.image, vk::ImageLayout::eTransferDstOptimal, 
+								blit, filter, GetDispatch());
+
+		width = mipWidth;
+		height = mipHeight;
+	}
+
+	// Every level but the last one ended up as a blit source
+	vk::ImageMemoryBarrier finalBarriers[2];
+	uint32 finalBarrierCount = 0;
+
+	uint32 lastMip = texture.mipLevels - 1;
+	if (lastMip > 0)
+	{
+		finalBarriers[finalBarrierCount++] = GetMipBarrier(texture.image, 0, lastMip, 
+														   vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead, 
+														   vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+
+	finalBarriers[finalBarrierCount++] = GetMipBarrier(texture.image, lastMip, 1, 
+													   vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, 
+													   vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, 
+								  vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader, 
+								  vk::DependencyFlags(), nullptr, nullptr, 
+								  vk::ArrayProxy<const vk::ImageMemoryBarrier>(finalBarrierCount, finalBarriers), GetDispatch());
+}
+
+void UploadTextureLevels(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, 
+						 vk::ArrayProxy<const TextureLevelData> levels)
+{
+	assert(levels.size() == texture.mipLevels);
+
+	DebugLabelScope label(commandBuffer, "Texture upload");
+
+	vk::ImageMemoryBarrier barrier = GetMipBarrier(texture.image, 0, texture.mipLevels, 
+												   vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, 
+												   vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 
+								  vk::DependencyFlags(), nullptr, nullptr, barrier, GetDispatch());
+
+	for (uint32 mip = 0; mip < levels.size(); mip++)
+		CopyToTextureLevel(renderer, commandBuffer, texture, mip, levels.data()[mip]);
+
+	barrier = GetMipBarrier(texture.image, 0, texture.mipLevels, 
+							vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, 
+							vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, 
+								  vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader, 
+								  vk::DependencyFlags(), nullptr, nullptr, barrier, GetDispatch());
+}
+
+bool SamplerDesc::operator==(const SamplerDesc& other) const
+{
+	return magFilter == other.magFilter && minFilter == other.minFilter && mipmapMode == other.mipmapMode && 
+		   addressModeU == other.addressModeU && addressModeV == other.addressModeV && addressModeW == other.addressModeW && 
+		   borderColor == other.borderColor && maxAnisotropy == other.maxAnisotropy && 
+		   mipLodBias == other.mipLodBias && minLod == other.minLod && maxLod == other.maxLod;
+}
+
+uint64 SamplerDesc::Hash() const
+{
+	uint64 hash = HashValue((uint32)magFilter);
+	hash = HashValue((uint32)minFilter, hash);
+	hash = HashValue((uint32)mipmapMode, hash);
+	hash = HashValue((uint32)addressModeU, hash);
+	hash = HashValue((uint32)addressModeV, hash);
+	hash = HashValue((uint32)addressModeW, hash);
+	hash = HashValue((uint32)borderColor, hash);
+	hash = HashValue(maxAnisotropy, hash);
+	hash = HashValue(mipLodBias, hash);
+	hash = HashValue(minLod, hash);
+
+	return HashValue(maxLod, hash);
+}
+
+SamplerCache::SamplerCache(Renderer* renderer)
+	: m_Renderer(renderer)
+{
+}
+
+SamplerCache::~SamplerCache()
+{
+	for (auto& entry : m_Samplers)
+		m_Renderer->GetDevice().destroySampler(entry.second, GetAllocationCallbacks(vk::ObjectType::eSampler));
+}
+
+vk::Sampler SamplerCache::GetSampler(const SamplerDesc& desc)
+{
+	auto it = m_Samplers.find(desc);
+	if (it != m_Samplers.end())
+		return it->second;
+
+	float maxAnisotropy = 0.0f;
+	if (m_Renderer->GetEnabledFeatures().samplerAnisotropy)
+		maxAnisotropy = std::min(desc.maxAnisotropy, m_Renderer->GetCapabilities().properties.limits.maxSamplerAnisotropy);
+
+	vk::SamplerCreateInfo samplerCreateInfo = {};
+	samplerCreateInfo.setMagFilter(desc.magFilter);
+	samplerCreateInfo.setMinFilter(desc.minFilter);
+	samplerCreateInfo.setMipmapMode(desc.mipmapMode);
+	samplerCreateInfo.setAddressModeU(desc.addressModeU);
+	samplerCreateInfo.setAddressModeV(desc.addressModeV);
+	samplerCreateInfo.setAddressModeW(desc.addressModeW);
+	samplerCreateInfo.setBorderColor(desc.borderColor);
+	samplerCreateInfo.setAnisotropyEnable(maxAnisotropy > 1.0f);
+	samplerCreateInfo.setMaxAnisotropy(std::max(maxAnisotropy, 1.0f));
+	samplerCreateInfo.setMipLodBias(desc.mipLodBias);
+	samplerCreateInfo.setMinLod(desc.minLod);
+	samplerCreateInfo.setMaxLod(desc.maxLod);
+
+	vk::Sampler sampler = m_Renderer->GetDevice().createSampler(samplerCreateInfo, GetAllocationCallbacks(vk::ObjectType::eSampler));
+
+	m_Samplers[desc] = sampler;
+	return sampler;
+}
\ No newline at end of file
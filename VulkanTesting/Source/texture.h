@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <unordered_map>
+
+#include "types.h"
+
+class Renderer;
+
+// Pass as the mip count to get every level down to 1x1, generated on the GPU by UploadTexture
+const uint32 TEXTURE_FULL_MIP_CHAIN = 0;
+
+struct Texture
+{
+	vk::Image image;
+	vk::ImageView view;
+	vk::DeviceMemory memory;
+
+	vk::Format format = vk::Format::eUndefined;
+	vk::Extent2D extent;
+	uint32 mipLevels = 0;
+};
+
+// Tightly packed contents of one mip level, rows of blocks for compressed formats
+struct TextureLevelData
+{
+	const void* data;
+	vk::DeviceSize size;
+};
+
+uint32 GetMipLevelCount(vk::Extent2D extent);
+vk::Extent2D GetMipExtent(vk::Extent2D extent, uint32 mip);
+
+// Uncompressed formats are 1x1 blocks of one pixel
+struct FormatBlockInfo
+{
+	uint32 width;
+	uint32 height;
+	uint32 bytes;
+};
+
+// False for formats whose layout isn't known here (packed depth, multi planar and the like)
+bool GetFormatBlockInfo(vk::Format format, FormatBlockInfo& info);
+
+// Size of one tightly packed level, 0 for formats GetFormatBlockInfo doesn't know
+vk::DeviceSize GetTextureLevelSize(vk::Format format, vk::Extent2D extent);
+
+// Device local, optimally tiled and sampled from shaders. A full mip chain on a format the device
+// can't blit becomes a single level, mips are only ever generated on the GPU. Explicit counts are
+// kept as they are for data that comes with its own levels
+Texture CreateTexture(Renderer* renderer, vk::Format format, vk::Extent2D extent, uint32 mipLevels = TEXTURE_FULL_MIP_CHAIN);
+void DestroyTexture(Renderer* renderer, Texture& texture);
+
+// Records the upload of the top level through the staging ring, the blits that fill in the other
+// levels, and the transition to SHADER_READ_ONLY_OPTIMAL for the fragment and compute stages.
+// The command buffer has to be submitted in the current frame, that is how long the staging data lives
+void UploadTexture(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, const void* pixels, vk::DeviceSize size);
+
+// Same, but every level comes from the caller, for block compressed data that can't be blitted
+void UploadTextureLevels(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, 
+						 vk::ArrayProxy<const TextureLevelData> levels);
+
+// Only the copy through the staging ring, the level has to be in TRANSFER_DST_OPTIMAL
+void CopyToTextureLevel(Renderer* renderer, vk::CommandBuffer commandBuffer, const Texture& texture, uint32 mip, const TextureLevelData& level);
+
+struct SamplerDesc
+{
+	vk::Filter magFilter = vk::Filter::eLinear;
+	vk::Filter minFilter = vk::Filter::eLinear;
+	vk::SamplerMipmapMode mipmapMode = vk::SamplerMipmapMode::eLinear;
+
+	vk::SamplerAddressMode addressModeU = vk::SamplerAddressMode::eRepeat;
+	vk::SamplerAddressMode addressModeV = vk::SamplerAddressMode::eRepeat;
+	vk::SamplerAddressMode addressModeW = vk::SamplerAddressMode::eRepeat;
+	vk::BorderColor borderColor = vk::BorderColor::eFloatTransparentBlack;
+
+	// 0 turns anisotropic filtering off, clamped to what the device supports
+	float maxAnisotropy = 0.0f;
+
+	float mipLodBias = 0.0f;
+	float minLod = 0.0f;
+	float maxLod = VK_LOD_CLAMP_NONE;
+
+	bool operator==(const SamplerDesc& other) const;
+	uint64 Hash() const;
+};
+
+struct SamplerDescHasher
+{
+	size_t operator()(const SamplerDesc& desc) const { return (size_t)desc.Hash(); }
+};
+
+// Owns every sampler, identical state returns the same object. Devices only guarantee 4000 samplers
+// so they are never created anywhere else
+class SamplerCache
+{
+private:
+	Renderer* m_Renderer;
+	std::unordered_map<SamplerDesc, vk::Sampler, SamplerDescHasher> m_Samplers;
+public:
+	SamplerCache(Renderer* renderer);
+	~SamplerCache();
+
+	vk::Sampler GetSampler(const SamplerDesc& desc);
+
+	uint32 GetSamplerCount() const { return (uint32)m_Samplers.size(); }
+};
\ No newline at end of file
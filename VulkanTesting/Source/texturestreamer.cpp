@@ -0,0 +1,444 @@
+#include "texturestreamer.h"
+
+#include "renderer.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+const uint32 FEEDBACK_GROUP_SIZE = 64;
+
+struct FeedbackPushConstants
+{
+	Matrix4f viewProjection;
+	float viewportHeight;
+	uint32 objectCount;
+	uint32 textureCount;
+};
+
+TextureStreamer::TextureStreamer(Renderer* renderer, uint32 maxTextures, uint32 maxObjects)
+	: m_Renderer(renderer), m_MaxTextures(maxTextures), m_Textures(maxTextures), m_TextureCount(0), 
+	  m_MaxObjects(maxObjects), m_ObjectCount(0), m_FrameIndex(0), m_FrameCount(0), m_Stats()
+{
+	vk::Device device = renderer->GetDevice();
+
+	m_ObjectBuffer = CreateBuffer(renderer, sizeof(StreamingObject) * maxObjects, 
+								  vk::BufferUsageFlagBits::eStorageBuffer, 
+								  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	SetObjectName(device, m_ObjectBuffer.buffer, "Streaming objects");
+
+	m_FeedbackBuffers.resize(NUM_FRAMES);
+	for (Buffer& buffer : m_FeedbackBuffers)
+	{
+		buffer = CreateBuffer(renderer, sizeof(uint32) * maxTextures, 
+							  vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, 
+							  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		SetObjectName(device, buffer.buffer, "Mip feedback");
+
+		// Read before the first feedback pass that writes it has run
+		memset(buffer.mapped, 0, sizeof(uint32) * maxTextures);
+	}
+
+	m_RetiredTextures.resize(NUM_FRAMES);
+
+	m_ShaderModule = CompileShader(device, "Resources/mipfeedback.comp", shaderc_shader_kind::shaderc_compute_shader);
+	m_Pipeline = CreateComputePipeline(device, m_ShaderModule, 
+									   { GetDescriptorBuilder().BuildLayout() }, 
+									   { vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(FeedbackPushConstants)) });
+
+	SetObjectName(device, m_Pipeline.pipeline, "Mip feedback");
+
+	// Textures go to the heap of the first device local memory type, that is the one to keep an eye on
+	const DeviceCapabilities& capabilities = renderer->GetCapabilities();
+	uint32 memoryType = renderer->FindMemoryType(UINT32_MAX, vk::MemoryPropertyFlagBits::eDeviceLocal);
+	m_HeapIndex = capabilities.memoryProperties.memoryTypes[memoryType].heapIndex;
+
+	m_EvictionCallback = renderer->GetMemoryBudget()->AddEvictionCallback(
+		[this](uint32 heapIndex, vk::DeviceSize bytes) { return Evict(heapIndex, bytes); });
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	vk::Device device = m_Renderer->GetDevice();
+
+	m_Renderer->GetMemoryBudget()->RemoveEvictionCallback(m_EvictionCallback);
+
+	// The jobs write into the entries
+	for (uint32 index = 0; index < m_TextureCount; index++)
+		m_Renderer->GetJobSystem()->Wait(&m_Textures[index].loadCounter);
+
+	BindlessHeap* bindlessHeap = m_Renderer->GetBindlessHeap();
+	for (uint32 index = 0; index < m_TextureCount; index++)
+	{
+		StreamedTexture& texture = m_Textures[index];
+		if (!texture.loaded)
+			continue;
+
+		if (bindlessHeap)
+			bindlessHeap->ReleaseTexture(texture.bindlessIndex);
+
+		DestroyTexture(m_Renderer, texture.texture);
+	}
+
+	for (std::vector<Texture>& textures : m_RetiredTextures)
+	{
+		for (Texture& texture : textures)
+			DestroyTexture(m_Renderer, texture);
+	}
+
+	device.destroyPipeline(m_Pipeline.pipeline, GetAllocationCallbacks(vk::ObjectType::ePipeline));
+	device.destroyPipelineLayout(m_Pipeline.layout, GetAllocationCallbacks(vk::ObjectType::ePipelineLayout));
+	device.destroyShaderModule(m_ShaderModule, GetAllocationCallbacks(vk::ObjectType::eShaderModule));
+
+	DestroyBuffer(m_Renderer, m_ObjectBuffer);
+	for (Buffer& buffer : m_FeedbackBuffers)
+		DestroyBuffer(m_Renderer, buffer);
+}
+
+DescriptorBuilder TextureStreamer::GetDescriptorBuilder()
+{
+	DescriptorBuilder builder(m_Renderer->GetDescriptorLayoutCache(), m_Renderer->GetDescriptorAllocator());
+	builder.BindBuffer(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBufferInfo(m_ObjectBuffer.buffer, 0, VK_WHOLE_SIZE));
+	builder.BindBuffer(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBufferInfo(m_FeedbackBuffers[m_FrameIndex].buffer, 0, VK_WHOLE_SIZE));
+
+	return builder;
+}
+
+StreamedTextureId TextureStreamer::Load(const String& filename)
+{
+	assert(m_TextureCount < m_MaxTextures);
+
+	StreamedTextureId id = m_TextureCount++;
+
+	StreamedTexture* texture = &m_Textures[id];
+	texture->filename = filename;
+	texture->loadFailed = false;
+	texture->loaded = false;
+	texture->evict = false;
+	texture->bindlessIndex = BINDLESS_INVALID_INDEX;
+
+	Renderer* renderer = m_Renderer;
+	m_Renderer->GetJobSystem()->Submit([renderer, texture]()
+	{
+		try
+		{
+			texture->image = LoadKtx2(renderer, texture->filename);
+		}
+		catch (const std::exception& exception)
+		{
+			printf("Failed to stream %s: %s\n", texture->filename.c_str(), exception.what());
+			texture->loadFailed = true;
+		}
+	}, &texture->loadCounter);
+
+	return id;
+}
+
+void TextureStreamer::SetObjects(const StreamingObject* objects, uint32 count)
+{
+	assert(count <= m_MaxObjects);
+
+	memcpy(m_ObjectBuffer.mapped, objects, sizeof(StreamingObject) * count);
+	m_ObjectCount = count;
+}
+
+vk::DeviceSize TextureStreamer::GetLevelBytes(const StreamedTexture& texture, uint32 firstMip) const
+{
+	vk::DeviceSize result = 0;
+	for (uint32 mip = firstMip; mip < texture.image.levels.size(); mip++)
+		result += texture.image.levels[mip].size;
+
+	return result;
+}
+
+uint32 TextureStreamer::GetRequestedMip(const StreamedTexture& texture, uint32 footprint) const
+{
+	// The smallest level that still has at least a texel per pixel of the footprint
+	uint32 size = std::max(texture.image.extent.width, texture.image.extent.height);
+
+	uint32 result = 0;
+	while (result < texture.minResidentMip && (size >> (result + 1)) >= footprint)
+		result++;
+
+	return result;
+}
+
+void TextureStreamer::FinishLoad(vk::CommandBuffer commandBuffer, StreamedTexture& texture)
+{
+	const Ktx2Image& image = texture.image;
+	uint32 levelCount = (uint32)image.levels.size();
+
+	texture.loaded = true;
+	texture.lastRequestFrame = m_FrameCount;
+
+	if (image.generateMips)
+	{
+		// Nothing stored to stream from, the whole chain comes from the top level
+		texture.texture = CreateKtx2Texture(m_Renderer, image);
+		UploadKtx2Texture(m_Renderer, commandBuffer, texture.texture, image);
+
+		texture.minResidentMip = 0;
+		texture.residentMip = 0;
+	}
+	else
+	{
+		uint32 size = std::max(image.extent.width, image.extent.height);
+
+		uint32 minResidentMip = 0;
+		while (minResidentMip < levelCount - 1 && (size >> minResidentMip) > STREAMING_RESIDENT_SIZE)
+			minResidentMip++;
+
+		texture.minResidentMip = minResidentMip;
+		texture.residentMip = minResidentMip;
+
+		texture.texture = CreateTexture(m_Renderer, image.format, GetMipExtent(image.extent, minResidentMip), levelCount - minResidentMip);
+
+		FrameVector<TextureLevelData> levels;
+		for (uint32 mip = minResidentMip; mip < levelCount; mip++)
+			levels.push_back(image.GetLevel(mip));
+
+		UploadTextureLevels(m_Renderer, commandBuffer, texture.texture, vk::ArrayProxy<const TextureLevelData>((uint32)levels.size(), levels.data()));
+	}
+
+	texture.requestedMip = texture.residentMip;
+	SetObjectName(m_Renderer->GetDevice(), texture.texture.image, texture.filename.c_str());
+
+	if (BindlessHeap* bindlessHeap = m_Renderer->GetBindlessHeap())
+		texture.bindlessIndex = bindlessHeap->RegisterTexture(texture.texture.view, vk::ImageLayout::eShaderReadOnlyOptimal);
+}
+
+void TextureStreamer::SetResidentMip(vk::CommandBuffer commandBuffer, StreamedTexture& texture, uint32 residentMip)
+{
+	DebugLabelScope label(commandBuffer, "Texture streaming");
+
+	vk::Device device = m_Renderer->GetDevice();
+	const Ktx2Image& image = texture.image;
+	uint32 levelCount = (uint32)image.levels.size();
+
+	Texture previous = texture.texture;
+	uint32 previousMip = texture.residentMip;
+
+	Texture next = CreateTexture(m_Renderer, image.format, GetMipExtent(image.extent, residentMip), levelCount - residentMip);
+	SetObjectName(device, next.image, texture.filename.c_str());
+
+	// The previous image was last sampled by this or an earlier frame on the same queue
+	vk::ImageMemoryBarrier barriers[2];
+	barriers[0] = vk::ImageMemoryBarrier(vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, 
+										 vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 
+										 VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, next.image, 
+										 vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, next.mipLevels, 0, 1));
+	barriers[1] = vk::ImageMemoryBarrier(vk::AccessFlags(), vk::AccessFlagBits::eTransferRead, 
+										 vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal, 
+										 VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, previous.image, 
+										 vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, previous.mipLevels, 0, 1));
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader, 
+								  vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr, nullptr, barriers, GetDispatch());
+
+	// Levels both images have are copied on the GPU, the new ones come from the file
+	FrameVector<vk::ImageCopy> copies;
+	for (uint32 mip = std::max(residentMip, previousMip); mip < levelCount; mip++)
+	{
+		vk::Extent2D extent = GetMipExtent(image.extent, mip);
+
+		vk::ImageCopy copy = {};
+		copy.setSrcSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip - previousMip, 0, 1));
+		copy.setDstSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip - residentMip, 0, 1));
+		copy.setExtent(vk::Extent3D(extent.width, extent.height, 1));
+		copies.push_back(copy);
+	}
+
+	commandBuffer.copyImage(previous.image, vk::ImageLayout::eTransferSrcOptimal, next.image, vk::ImageLayout::eTransferDstOptimal, 
+							vk::ArrayProxy<const vk::ImageCopy>((uint32)copies.size(), copies.data()), GetDispatch());
+
+	for (uint32 mip = residentMip; mip < previousMip; mip++)
+		CopyToTextureLevel(m_Renderer, commandBuffer, next, mip - residentMip, image.GetLevel(mip));
+
+	vk::ImageMemoryBarrier readBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, 
+									   vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, 
+									   VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, next.image, 
+									   vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, next.mipLevels, 0, 1));
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, 
+								  vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader, 
+								  vk::DependencyFlags(), nullptr, nullptr, readBarrier, GetDispatch());
+
+	// Frames in flight still sample the previous image through the previous slot
+	m_RetiredTextures[m_FrameIndex].push_back(previous);
+
+	if (BindlessHeap* bindlessHeap = m_Renderer->GetBindlessHeap())
+	{
+		bindlessHeap->ReleaseTexture(texture.bindlessIndex);
+		texture.bindlessIndex = bindlessHeap->RegisterTexture(next.view, vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+
+	texture.texture = next;
+	texture.residentMip = residentMip;
+}
+
+vk::DeviceSize TextureStreamer::Evict(uint32 heapIndex, vk::DeviceSize bytes)
+{
+	if (heapIndex != m_HeapIndex)
+		return 0;
+
+	// Least recently needed first, they drop everything above the levels that always stay
+	std::vector<StreamedTexture*> candidates;
+	for (uint32 index = 0; index < m_TextureCount; index++)
+	{
+		if (m_Textures[index].loaded && m_Textures[index].residentMip < m_Textures[index].minResidentMip)
+			candidates.push_back(&m_Textures[index]);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), 
+			  [](const StreamedTexture* a, const StreamedTexture* b) { return a->lastRequestFrame < b->lastRequestFrame; });
+
+	vk::DeviceSize released = 0;
+	for (uint32 index = 0; index < candidates.size() && released < bytes; index++)
+	{
+		StreamedTexture* texture = candidates[index];
+		released += GetLevelBytes(*texture, texture->residentMip) - GetLevelBytes(*texture, texture->minResidentMip);
+
+		// Streaming them back in waits until the heap is out of pressure
+		texture->evict = true;
+		m_Stats.pressureEvictions++;
+	}
+
+	// Nothing is freed until the smaller images replaced these and the frames in flight are done
+	return 0;
+}
+
+void TextureStreamer::Update(vk::CommandBuffer commandBuffer)
+{
+	m_FrameIndex = m_Renderer->GetFrameIndex();
+	m_FrameCount++;
+
+	for (Texture& texture : m_RetiredTextures[m_FrameIndex])
+		DestroyTexture(m_Renderer, texture);
+	m_RetiredTextures[m_FrameIndex].clear();
+
+	// Written by the feedback pass of the frame that last used this index, which is done now
+	const uint32* footprints = (const uint32*)m_FeedbackBuffers[m_FrameIndex].mapped;
+
+	const MemoryHeapStats& heap = m_Renderer->GetMemoryBudget()->GetHeapStats(m_HeapIndex);
+	vk::DeviceSize uploadBytes = 0;
+
+	m_Stats.textureCount = m_TextureCount;
+	m_Stats.loadingCount = 0;
+	m_Stats.residentBytes = 0;
+	m_Stats.fullBytes = 0;
+
+	for (uint32 index = 0; index < m_TextureCount; index++)
+	{
+		StreamedTexture& texture = m_Textures[index];
+
+		if (!texture.loaded)
+		{
+			if (!texture.loadCounter.IsDone())
+			{
+				m_Stats.loadingCount++;
+				continue;
+			}
+
+			if (texture.loadFailed)
+				continue;
+
+			FinishLoad(commandBuffer, texture);
+			uploadBytes += GetLevelBytes(texture, texture.residentMip);
+		}
+		else if (texture.evict)
+		{
+			texture.evict = false;
+			if (texture.residentMip < texture.minResidentMip)
+			{
+				m_Stats.levelsEvicted += texture.minResidentMip - texture.residentMip;
+				SetResidentMip(commandBuffer, texture, texture.minResidentMip);
+			}
+
+			texture.requestedMip = texture.minResidentMip;
+			texture.lastRequestFrame = m_FrameCount;
+		}
+		else
+		{
+			// Textures that weren't on screen only need the levels that always stay
+			texture.requestedMip = texture.minResidentMip;
+			if (footprints[index] > 0)
+				texture.requestedMip = GetRequestedMip(texture, footprints[index]);
+
+			if (texture.requestedMip <= texture.residentMip)
+				texture.lastRequestFrame = m_FrameCount;
+		}
+
+		if (texture.requestedMip < texture.residentMip)
+		{
+			// A level at a time, and only while the heap has room for the old and new image side by side
+			uint32 mip = texture.residentMip - 1;
+			vk::DeviceSize bytes = GetLevelBytes(texture, mip);
+
+			bool underPressure = heap.usage + bytes > (vk::DeviceSize)(heap.budget * MEMORY_PRESSURE_THRESHOLD);
+			if (uploadBytes < STREAMING_UPLOAD_BYTES_PER_FRAME && !underPressure)
+			{
+				SetResidentMip(commandBuffer, texture, mip);
+				uploadBytes += texture.image.levels[mip].size;
+				m_Stats.levelsStreamedIn++;
+			}
+		}
+		else if (texture.requestedMip > texture.residentMip && m_FrameCount - texture.lastRequestFrame > STREAMING_EVICTION_DELAY)
+		{
+			m_Stats.levelsEvicted += texture.requestedMip - texture.residentMip;
+			SetResidentMip(commandBuffer, texture, texture.requestedMip);
+
+			texture.lastRequestFrame = m_FrameCount;
+		}
+
+		m_Stats.residentBytes += GetLevelBytes(texture, texture.residentMip);
+		m_Stats.fullBytes += GetLevelBytes(texture, 0);
+	}
+}
+
+void TextureStreamer::RecordFeedback(vk::CommandBuffer commandBuffer, const Matrix4f& viewProjection, vk::Extent2D extent)
+{
+	if (m_ObjectCount == 0)
+		return;
+
+	commandBuffer.fillBuffer(m_FeedbackBuffers[m_FrameIndex].buffer, 0, sizeof(uint32) * m_MaxTextures, 0, GetDispatch());
+
+	vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, 
+								  vk::DependencyFlags(), { clearBarrier }, nullptr, nullptr, GetDispatch());
+
+	FeedbackPushConstants pushConstants = {};
+	pushConstants.viewProjection = viewProjection;
+	pushConstants.viewportHeight = (float)extent.height;
+	pushConstants.objectCount = m_ObjectCount;
+	pushConstants.textureCount = m_TextureCount;
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipeline.pipeline, GetDispatch());
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_Pipeline.layout, 0, { GetDescriptorBuilder().Build() }, nullptr, GetDispatch());
+	commandBuffer.pushConstants(m_Pipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FeedbackPushConstants), &pushConstants, GetDispatch());
+	commandBuffer.dispatch((m_ObjectCount + FEEDBACK_GROUP_SIZE - 1) / FEEDBACK_GROUP_SIZE, 1, 1, GetDispatch());
+}
+
+const Texture* TextureStreamer::GetTexture(StreamedTextureId id) const
+{
+	assert(id < m_TextureCount);
+
+	return m_Textures[id].loaded ? &m_Textures[id].texture : nullptr;
+}
+
+uint32 TextureStreamer::GetBindlessIndex(StreamedTextureId id) const
+{
+	assert(id < m_TextureCount);
+
+	return m_Textures[id].loaded ? m_Textures[id].bindlessIndex : BINDLESS_INVALID_INDEX;
+}
+
+void TextureStreamer::PrintStats() const
+{
+	printf("Texture streaming: %u textures (%u loading), %.2f of %.2f MB resident, %llu levels streamed in, %llu evicted, %llu under memory pressure\n", 
+		   m_Stats.textureCount, m_Stats.loadingCount, 
+		   m_Stats.residentBytes / (1024.0 * 1024.0), m_Stats.fullBytes / (1024.0 * 1024.0), 
+		   (unsigned long long)m_Stats.levelsStreamedIn, (unsigned long long)m_Stats.levelsEvicted, 
+		   (unsigned long long)m_Stats.pressureEvictions);
+}
\ No newline at end of file
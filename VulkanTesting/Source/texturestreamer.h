@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "buffer.h"
+#include "pipeline.h"
+#include "descriptor.h"
+#include "texture.h"
+#include "ktx2.h"
+#include "jobsystem.h"
+#include "mathlib.h"
+
+class Renderer;
+
+typedef uint32 StreamedTextureId;
+
+const StreamedTextureId INVALID_STREAMED_TEXTURE = 0xFFFFFFFF;
+
+// Levels up to this size are loaded with the texture and never evicted
+const uint32 STREAMING_RESIDENT_SIZE = 64;
+
+// Upload bandwidth spent on streaming in levels per frame, a single level can go over it
+const vk::DeviceSize STREAMING_UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
+// Frames a level has to go unrequested before it is dropped, so camera jitter doesn't thrash
+const uint32 STREAMING_EVICTION_DELAY = 60;
+
+// Matches the StreamingObject struct in mipfeedback.comp (std430)
+struct StreamingObject
+{
+	Vector3f center;
+	float radius;
+
+	StreamedTextureId texture;
+	uint32 padding[3];
+};
+
+struct TextureStreamerStats
+{
+	uint32 textureCount;
+	uint32 loadingCount;
+
+	// Sizes of the levels as stored, which is what the device memory roughly comes down to
+	vk::DeviceSize residentBytes;
+	vk::DeviceSize fullBytes;
+
+	uint64 levelsStreamedIn;
+	uint64 levelsEvicted;
+	uint64 pressureEvictions;
+};
+
+// Mip streaming for KTX2 textures. A texture starts out with only the levels up to
+// STREAMING_RESIDENT_SIZE, the file is read and transcoded on the job system. Every frame a compute
+// pass projects the bounding spheres of the objects using streamed textures and writes the largest
+// on screen size each texture is seen at into a host visible buffer. Once the frame is done that
+// becomes the requested level, higher levels are streamed in through the staging ring a bit per frame
+// and the ones nobody asked for in a while are dropped again. Changing the resident levels means a new
+// image with the levels that stay copied over on the GPU, the old one is destroyed once no frame in
+// flight uses it. When device memory gets tight the memory budget asks the streamer to drop levels of
+// the textures that were requested least recently.
+// The whole file stays in CPU memory, the streaming is about device memory and upload bandwidth
+class TextureStreamer
+{
+private:
+	struct StreamedTexture
+	{
+		String filename;
+
+		// Written by the loading job, only touched by the render thread once the counter is done
+		JobCounter loadCounter;
+		bool loadFailed;
+		Ktx2Image image;
+
+		bool loaded;
+		Texture texture;
+		uint32 bindlessIndex;
+
+		// The texture holds levels residentMip and up, minResidentMip and up never go away
+		uint32 residentMip;
+		uint32 minResidentMip;
+		uint32 requestedMip;
+		uint32 lastRequestFrame;
+
+		// Set by the memory budget, drops to the minimum with the next Update
+		bool evict;
+	};
+
+	Renderer* m_Renderer;
+	uint32 m_MaxTextures;
+
+	// Fixed size so the loading jobs can hold on to their entry
+	std::vector<StreamedTexture> m_Textures;
+	uint32 m_TextureCount;
+
+	uint32 m_MaxObjects;
+	uint32 m_ObjectCount;
+	Buffer m_ObjectBuffer;
+
+	// One per frame in flight, read back once the frame that wrote it is done
+	std::vector<Buffer> m_FeedbackBuffers;
+
+	// Textures replaced in a frame, destroyed once that frame is no longer in flight
+	std::vector<std::vector<Texture>> m_RetiredTextures;
+
+	vk::ShaderModule m_ShaderModule;
+	Pipeline m_Pipeline;
+
+	uint32 m_HeapIndex;
+	uint32 m_EvictionCallback;
+
+	uint32 m_FrameIndex;
+	uint32 m_FrameCount;
+
+	TextureStreamerStats m_Stats;
+private:
+	DescriptorBuilder GetDescriptorBuilder();
+
+	vk::DeviceSize GetLevelBytes(const StreamedTexture& texture, uint32 firstMip) const;
+	uint32 GetRequestedMip(const StreamedTexture& texture, uint32 footprint) const;
+
+	void FinishLoad(vk::CommandBuffer commandBuffer, StreamedTexture& texture);
+	void SetResidentMip(vk::CommandBuffer commandBuffer, StreamedTexture& texture, uint32 residentMip);
+	vk::DeviceSize Evict(uint32 heapIndex, vk::DeviceSize bytes);
+public:
+	TextureStreamer(Renderer* renderer, uint32 maxTextures, uint32 maxObjects);
+	~TextureStreamer();
+
+	// Starts loading on the job system, the texture shows up once Update sees the job done
+	StreamedTextureId Load(const String& filename);
+
+	// Objects live in a host visible buffer, only update them when no frame using them is in flight
+	void SetObjects(const StreamingObject* objects, uint32 count);
+
+	// Reads the feedback of the frame that last used this frame index, finishes loads and records the
+	// level changes. Call after the renderer's BeginFrame and before recording anything sampling the
+	// textures, the views and bindless indices change here
+	void Update(vk::CommandBuffer commandBuffer);
+
+	// Records the feedback dispatch, must be called outside of a render pass. The feedback buffer is
+	// cleared with a transfer, written by the compute shader and read on the host, see main for the
+	// render graph pass that synchronizes it
+	void RecordFeedback(vk::CommandBuffer commandBuffer, const Matrix4f& viewProjection, vk::Extent2D extent);
+
+	vk::Buffer GetFeedbackBuffer() const { return m_FeedbackBuffers[m_FrameIndex].buffer; }
+
+	// Null until the texture is loaded, the pointer is only valid until the next Update
+	const Texture* GetTexture(StreamedTextureId id) const;
+
+	// BINDLESS_INVALID_INDEX until the texture is loaded or without bindless
+	uint32 GetBindlessIndex(StreamedTextureId id) const;
+
+	const TextureStreamerStats& GetStats() const { return m_Stats; }
+	void PrintStats() const;
+};
\ No newline at end of file
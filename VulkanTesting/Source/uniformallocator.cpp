@@ -0,0 +1,95 @@
+#include "uniformallocator.h"
+
+#include "renderer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const vk::ShaderStageFlags UNIFORM_STAGES = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+UniformAllocator::UniformAllocator(Renderer* renderer, vk::DeviceSize bufferSize, uint32 framesInFlight)
+	: m_Renderer(renderer), m_FrameIndex(0), m_BufferIndex(0), m_Offset(0)
+{
+	m_Alignment = renderer->GetCapabilities().properties.limits.minUniformBufferOffsetAlignment;
+
+	// The descriptor covers UNIFORM_BLOCK_RANGE bytes from every offset, a buffer has to hold at least that
+	m_BufferSize = std::max(bufferSize, (vk::DeviceSize)UNIFORM_BLOCK_RANGE);
+
+	m_Buffers.resize(framesInFlight);
+	for (std::vector<Buffer>& buffers : m_Buffers)
+		buffers.push_back(CreateUniformBuffer());
+
+	vk::DescriptorSetLayoutBinding binding(0, vk::DescriptorType::eUniformBufferDynamic, 1, UNIFORM_STAGES, nullptr);
+
+	m_Layout = renderer->GetDescriptorLayoutCache()->GetLayout({ binding });
+}
+
+UniformAllocator::~UniformAllocator()
+{
+	for (std::vector<Buffer>& buffers : m_Buffers)
+	{
+		for (Buffer& buffer : buffers)
+			DestroyBuffer(m_Renderer, buffer);
+	}
+}
+
+Buffer UniformAllocator::CreateUniformBuffer()
+{
+	return CreateBuffer(m_Renderer, m_BufferSize, 
+						vk::BufferUsageFlagBits::eUniformBuffer, 
+						vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+}
+
+vk::DescriptorSet UniformAllocator::BuildSet(const Buffer& buffer)
+{
+	// The descriptor allocator is reset every frame, so the sets are built again every frame
+	DescriptorBuilder builder(m_Renderer->GetDescriptorLayoutCache(), m_Renderer->GetDescriptorAllocator());
+	builder.BindBuffer(0, vk::DescriptorType::eUniformBufferDynamic, UNIFORM_STAGES, vk::DescriptorBufferInfo(buffer.buffer, 0, UNIFORM_BLOCK_RANGE));
+
+	return builder.Build();
+}
+
+void UniformAllocator::BeginFrame(uint32 frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	m_BufferIndex = 0;
+	m_Offset = 0;
+
+	m_Sets.clear();
+	m_Sets.push_back(BuildSet(m_Buffers[frameIndex][0]));
+}
+
+UniformAllocation UniformAllocator::Allocate(uint32 size)
+{
+	if (size > UNIFORM_BLOCK_RANGE)
+		throw std::runtime_error("uniform allocation is larger than UNIFORM_BLOCK_RANGE!");
+
+	vk::DeviceSize offset = (m_Offset + m_Alignment - 1) & ~(m_Alignment - 1);
+
+	// The descriptor always covers UNIFORM_BLOCK_RANGE bytes, so that much has to fit after the offset
+	if (offset + UNIFORM_BLOCK_RANGE > m_BufferSize)
+	{
+		std::vector<Buffer>& buffers = m_Buffers[m_FrameIndex];
+
+		m_BufferIndex++;
+		if (m_BufferIndex == buffers.size())
+			buffers.push_back(CreateUniformBuffer());
+
+		m_Sets.push_back(BuildSet(buffers[m_BufferIndex]));
+		offset = 0;
+	}
+
+	m_Offset = offset + size;
+
+	UniformAllocation result = {};
+	result.data = (byte*)m_Buffers[m_FrameIndex][m_BufferIndex].mapped + offset;
+	result.offset = (uint32)offset;
+	result.set = m_Sets[m_BufferIndex];
+
+	return result;
+}
+
+void UniformAllocator::Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32 setIndex, const UniformAllocation& allocation)
+{
+	commandBuffer.bindDescriptorSets(bindPoint, layout, setIndex, { allocation.set }, { allocation.offset }, GetDispatch());
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "types.h"
+#include "buffer.h"
+#include "pipeline.h"
+#include "dispatch.h"
+
+class Renderer;
+
+// Largest block a single allocation can hold, it is the range of the dynamic uniform descriptor
+const uint32 UNIFORM_BLOCK_RANGE = 256;
+
+// Vulkan only guarantees 128 bytes of push constants
+const uint32 MAX_PUSH_CONSTANT_SIZE = 128;
+
+struct UniformAllocation
+{
+	void* data;
+
+	// Dynamic offset to pass to bindDescriptorSets, into the buffer behind set
+	uint32 offset;
+	vk::DescriptorSet set;
+};
+
+// Linear per-frame allocator for uniform data. Every frame in flight has one persistently mapped
+// buffer, allocating bumps an offset aligned to minUniformBufferOffsetAlignment, and the whole
+// buffer is reused once the frame comes around again. A single UNIFORM_BUFFER_DYNAMIC descriptor
+// covers the buffer so binding per-object data is just a different dynamic offset.
+//
+// A frame that fills its buffer chains another one of the same size, with a descriptor set of its
+// own. Chained buffers are kept for that frame index, so a frame only pays for them the first time
+class UniformAllocator
+{
+private:
+	Renderer* m_Renderer;
+
+	// Every frame in flight has at least one
+	std::vector<std::vector<Buffer>> m_Buffers;
+	vk::DeviceSize m_BufferSize;
+	vk::DeviceSize m_Alignment;
+
+	uint32 m_FrameIndex;
+	uint32 m_BufferIndex;
+	vk::DeviceSize m_Offset;
+
+	vk::DescriptorSetLayout m_Layout;
+
+	// One per buffer used so far this frame
+	std::vector<vk::DescriptorSet> m_Sets;
+private:
+	Buffer CreateUniformBuffer();
+	vk::DescriptorSet BuildSet(const Buffer& buffer);
+public:
+	UniformAllocator(Renderer* renderer, vk::DeviceSize bufferSize, uint32 framesInFlight);
+	~UniformAllocator();
+
+	void BeginFrame(uint32 frameIndex);
+
+	// Throws for sizes above UNIFORM_BLOCK_RANGE, they can't be bound through the descriptor
+	UniformAllocation Allocate(uint32 size);
+
+	template<typename T>
+	UniformAllocation Push(const T& value)
+	{
+		static_assert(sizeof(T) <= UNIFORM_BLOCK_RANGE, "Uniform block is larger than UNIFORM_BLOCK_RANGE");
+
+		UniformAllocation allocation = Allocate(sizeof(T));
+		memcpy(allocation.data, &value, sizeof(T));
+		return allocation;
+	}
+
+	// Binds the buffer of an allocation at setIndex with its offset
+	void Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32 setIndex, const UniformAllocation& allocation);
+
+	vk::DescriptorSetLayout GetLayout() const { return m_Layout; }
+	vk::DeviceSize GetUsedBytes() const { return m_BufferIndex * m_BufferSize + m_Offset; }
+};
+
+// Small per-draw data goes through push constants instead, no allocation and no descriptor at all
+template<typename T>
+inline void PushConstants(vk::CommandBuffer commandBuffer, const Pipeline& pipeline, vk::ShaderStageFlags stages, const T& value, uint32 offset = 0)
+{
+	static_assert(sizeof(T) <= MAX_PUSH_CONSTANT_SIZE, "Push constant block is larger than the guaranteed minimum");
+
+	commandBuffer.pushConstants(pipeline.layout, stages, offset, sizeof(T), &value, GetDispatch());
+}
\ No newline at end of file